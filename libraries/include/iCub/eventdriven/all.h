@@ -1,10 +1,24 @@
 #include "iCub/eventdriven/vtsHelper.h"
 #include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vSort.h"
+#include "iCub/eventdriven/vCodecLayout.h"
+#include "iCub/eventdriven/vCodecBatch.h"
+#include "iCub/eventdriven/vCompress.h"
+#include "iCub/eventdriven/vPacket.h"
+#include "iCub/eventdriven/vPacketView.h"
 #include "iCub/eventdriven/vBottle.h"
 #include "iCub/eventdriven/vFilters.h"
 #include "iCub/eventdriven/vWindow_basic.h"
 #include "iCub/eventdriven/vWindow_adv.h"
+#include "iCub/eventdriven/vFlatSurface.h"
+#include "iCub/eventdriven/vSurfaceBank.h"
 #include "iCub/eventdriven/vSurfaceHandlerTh.h"
 #include "iCub/eventdriven/vCollectSend.h"
+#include "iCub/eventdriven/vRing.h"
+#include "iCub/eventdriven/vDropPolicy.h"
+#include "iCub/eventdriven/vShm.h"
+#include "iCub/eventdriven/vStats.h"
+#include "iCub/eventdriven/vTrace.h"
 #include "iCub/eventdriven/vPort.h"
+#include "iCub/eventdriven/vHub.h"
 
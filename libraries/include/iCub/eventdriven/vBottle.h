@@ -23,6 +23,8 @@
 #include <yarp/os/Log.h>
 #include <yarp/os/LogStream.h>
 #include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vCodecBatch.h"
+#include "iCub/eventdriven/vTrace.h"
 #include <iostream>
 
 namespace ev {
@@ -41,19 +43,45 @@ public:
     /// \brief add a single event to the vBottle
     void addEvent(event<> e) {
 
-        //first append a searchable string
-        //yarp::os::Bottle::addString(e.getType());
-        yarp::os::Bottle * b = yarp::os::Bottle::find(e->getType()).asList();
+        //add the coded event to the end of the list of its event-type
+        e->encode(*getGroup(e->getTypeID()));
 
-        if(!b) {
-            yarp::os::Bottle::addString(e->getType());
-            b = &(yarp::os::Bottle::addList());
+    }
+
+    /// \brief add a vQueue of events to the vBottle. Each run of events of
+    /// the same event-type is encoded into a single block of integers and
+    /// appended to the list of that event-type, which is found only once.
+    void addEvents(const vQueue &q)
+    {
+        size_t i = 0;
+        while(i < q.size()) {
+
+            //find the run of events with the same event-type
+            int id = q[i]->getTypeID();
+            size_t j = i + 1;
+            while(j < q.size() && q[j]->getTypeID() == id) j++;
+
+            std::vector<std::int32_t> &block = encodeBuffer(packetSize(id) * (j - i));
+            unsigned int pos = 0;
+            for(size_t k = i; k < j; k++)
+                q[k]->encode(block, pos);
+            appendBlock(getGroup(id), block.data(), pos);
+
+            i = j;
         }
+    }
 
-        //add the coded event to the end of the bottle
-        e->encode(*b);
-        //b->append(e.encode());
+    /// \brief add a vector of events of type T to the vBottle. The events
+    /// are encoded into a single block of integers (using the block encoder
+    /// for AddressEvents) and appended to the list of the event-type.
+    template<class T> void addEvents(const std::vector<T> &events)
+    {
+        if(events.empty()) return;
 
+        std::vector<std::int32_t> &block = encodeBuffer(packetSize(T::id) * events.size());
+        unsigned int pos = 0;
+        encodeEvents(events.data(), events.size(), block, pos);
+        appendBlock(getGroup(T::id), block.data(), pos);
     }
     /// \brief add all the contents of a vBottle to the current vBottle
     void append(vBottle &eb)
@@ -78,13 +106,14 @@ public:
             }
 
             //check to see if we want to append this event type
-            event<> e = createEvent(tagname);
-            if(!e) {
+            if(tagname == trace_tag) continue;
+            int id = eventTypeID(tagname);
+            if(id < 0) {
                 std::cerr << "Warning: could not get bottle type during vBottle::"
                              "append<>(). Check vBottle integrity." << std::endl;
                 continue;
             }
-            if(!std::dynamic_pointer_cast<T>(e)) continue;
+            if(!isEventType<T>(id)) continue;
 
 
             //we want to append these events so get the data from bb
@@ -96,14 +125,7 @@ public:
             }
 
             //get the correct bottle to append to (or create a new one)
-            yarp::os::Bottle *b_to = yarp::os::Bottle::find(tagname).asList();
-            if(!b_to) {
-                yarp::os::Bottle::addString(tagname);
-                b_to = &(yarp::os::Bottle::addList());
-            }
-
-            //and do it
-            b_to->append(*b_from);
+            getGroup(id)->append(*b_from);
         }
 
     }
@@ -125,16 +147,24 @@ public:
         //the bottle is stored as TAG (EVENTS) TAG (EVENTS)
         for(size_t i = 0; i < Bottle::size(); i+=2) {
 
-            //so for each TAG we create an event of that type
-            event<> e = createEvent(Bottle::get(i).asString());
-            if(!e) {
+            //so for each TAG we find the event-type
+            const std::string tagname = Bottle::get(i).asString();
+            if(tagname == trace_tag) continue;
+            int id = eventTypeID(tagname);
+            if(id < 0) {
                 yError() << "Warning: could not get bottle type during vBottle::"
                              "get<>(). Check vBottle integrity.";
                 continue;
             }
 
-            //and if e is of type T we can continue to get the events
-            if(!std::dynamic_pointer_cast<T>(e)) {
+            //and if it is of type T we create an event to decode with
+            if(!isEventType<T>(id)) {
+                continue;
+            }
+            event<> e = createEvent(id);
+            if(!e) {
+                yError() << "Warning: could not get bottle type during vBottle::"
+                             "get<>(). Check vBottle integrity.";
                 continue;
             }
 
@@ -168,6 +198,31 @@ public:
         return q;
     }
 
+    /// \brief send a trace (see ev::vTrace) after the events. A vBottle
+    /// holds a single trace.
+    void addTrace(const vTrace &trace)
+    {
+        for(size_t i = 0; i + 1 < Bottle::size(); i += 2) {
+            if(Bottle::get(i).asString() == trace_tag) {
+                Bottle::get(i+1) = yarp::os::Value(trace.toString());
+                return;
+            }
+        }
+        yarp::os::Bottle::addString(trace_tag);
+        yarp::os::Bottle::addString(trace.toString());
+    }
+
+    /// \brief get the trace sent with the events. Returns false if the
+    /// vBottle is not traced.
+    bool getTrace(vTrace &trace)
+    {
+        trace.clear();
+        for(size_t i = 0; i + 1 < Bottle::size(); i += 2)
+            if(Bottle::get(i).asString() == trace_tag)
+                return trace.fromString(Bottle::get(i+1).asString());
+        return false;
+    }
+
     /// \brief decode all events into a vQueue
     vQueue getAll() {
         vQueue q = this->get<vEvent>(); //all events are of type vEvent
@@ -215,6 +270,56 @@ public:
 
 private:
 
+    //position of the tag of each event-type in the bottle (-1 if unknown).
+    //Always checked before use as the bottle can be modified through Bottle.
+    std::vector<int> group_index;
+
+    /// \brief get the list of events of an event-type, adding the tag and
+    /// list if not yet in the bottle
+    yarp::os::Bottle * getGroup(int id) {
+
+        const std::string &tag = eventTag(id);
+        if(id >= (int)group_index.size())
+            group_index.resize(id + 1, -1);
+
+        int i = group_index[id];
+        if(i >= 0 && i + 1 < (int)Bottle::size() && Bottle::get(i+1).isList()) {
+            const std::string tagname = Bottle::get(i).asString();
+            if(tagname == tag)
+                return Bottle::get(i+1).asList();
+        }
+
+        //search the bottle the first time the event-type is used
+        for(i = 0; i + 1 < (int)Bottle::size(); i += 2) {
+            const std::string tagname = Bottle::get(i).asString();
+            if(tagname == tag) {
+                group_index[id] = i;
+                return Bottle::get(i+1).asList();
+            }
+        }
+
+        group_index[id] = Bottle::size();
+        yarp::os::Bottle::addString(tag);
+        return &(yarp::os::Bottle::addList());
+    }
+
+    /// \brief a buffer of at least n integers, kept between calls
+    static std::vector<std::int32_t> & encodeBuffer(size_t n)
+    {
+        static thread_local std::vector<std::int32_t> block;
+        if(block.size() < n)
+            block.resize(n);
+        return block;
+    }
+
+    /// \brief append n coded integers to the list of an event-type
+    static void appendBlock(yarp::os::Bottle *b, const std::int32_t *data,
+                            size_t n)
+    {
+        for(size_t i = 0; i < n; i++)
+            b->addInt(data[i]);
+    }
+
     //you cannot use any of the following functions
     void add();
     void addDict();
@@ -316,11 +421,7 @@ public:
         header1[3] = eventtype.size();  //set the string length
         header2 = eventtype;            //set the string itself
 
-        //get the elementsize THIS COULD BE MORE ELEGENT!!
-        yarp::os::Bottle temp;
-        event<> v = ev::createEvent(eventtype);
-        v->encode(temp);
-        elementINTS = temp.size();
+        elementINTS = packetSize(eventtype);
         elementBYTES = sizeof(std::int32_t) * elementINTS;
 
     }
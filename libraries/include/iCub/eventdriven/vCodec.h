@@ -26,6 +26,8 @@
 #include <math.h>
 #include <vector>
 #include <iostream>
+#include "iCub/eventdriven/vPool.h"
+#include "iCub/eventdriven/vtsHelper.h"
 
 namespace ev {
 
@@ -42,9 +44,10 @@ template<typename V1, typename V2> inline event<V1> as_event(event<V2> orig_even
 template<typename V1, typename V2> inline event<V1> is_event(event<V2> orig_event) {
     return std::static_pointer_cast<V1>(orig_event);
 }
-/// \brief allocate memory for, and instantiate, a new event
+/// \brief allocate memory for, and instantiate, a new event. Memory is
+/// recycled through the event pool.
 template<typename V> event<V> inline make_event(void) {
-    return std::make_shared<V>();
+    return std::allocate_shared<V>(poolAllocator<V>());
 }
 /// \brief a fast event-type conversion to access event data. Does no checking
 /// that the event actually exists.
@@ -54,7 +57,7 @@ template<typename V> inline V* read_as(const event<> &orig_event) {
 /// \brief make a new event, copying from an existent event. Can be used to
 /// upgrade the event-type.
 template<typename V1, typename V2> event<V1> make_event(event<V2> orig_event) {
-    return std::make_shared<V1>(*(orig_event.get()));
+    return std::allocate_shared<V1>(poolAllocator<V1>(), *(orig_event.get()));
 }
 /// \brief vQueue is a wrapper for a deque of "event"
 using vQueue = std::deque< event<vEvent> >;
@@ -68,6 +71,48 @@ event<> createEvent(const std::string &type);
 /// \brief get the coded packet size of an event
 unsigned int packetSize(const std::string &type);
 
+/// \brief the maximum number of event-types that can be registered
+const int max_event_types = 64;
+
+/// \brief add an event-type to the registry. The tag is the string used on
+/// the wire, size the number of coded integers per event, create allocates a
+/// new event of the type (or nullptr if not instantiable) and parent is the
+/// ID of the event-type it inherits from. Returns the ID of the event-type
+/// or -1 if the registry is full.
+int registerEventType(const std::string &tag, unsigned int size,
+                      event<> (*create)(), int parent);
+
+/// \brief the integer ID of an event-type given its tag (-1 if unknown)
+int eventTypeID(const std::string &tag);
+
+/// \brief the tag of an event-type given its ID
+const std::string &eventTag(int id);
+
+/// \brief create an "event" based on the ID of its event-type
+event<> createEvent(int id);
+
+/// \brief get the coded packet size of an event given its ID
+unsigned int packetSize(int id);
+
+/// \brief true if event-type id is, or inherits from, event-type base
+bool isEventType(int id, int base);
+
+/// \brief true if event-type id is, or inherits from, T
+template<typename T> inline bool isEventType(int id) {
+    return isEventType(id, T::id);
+}
+
+/// \brief allocator for an event-type to be given to registerEventType
+template<typename V> event<> createEventOf(void) {
+    return make_event<V>();
+}
+
+/// \brief register a custom event-type V. V should have a static tag and
+/// define its ID as e.g. const int V::id = registerEventType<V>(3, AE::id);
+template<typename V> inline int registerEventType(unsigned int size, int parent) {
+    return registerEventType(V::tag, size, &createEventOf<V>, parent);
+}
+
 /// \brief camera values for stereo set-up
 enum { VLEFT = 0, VRIGHT = 1 } ;
 
@@ -77,7 +122,12 @@ class vEvent
 {
 public:
     static const std::string tag;
+    static constexpr int id = 0;
+#ifdef VLIB_TIMESTAMP_64
+    stamp_t stamp;
+#else
     unsigned int stamp:31;
+#endif
 
     vEvent();
     virtual ~vEvent();
@@ -89,6 +139,7 @@ public:
     virtual void decode(int *&data);
     virtual yarp::os::Property getContent() const;
     virtual std::string getType() const;
+    virtual int getTypeID() const;
     virtual int getChannel() const;
     virtual void setChannel();
 };
@@ -98,6 +149,7 @@ class AddressEvent : public vEvent
 {
 public:
     static const std::string tag;
+    static constexpr int id = 1;
     unsigned int x:10;
     unsigned int y:10;
     unsigned int channel:1;
@@ -115,6 +167,7 @@ public:
     virtual void decode(int *&data);
     virtual yarp::os::Property getContent() const;
     virtual std::string getType() const;
+    virtual int getTypeID() const;
     virtual int getChannel() const;
     virtual void setChannel(const int channel);
 };
@@ -125,6 +178,7 @@ class FlowEvent : public AddressEvent
 {
 public:
     static const std::string tag;
+    static constexpr int id = 2;
     float vx;
     float vy;
 
@@ -139,8 +193,10 @@ public:
     virtual void decode(int *&data);
     virtual yarp::os::Property getContent() const;
     virtual std::string getType() const;
+    virtual int getTypeID() const;
 
     int getDeath() const;
+    int getLifetime() const;
 };
 
 /// \brief an AddressEvent with an ID or class label
@@ -148,6 +204,7 @@ class LabelledAE : public AddressEvent
 {
 public:
     static const std::string tag;
+    static constexpr int id = 3;
     int ID;
 
     LabelledAE();
@@ -161,6 +218,7 @@ public:
     virtual void decode(int *&data);
     virtual yarp::os::Property getContent() const;
     virtual std::string getType() const;
+    virtual int getTypeID() const;
 };
 
 /// \brief a LabelledAE with parameters that define a 2D gaussian
@@ -168,6 +226,7 @@ class GaussianAE : public LabelledAE
 {
 public:
     static const std::string tag;
+    static constexpr int id = 4;
     float sigx;
     float sigy;
     float sigxy;
@@ -183,6 +242,7 @@ public:
     virtual void decode(int *&data);
     virtual yarp::os::Property getContent() const;
     virtual std::string getType() const;
+    virtual int getTypeID() const;
 };
 
 }
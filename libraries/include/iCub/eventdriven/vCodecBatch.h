@@ -0,0 +1,124 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VCODECBATCH__
+#define __VCODECBATCH__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <deque>
+#include <vector>
+#include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vCodecLayout.h"
+
+namespace ev {
+
+/// \brief decode a block of n coded AddressEvents ([timestamp, address]
+/// pairs) into separate field arrays. Uses AVX2/SSE4.1 when available. The
+/// layout is resolved once per call.
+void decodeAEBlock(const std::int32_t *data, size_t n, unsigned int *stamp,
+                   std::uint16_t *x, std::uint16_t *y, std::uint8_t *polarity,
+                   std::uint8_t *channel, std::uint8_t *type,
+                   codecLayout layout = LAYOUT_DEFAULT);
+
+/// \brief decode a block of n coded AddressEvents into AddressEvent objects
+void decodeAEBlock(const std::int32_t *data, size_t n, AddressEvent *out,
+                   codecLayout layout = LAYOUT_DEFAULT);
+
+/// \brief encode n AddressEvents given as separate field arrays into
+/// [timestamp, address] pairs. Uses AVX2/SSE4.1 when available.
+void encodeAEBlock(std::int32_t *data, size_t n, const unsigned int *stamp,
+                   const std::uint16_t *x, const std::uint16_t *y,
+                   const std::uint8_t *polarity, const std::uint8_t *channel,
+                   const std::uint8_t *type, codecLayout layout = LAYOUT_DEFAULT);
+
+/// \brief encode n AddressEvent objects into [timestamp, address] pairs
+void encodeAEBlock(std::int32_t *data, size_t n, const AddressEvent *in,
+                   codecLayout layout = LAYOUT_DEFAULT);
+
+/// \brief encode a deque of AddressEvents into [timestamp, address] pairs
+void encodeAEBlock(std::int32_t *data, const std::deque<AddressEvent> &q,
+                   codecLayout layout = LAYOUT_DEFAULT);
+
+/// \brief the instruction set used by the block codecs ("avx2", "sse4.1"
+/// or "scalar")
+std::string blockCodecISA();
+
+/// \brief force the block codecs to use the scalar implementation (e.g. for
+/// comparison)
+void setBlockCodecScalar(bool scalar = true);
+
+/// \brief decode n events of type T from a block of coded integers. Event
+/// types other than AddressEvent always use the default layout.
+template <class T> inline void decodeEvents(const std::int32_t *data, size_t n, T *out,
+                                            codecLayout = LAYOUT_DEFAULT)
+{
+    int *d = (int *)data;
+    for(size_t i = 0; i < n; i++)
+        out[i].decode(d);
+}
+
+/// \brief decode n AddressEvents using the block decoder
+inline void decodeEvents(const std::int32_t *data, size_t n, AddressEvent *out,
+                         codecLayout layout = LAYOUT_DEFAULT)
+{
+    decodeAEBlock(data, n, out, layout);
+}
+
+/// \brief encode n events of type T into a block of coded integers
+template <class T> inline void encodeEvents(const T *in, size_t n,
+                                            std::vector<std::int32_t> &b,
+                                            unsigned int &pos,
+                                            codecLayout = LAYOUT_DEFAULT)
+{
+    for(size_t i = 0; i < n; i++)
+        in[i].encode(b, pos);
+}
+
+/// \brief encode n AddressEvents using the block encoder
+inline void encodeEvents(const AddressEvent *in, size_t n,
+                         std::vector<std::int32_t> &b, unsigned int &pos,
+                         codecLayout layout = LAYOUT_DEFAULT)
+{
+    encodeAEBlock(b.data() + pos, n, in, layout);
+    pos += 2 * n;
+}
+
+/// \brief encode a deque of events of type T into a block of coded integers
+template <class T> inline void encodeEvents(const std::deque<T> &q,
+                                            std::vector<std::int32_t> &b,
+                                            unsigned int &pos,
+                                            codecLayout = LAYOUT_DEFAULT)
+{
+    for(unsigned int i = 0; i < q.size(); i++)
+        q[i].encode(b, pos);
+}
+
+/// \brief encode a deque of AddressEvents using the block encoder
+inline void encodeEvents(const std::deque<AddressEvent> &q,
+                         std::vector<std::int32_t> &b, unsigned int &pos,
+                         codecLayout layout = LAYOUT_DEFAULT)
+{
+    encodeAEBlock(b.data() + pos, q, layout);
+    pos += 2 * q.size();
+}
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VCODECLAYOUT__
+#define __VCODECLAYOUT__
+
+#include <string>
+#include <cstdint>
+
+namespace ev {
+
+/// \brief the bit layouts of the address word of an AddressEvent.
+/// LAYOUT_DEFAULT refers to the process-wide default (see setDefaultLayout)
+enum codecLayout {
+    LAYOUT_DEFAULT = 0,
+    LAYOUT_128x128 = 1,     //DVS128
+    LAYOUT_304x240_20 = 2,  //ATIS 20 bit
+    LAYOUT_304x240_24 = 3   //ATIS 24 bit
+};
+
+/// \brief DVS128 address layout: [15:c 14-8:x 7-1:(127-y) 0:p]
+struct layout128x128 {
+    static constexpr codecLayout id = LAYOUT_128x128;
+    static constexpr int xshift = 8;
+    static constexpr int xmask = 0x7F;
+    static constexpr int yshift = 1;
+    static constexpr int ymask = 0x7F;
+    static constexpr int cshift = 15;
+    static constexpr int tshift = -1; //type is not coded
+    static constexpr bool yflip = true;
+};
+
+/// \brief ATIS 20 bit address layout: [20:c 18:t 17-10:y 9-1:x 0:p]
+struct layout304x240_20 {
+    static constexpr codecLayout id = LAYOUT_304x240_20;
+    static constexpr int xshift = 1;
+    static constexpr int xmask = 0x1FF;
+    static constexpr int yshift = 10;
+    static constexpr int ymask = 0xFF;
+    static constexpr int cshift = 20;
+    static constexpr int tshift = 18;
+    static constexpr bool yflip = false;
+};
+
+/// \brief ATIS 24 bit address layout: [23:t 22:c 19-12:y 9-1:x 0:p]
+struct layout304x240_24 {
+    static constexpr codecLayout id = LAYOUT_304x240_24;
+    static constexpr int xshift = 1;
+    static constexpr int xmask = 0x1FF;
+    static constexpr int yshift = 12;
+    static constexpr int ymask = 0xFF;
+    static constexpr int cshift = 22;
+    static constexpr int tshift = 23;
+    static constexpr bool yflip = false;
+};
+
+/// \brief unpack an address word into the fields of an event using layout L
+template <class L, class E> inline void decodeAddress(std::int32_t data, E &v)
+{
+    unsigned int a = data;
+    v.polarity = a & 0x01;
+    v.x = (a >> L::xshift) & L::xmask;
+    v.y = L::yflip ? L::ymask - ((a >> L::yshift) & L::ymask) :
+                     (a >> L::yshift) & L::ymask;
+    v.channel = (a >> L::cshift) & 0x01;
+    if(L::tshift >= 0)
+        v.type = (a >> (L::tshift & 31)) & 0x01;
+}
+
+/// \brief pack the fields of an event into an address word using layout L
+template <class L, class E> inline std::int32_t encodeAddress(const E &v)
+{
+    unsigned int ey = L::yflip ? L::ymask - v.y : v.y;
+    unsigned int a = ((v.channel & 0x01) << L::cshift) |
+            ((ey & L::ymask) << L::yshift) |
+            ((v.x & L::xmask) << L::xshift) | (v.polarity & 0x01);
+    if(L::tshift >= 0)
+        a |= (v.type & 0x01) << (L::tshift & 31);
+    return a;
+}
+
+/// \brief the layout named as in VLIB_CODEC_TYPE ("CODEC_128x128") or
+/// without the prefix ("128x128"). Returns LAYOUT_DEFAULT if unknown.
+codecLayout layoutFromName(std::string name);
+
+/// \brief the name of a layout (e.g. "304x240_24")
+std::string layoutName(codecLayout layout);
+
+//the process-wide default layout. Use getDefaultLayout/setDefaultLayout.
+extern codecLayout default_layout;
+
+/// \brief the layout used where none is specified. Initialised to the
+/// VLIB_CODEC_TYPE selected at build time.
+inline codecLayout getDefaultLayout()
+{
+    return default_layout;
+}
+
+/// \brief change the process-wide default layout (e.g. from a module
+/// configuration). Should be set before any ports are opened.
+void setDefaultLayout(codecLayout layout);
+
+/// \brief LAYOUT_DEFAULT is replaced by the current default layout
+inline codecLayout resolveLayout(codecLayout layout)
+{
+    return layout == LAYOUT_DEFAULT ? getDefaultLayout() : layout;
+}
+
+}
+
+#endif
@@ -31,11 +31,13 @@ class collectorPort : public yarp::os::RateThread
 {
 private:
 
-    vBottle filler;
+    vQueue filler;
+    vQueue sending;
     yarp::os::BufferedPort<vBottle> sendPort;
     yarp::os::Mutex m;
     yarp::os::Stamp ystamp;
-
+    vTrace trace;
+    vTrace sending_trace;
 
 
 public:
@@ -54,29 +56,48 @@ public:
     void pushevent(event<> v, yarp::os::Stamp y) {
 
         m.lock();
-        filler.addEvent(v);
+        filler.push_back(v);
         ystamp = y;
         m.unlock();
 
     }
 
+    /// \brief send a trace with the next vBottle, adding the time it is
+    /// sent from the port
+    void pushtrace(const vTrace &t) {
+
+        m.lock();
+        trace = t;
+        m.unlock();
+
+    }
+
     /// \brief on each call of the thread, all events that have been added are
     /// sent on the port in a vBottle. If no events have been added, a vBottle
     /// is not sent.
     void run() {
 
-        if(filler.size()) {
-            vBottle &b = sendPort.prepare();
-
-            m.lock();
-            b = filler;
-            filler.clear();
-            sendPort.setEnvelope(ystamp);
+        m.lock();
+        if(filler.empty()) {
             m.unlock();
+            return;
+        }
+        sending.swap(filler);
+        sending_trace.swap(trace);
+        sendPort.setEnvelope(ystamp);
+        m.unlock();
 
-            sendPort.write();
-
+        //the events are encoded outside of the lock
+        vBottle &b = sendPort.prepare();
+        b.clear();
+        b.addEvents(sending);
+        sending.clear();
+        if(!sending_trace.empty()) {
+            sending_trace.add(sendPort.getName());
+            b.addTrace(sending_trace);
+            sending_trace.clear();
         }
+        sendPort.write();
     }
 
 };
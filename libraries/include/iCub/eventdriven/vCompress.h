@@ -0,0 +1,55 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VCOMPRESS__
+#define __VCOMPRESS__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ev {
+
+/// \brief appended to the event-type tag of a packet to signal that the data
+/// is compressed (e.g. "AE~Z"). Readers detect it and decompress.
+extern const std::string compressed_suffix;
+
+/// \brief compress a block of nints coded integers of events that use
+/// event_ints integers each. Timestamps are delta coded as varints, the
+/// address words are bit-packed to the smallest width of the block and any
+/// further integers are copied. If lz is true a fast LZ stage is applied to
+/// the result when it reduces the size. Returns the number of integers
+/// written to out.
+unsigned int compressEvents(const std::int32_t *data, unsigned int nints,
+                            unsigned int event_ints, bool lz,
+                            std::vector<std::int32_t> &out);
+
+/// \brief decompress a block of nwords integers made by compressEvents into
+/// out (resized if needed). nints is set to the number of coded integers.
+/// Returns false if the block is malformed, or was not made for events of
+/// event_ints integers.
+bool decompressEvents(const std::int32_t *data, unsigned int nwords,
+                      unsigned int event_ints, std::vector<std::int32_t> &out,
+                      unsigned int &nints);
+
+/// \brief true if the tag has the compressed_suffix, which is removed
+bool stripCompressedTag(std::string &tag);
+
+}
+
+#endif
@@ -0,0 +1,285 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VDROPPOLICY__
+#define __VDROPPOLICY__
+
+#include <vector>
+#include <atomic>
+#include <string>
+#include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vPacket.h"
+#include "iCub/eventdriven/vPacketView.h"
+#include "iCub/eventdriven/vtsHelper.h"
+
+namespace ev {
+
+//the packet containers of the read ports
+
+/// \brief the timestamp of the i-th event of a packet
+inline stamp_t packetStamp(const vQueue &q, size_t i)
+{
+    return q[i]->stamp;
+}
+
+template <class T> inline stamp_t packetStamp(const std::vector<T> &q, size_t i)
+{
+    return q[i].stamp;
+}
+
+template <class T> inline stamp_t packetStamp(const vPacket<T> &p, size_t i)
+{
+    return p.stamp[i];
+}
+
+inline stamp_t packetStamp(const vPacketView &v, size_t i)
+{
+    return v.stampAt(i);
+}
+
+/// \brief the number of ticks spanned by a packet of events
+template <class C> inline int packetDuration(const C &q)
+{
+    if(q.empty()) return 0;
+    return vtsHelper::elapsed(packetStamp(q, q.size() - 1), packetStamp(q, 0));
+}
+
+/// \brief copy the i-th event of a packet to position j (j <= i)
+inline void packetMove(vQueue &q, size_t i, size_t j)
+{
+    q[j] = q[i];
+}
+
+template <class T> inline void packetMove(std::vector<T> &q, size_t i, size_t j)
+{
+    q[j] = q[i];
+}
+
+template <class T> inline void packetMove(vPacket<T> &p, size_t i, size_t j)
+{
+    p.move(i, j);
+}
+
+inline void packetMove(vPacketView &v, size_t i, size_t j)
+{
+    v.move(i, j);
+}
+
+/// \brief remove the first n events of a packet
+template <class C> inline void packetEraseFront(C &q, size_t n)
+{
+    size_t size = q.size();
+    for(size_t i = n; i < size; i++)
+        packetMove(q, i, i - n);
+    q.resize(n < size ? size - n : 0);
+}
+
+inline void packetEraseFront(vQueue &q, size_t n)
+{
+    q.erase(q.begin(), q.begin() + std::min(n, q.size()));
+}
+
+inline void packetEraseFront(vPacketView &v, size_t n)
+{
+    v.eraseFront(n);
+}
+
+/// \brief keep one in every step events of a packet. phase carries the
+/// fraction of a step between packets. At least one event is kept.
+template <class C> inline void packetDecimate(C &q, double step, double &phase)
+{
+    size_t j = 0, size = q.size();
+    for(size_t i = 0; i < size; i++) {
+        phase += 1.0;
+        if(phase < step) continue;
+        phase -= step;
+        packetMove(q, i, j++);
+    }
+    if(!j && size) {
+        packetMove(q, size - 1, 0);
+        j = 1;
+    }
+    q.resize(j);
+}
+
+/// \brief what a read port discards when the processing falls behind
+enum dropPolicy {
+    DROP_NONE = 0,      //process all data (up to the buffer size / qlimit)
+    DROP_OLDEST = 1,    //keep the latest N packets
+    KEEP_LATEST_T = 2,  //keep the events of the latest T seconds
+    KEEP_LATEST_N = 3,  //keep the latest N events
+    DROP_DECIMATE = 4   //keep a uniform subset at a maximum event rate
+};
+
+static const char * const dropPolicyNames[] =
+    {"none", "oldest", "latest_t", "latest_n", "decimate"};
+
+/// \brief the policy given its name ("none", "oldest", "latest_t",
+/// "latest_n", "decimate"). Returns DROP_NONE if unknown.
+inline dropPolicy dropPolicyFromName(const std::string &name)
+{
+    for(int i = DROP_NONE; i <= DROP_DECIMATE; i++)
+        if(name == dropPolicyNames[i]) return (dropPolicy)i;
+    return DROP_NONE;
+}
+
+/// \brief the name of a policy
+inline std::string dropPolicyName(dropPolicy policy)
+{
+    return dropPolicyNames[policy];
+}
+
+/// \brief discards data waiting to be processed according to a dropPolicy.
+/// It is applied by the read ports to the packets queued at each read, such
+/// that the packet returned is the first kept. The number of packets and
+/// events discarded are counted.
+class vDropPolicy
+{
+private:
+
+    dropPolicy policy;
+    double value;
+    double phase;
+
+    std::atomic<unsigned int> dropped_packets;
+    std::atomic<unsigned int> dropped_events;
+
+public:
+
+    vDropPolicy() : policy(DROP_NONE), value(0), phase(0),
+        dropped_packets(0), dropped_events(0) {}
+
+    /// \brief set the policy and its parameter:
+    /// DROP_OLDEST - the number of packets kept
+    /// KEEP_LATEST_T - the time in seconds kept
+    /// KEEP_LATEST_N - the number of events kept
+    /// DROP_DECIMATE - the maximum event rate in events per second
+    void set(dropPolicy policy, double value)
+    {
+        this->policy = policy;
+        this->value = value;
+        phase = 0;
+        if(value <= 0) this->policy = DROP_NONE;
+    }
+
+    dropPolicy getPolicy() const { return policy; }
+
+    /// \brief the number of whole packets discarded
+    unsigned int queryDroppedPackets() const { return dropped_packets; }
+
+    /// \brief the number of events discarded (including those of whole
+    /// packets)
+    unsigned int queryDroppedEvents() const { return dropped_events; }
+
+    /// \brief apply the policy to the queued packets. B gives access to the
+    /// queue: size() the number of packets, at(i) the i-th oldest packet,
+    /// modify(i) the i-th oldest packet to be modified (e.g. a copy of a
+    /// shared packet), pop() discards the oldest packet and update(i, n, dt)
+    /// is called when the i-th packet previously of n events spanning dt is
+    /// modified.
+    template <class B> void apply(B &queue)
+    {
+        if(policy == DROP_NONE || !queue.size())
+            return;
+        size_t limit = value < 1 ? 1 : (size_t)value;
+
+        switch(policy) {
+
+        case DROP_OLDEST: {
+            while(queue.size() > limit) {
+                dropped_packets++;
+                dropped_events += queue.at(0).size();
+                queue.pop();
+            }
+            break;
+        }
+
+        case KEEP_LATEST_T: {
+            std::int64_t window = value * vtsHelper::vtsscaler;
+            auto &last = queue.at(queue.size() - 1);
+            stamp_t latest = packetStamp(last, last.size() - 1);
+
+            while(queue.size() > 1) {
+                auto &q = queue.at(0);
+                if(vtsHelper::elapsed(latest, packetStamp(q, q.size() - 1)) <= window)
+                    break;
+                dropped_packets++;
+                dropped_events += q.size();
+                queue.pop();
+            }
+
+            auto &q = queue.at(0);
+            size_t n = 0;
+            while(n + 1 < q.size() && vtsHelper::elapsed(latest, packetStamp(q, n)) > window)
+                n++;
+            if(n) {
+                size_t size = q.size();
+                int dt = packetDuration(q);
+                packetEraseFront(queue.modify(0), n);
+                dropped_events += n;
+                queue.update(0, size, dt);
+            }
+            break;
+        }
+
+        case KEEP_LATEST_N: {
+            size_t total = 0;
+            for(size_t i = 0; i < queue.size(); i++)
+                total += queue.at(i).size();
+
+            while(queue.size() > 1 && total - queue.at(0).size() >= limit) {
+                total -= queue.at(0).size();
+                dropped_packets++;
+                dropped_events += queue.at(0).size();
+                queue.pop();
+            }
+
+            if(total > limit) {
+                auto &q = queue.modify(0);
+                size_t size = q.size();
+                int dt = packetDuration(q);
+                packetEraseFront(q, total - limit);
+                dropped_events += size - q.size();
+                queue.update(0, size, dt);
+            }
+            break;
+        }
+
+        case DROP_DECIMATE: {
+            auto &q = queue.at(0);
+            int dt = packetDuration(q);
+            if(dt <= 0) break;
+            double step = q.size() * vtsHelper::vtsscaler / (dt * value);
+            if(step <= 1.0) break;
+            auto &m = queue.modify(0);
+            size_t size = m.size();
+            packetDecimate(m, step, phase);
+            dropped_events += size - m.size();
+            queue.update(0, size, dt);
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+};
+
+}
+
+#endif
@@ -20,6 +20,8 @@
 #define __VFILTER__
 
 #include <yarp/sig/Image.h>
+#include "iCub/eventdriven/vPacket.h"
+#include "iCub/eventdriven/vtsHelper.h"
 
 namespace ev {
 
@@ -60,7 +62,7 @@ public:
 
     /// \brief classifies the event as noise or signal
     /// \returns false if the event is noise
-    bool check(int x, int y, int p, int c, int ts)
+    bool check(int x, int y, int p, int c, stamp_t ts)
     {
         if(!Ssize) return false;
 
@@ -88,12 +90,19 @@ public:
         (*active)(x, y) = ts;
         for(int xi = x - Ssize; xi <= x + Ssize; xi++) {
             for(int yi = y - Ssize; yi <= y + Ssize; yi++) {
+#ifdef VLIB_TIMESTAMP_64
+                //the lower 32 bits of the stamps are stored, their
+                //difference is exact for any recent event
+                unsigned int dt = (unsigned int)ts - (unsigned int)(*active)(xi, yi);
+                if(dt && dt < (unsigned int)Tsize) {
+#else
                 int dt = ts - (*active)(xi, yi);
                 if(dt < 0) {
                     dt += vtsHelper::max_stamp;
                     (*active)(xi, yi) -= vtsHelper::max_stamp;
                 }
                 if(dt && dt < Tsize) {
+#endif
                     add = true;
                     break;
                 }
@@ -103,6 +112,22 @@ public:
         return add;
     }
 
+    /// \brief removes the noise events from a vPacket. The packet is
+    /// compacted in place keeping the temporal order of the signal events.
+    /// \returns the number of events remaining
+    template <class T> size_t filter(vPacket<T> &p)
+    {
+        size_t j = 0;
+        for(size_t i = 0; i < p.size(); i++) {
+            if(!check(p.x[i], p.y[i], p.polarity[i], p.channel[i], p.stamp[i]))
+                continue;
+            if(i != j) p.move(i, j);
+            j++;
+        }
+        p.resize(j);
+        return j;
+    }
+
 };
 
 
@@ -0,0 +1,294 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VFLATSURFACE__
+#define __VFLATSURFACE__
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vPacket.h"
+#include "iCub/eventdriven/vtsHelper.h"
+
+namespace ev {
+
+/// \brief how a flatSurface removes events
+enum surfacePolicy {
+    SURFACE_TEMPORAL, ///< remove events older than a duration (as temporalSurface)
+    SURFACE_FIXED,    ///< keep a fixed number of events (as fixedSurface)
+    SURFACE_LIFETIME  ///< remove events older than the lifetime given by
+                      ///< their velocity (as lifetimeSurface)
+};
+
+/// \brief how a flatSurface lays out its pixels in memory
+enum surfaceLayout {
+    SURFACE_ROWS,  ///< row by row
+    SURFACE_TILED  ///< in 8x8 tiles, row by row within a tile, such that a
+                   ///< small neighbourhood spans few pages and cache lines
+};
+
+/// \brief an event as stored by a flatSurface. vx and vy are 0 for events
+/// without flow.
+struct surfaceEvent {
+    stamp_t stamp;
+    std::int16_t x;
+    std::int16_t y;
+    std::uint8_t polarity;
+    std::uint8_t channel;
+    float vx;
+    float vy;
+};
+
+/// \brief a view of a contiguous range of surfaceEvents, valid until the
+/// next query of the surface that returned it
+class surfaceSpan {
+private:
+
+    const surfaceEvent *first;
+    const surfaceEvent *last;
+
+public:
+
+    surfaceSpan(const surfaceEvent *first = 0, const surfaceEvent *last = 0) :
+        first(first), last(last) {}
+
+    const surfaceEvent* begin() const { return first; }
+    const surfaceEvent* end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    const surfaceEvent& operator[](size_t i) const { return first[i]; }
+
+};
+
+/// \brief a spatio-temporal surface without per-event allocation. Events are
+/// copied into a ring buffer in the order they are added, and each pixel of a
+/// single contiguous array holds the stamp of its most recent event and the
+/// position of that event in the ring. An event replaced at its pixel stays
+/// in the ring (and is skipped) until it reaches the back of the ring.
+/// Queries fill a buffer owned by the surface and return a surfaceSpan, such
+/// that no memory is allocated once the buffers have grown to their working
+/// size. Queries visit the pixels of a window in memory order, given the
+/// surfaceLayout.
+class flatSurface {
+
+public:
+
+    /// \brief a pixel of the surface: the stamp of the most recent event at
+    /// the pixel and its sequence number in the ring (0 if the pixel is
+    /// empty)
+    struct pixel {
+        stamp_t stamp;
+        std::uint64_t seq;
+    };
+
+private:
+
+    int width;
+    int height;
+    surfaceLayout layout;
+    int tiles; //tiles per row of tiles
+    std::vector<pixel> pixels;
+
+    //the events, at ring[seq & mask], from the oldest (tail) to the next to
+    //be added (head). The size of the ring is a power of 2 and doubles when
+    //full.
+    std::vector<surfaceEvent> ring;
+    size_t mask;
+    std::uint64_t head;
+    std::uint64_t tail;
+
+    surfacePolicy policy;
+    int value;
+    int count;
+    stamp_t latest;
+    unsigned int sweep;
+
+    //the result of the last query
+    std::vector<surfaceEvent> result;
+
+    size_t offset(int x, int y) const
+    {
+        if(layout == SURFACE_ROWS)
+            return y * width + x;
+        return (((y >> 3) * tiles + (x >> 3)) << 6) | ((y & 7) << 3) | (x & 7);
+    }
+    pixel& at(const surfaceEvent &v) { return pixels[offset(v.x, v.y)]; }
+    bool visible(const pixel &p) const
+    {
+        if(!p.seq) return false;
+        if(policy != SURFACE_LIFETIME) return true;
+        return vtsHelper::elapsed(latest, p.stamp) <=
+                lifetime(ring[p.seq & mask]);
+    }
+    void grow();
+    void popTail();
+    void removeEvents();
+    void removeExpired();
+    void clip(int &xl, int &xh, int &yl, int &yh) const;
+
+    //call f(const pixel &) for each pixel of a (clipped) window, in memory
+    //order
+    template <typename F> void visit(int xl, int xh, int yl, int yh, F f) const
+    {
+        if(layout == SURFACE_ROWS) {
+            for(int y = yl; y <= yh; y++) {
+                const pixel *p = &pixels[y * width];
+                for(int x = xl; x <= xh; x++) f(p[x]);
+            }
+            return;
+        }
+
+        //tile by tile, each row of a tile being contiguous
+        for(int ty = yl >> 3; ty <= yh >> 3; ty++) {
+            int y0 = std::max(yl, ty << 3), y1 = std::min(yh, (ty << 3) + 7);
+            for(int tx = xl >> 3; tx <= xh >> 3; tx++) {
+                int x0 = std::max(xl, tx << 3), x1 = std::min(xh, (tx << 3) + 7);
+                const pixel *p = &pixels[offset(x0, y0)];
+                for(int y = y0; y <= y1; y++, p += 8)
+                    for(int x = 0; x <= x1 - x0; x++) f(p[x]);
+            }
+        }
+    }
+
+public:
+
+    ///
+    /// \brief flatSurface constructor
+    /// \param width retina width
+    /// \param height retina height
+    /// \param policy how events are removed
+    /// \param value the duration (ts) of SURFACE_TEMPORAL or the number of
+    /// events of SURFACE_FIXED
+    /// \param layout how the pixels are laid out in memory
+    ///
+    flatSurface(int width = 128, int height = 128,
+                surfacePolicy policy = SURFACE_TEMPORAL,
+                int value = 2.0 * vtsHelper::vtsscaler,
+                surfaceLayout layout = SURFACE_ROWS);
+
+    /// \brief change how events are removed (see the constructor). A
+    /// duration is limited to ~1/2 of the timestamp range.
+    void setPolicy(surfacePolicy policy, int value = 0);
+
+    /// \brief the lifetime (ts) of an event given its velocity
+    static int lifetime(const surfaceEvent &v);
+
+    ///
+    /// \brief addEvent adds an event, replacing the event at its pixel, and
+    /// removes events given the policy. Events outside the surface are
+    /// ignored.
+    ///
+    void addEvent(stamp_t stamp, int x, int y, int polarity, int channel,
+                  float vx = 0, float vy = 0);
+    void addEvent(const AddressEvent &v);
+    void addEvent(const FlowEvent &v);
+
+    ///
+    /// \brief addPacket adds all events of a vPacket to the surface
+    /// \param p the packet of events to add
+    /// \param channel only add events from this channel (-1 adds all)
+    ///
+    void addPacket(const vPacket<AE> &p, int channel = -1);
+
+    /// \brief remove all events. Allocated memory is kept for re-use.
+    void clear();
+
+    /// \brief the number of pixels holding an event. With SURFACE_LIFETIME
+    /// this can include events that have expired but are not yet removed,
+    /// which are never returned by a query.
+    int getEventCount() const { return count; }
+
+    /// \brief the most recently added event, or 0 if the surface is empty
+    const surfaceEvent* getMostRecent() const
+    {
+        return head == tail ? 0 : &ring[(head - 1) & mask];
+    }
+
+    /// \brief the pixel at x, y
+    const pixel& getPixel(int x, int y) const
+    {
+        return pixels[offset(x, y)];
+    }
+
+    /// \brief the event held by a non-empty pixel
+    const surfaceEvent& payload(const pixel &p) const
+    {
+        return ring[p.seq & mask];
+    }
+
+    /// \brief true if the pixel at x, y holds an event
+    bool isActive(int x, int y) const
+    {
+        return visible(pixels[offset(x, y)]);
+    }
+
+    ///
+    /// \brief forEach calls f(const surfaceEvent &) for each event within
+    /// a spatial window, in memory order, without copying the events
+    ///
+    template <typename F> void forEach(int xl, int xh, int yl, int yh, F f) const
+    {
+        clip(xl, xh, yl, yh);
+        visit(xl, xh, yl, yh, [this, &f](const pixel &p) {
+            if(visible(p)) f(ring[p.seq & mask]);
+        });
+    }
+
+    /// \brief all events on the surface, in memory order
+    surfaceSpan getSurf();
+
+    /// \brief the events within d of the most recent event
+    surfaceSpan getSurf(int d);
+
+    /// \brief the events within d of x, y
+    surfaceSpan getSurf(int x, int y, int d);
+
+    ///
+    /// \brief getSurf returns the events within a spatial window, in memory
+    /// order
+    /// \param xl lower x value of window
+    /// \param xh upper x value of window
+    /// \param yl lower y value of window
+    /// \param yh upper y value of window
+    /// \return a span of the events, valid until the next query
+    ///
+    surfaceSpan getSurf(int xl, int xh, int yl, int yh);
+
+    /// \brief the events that occurred less than dt before the most recent
+    /// event, from the most recent
+    surfaceSpan getSurf_Tlim(int dt);
+    surfaceSpan getSurf_Tlim(int dt, int d);
+    surfaceSpan getSurf_Tlim(int dt, int x, int y, int d);
+    /// \brief the events within a spatial window that occurred less than dt
+    /// before the most recent event, in memory order
+    surfaceSpan getSurf_Tlim(int dt, int xl, int xh, int yl, int yh);
+
+    /// \brief the (at most) c most recent events, from the oldest
+    surfaceSpan getSurf_Clim(int c);
+    surfaceSpan getSurf_Clim(int c, int d);
+    surfaceSpan getSurf_Clim(int c, int x, int y, int d);
+    /// \brief the (at most) c most recent events within a spatial window, from
+    /// the oldest
+    surfaceSpan getSurf_Clim(int c, int xl, int xh, int yl, int yh);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,362 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VHUB__
+#define __VHUB__
+
+#include <list>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <sstream>
+#include "iCub/eventdriven/vPort.h"
+
+namespace ev {
+
+/// \brief a decoded packet shared by the readers of a vHub
+struct vHubPacket {
+    vQueue q;
+    yarp::os::Stamp stamp;
+    int dt;
+    vTrace trace;
+    vHubPacket() : dt(0) {}
+};
+
+/// \brief one consumer of the packets received by a vHub. Each reader queues
+/// the shared packets independently, applies its own vDropPolicy and is
+/// read as a vGenReadPort.
+class vHubReader
+{
+private:
+
+    friend class vHub;
+    typedef std::shared_ptr<const vHubPacket> shared_packet;
+
+    std::deque<shared_packet> queue;
+    shared_packet current; //the packet given by read
+    std::mutex m;
+    std::condition_variable cv;
+    bool released;
+
+    unsigned int buffer_size;
+    unsigned int qlimit;
+    unsigned int delay_nv;
+    std::int64_t delay_t;
+    unsigned int dropped;
+    unsigned int max_lag;
+    vDropPolicy policy;
+
+    //the waiting packets as seen by the vDropPolicy. A packet is copied
+    //before it is modified as the other readers share it.
+    struct backlog {
+        vHubReader &reader;
+        backlog(vHubReader &reader) : reader(reader) {}
+        size_t size() { return reader.queue.size(); }
+        const vQueue& at(size_t i) { return reader.queue[i]->q; }
+        vQueue& modify(size_t i)
+        {
+            std::shared_ptr<vHubPacket> copy =
+                    std::make_shared<vHubPacket>(*reader.queue[i]);
+            reader.queue[i] = copy;
+            return copy->q;
+        }
+        void pop() { reader.popFront(); }
+        void update(size_t i, size_t n, int dt)
+        {
+            std::shared_ptr<vHubPacket> p =
+                    std::const_pointer_cast<vHubPacket>(reader.queue[i]);
+            p->dt = packetDuration(p->q);
+            reader.delay_nv -= n - p->q.size();
+            reader.delay_t -= dt - p->dt;
+        }
+    };
+
+    //m is locked
+    void popFront()
+    {
+        delay_nv -= queue.front()->q.size();
+        delay_t -= queue.front()->dt;
+        queue.pop_front();
+    }
+
+    /// \brief (hub) queue a packet, or drop it if the buffer is full
+    void push(const shared_packet &p)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if(queue.size() >= buffer_size || (qlimit && queue.size() >= qlimit)) {
+            dropped++;
+            return;
+        }
+        queue.push_back(p);
+        delay_nv += p->q.size();
+        delay_t += p->dt;
+        max_lag = std::max(max_lag, (unsigned int)queue.size());
+        cv.notify_one();
+    }
+
+public:
+
+    vHubReader() : released(false), buffer_size(512), qlimit(0), delay_nv(0),
+        delay_t(0), dropped(0), max_lag(0) {}
+
+    /// \brief ask for a pointer to the next packet. Blocks if no data is
+    /// ready. The packet is valid until the next call to read.
+    const vQueue* read(yarp::os::Stamp &yarpstamp)
+    {
+        std::unique_lock<std::mutex> lock(m);
+        current.reset();
+        cv.wait(lock, [this]{ return !queue.empty() || released; });
+        if(queue.empty()) {
+            released = false;
+            return 0;
+        }
+
+        backlog b(*this);
+        policy.apply(b);
+
+        current = queue.front();
+        popFront();
+        yarpstamp = current->stamp;
+        return &current->q;
+    }
+
+    /// \brief the trace of the packet given by the last read, with the time
+    /// it arrived at the hub. Empty if the packet was not traced.
+    const vTrace& queryTrace()
+    {
+        static const vTrace none;
+        return current ? current->trace : none;
+    }
+
+    /// \brief set the maximum number of packets queued. A value of 0 keeps
+    /// packets until the buffer is full.
+    void setQLimit(unsigned int number_of_qs)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        qlimit = number_of_qs;
+    }
+
+    /// \brief set the number of packets the buffer holds (default 512)
+    void setBufferSize(unsigned int number_of_qs)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        buffer_size = number_of_qs;
+    }
+
+    /// \brief set what is discarded when this reader falls behind (see
+    /// vDropPolicy::set for the meaning of value)
+    void setDropPolicy(dropPolicy policy, double value)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        this->policy.set(policy, value);
+    }
+
+    /// \brief unBlocks the blocking call in read
+    void releaseDataLock()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        released = true;
+        cv.notify_all();
+    }
+
+    /// \brief ask for the number of packets waiting to be read
+    unsigned int queryunprocessed()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        return queue.size();
+    }
+
+    /// \brief ask for the number of events waiting to be read
+    unsigned int queryDelayN()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        return delay_nv;
+    }
+
+    /// \brief ask for the time spanned by the packets waiting to be read
+    double queryDelayT()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        return delay_t * vtsHelper::tsscaler;
+    }
+
+    /// \brief ask for the largest number of packets that were waiting
+    unsigned int queryMaxLag()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        return max_lag;
+    }
+
+    /// \brief ask for the number of packets dropped as the buffer was full
+    unsigned int queryDropped()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        return dropped;
+    }
+
+    /// \brief ask for the number of packets discarded by the drop policy
+    unsigned int queryDiscardedPackets()
+    {
+        return policy.queryDroppedPackets();
+    }
+
+    /// \brief ask for the number of events discarded by the drop policy
+    unsigned int queryDiscardedEvents()
+    {
+        return policy.queryDroppedEvents();
+    }
+
+    std::string delayStatString()
+    {
+        std::ostringstream oss;
+        oss << "qs: " << queryunprocessed() << " events: " << queryDelayN() <<
+               " time(s): " << queryDelayT() << " max qs: " << queryMaxLag() <<
+               " dropped: " << queryDropped();
+        return oss.str();
+    }
+
+};
+
+/// \brief receives and decodes a stream of packets once and shares the
+/// packets among any number of vHubReaders in the same process, e.g.
+///
+/// vHub hub;
+/// vHubReader *left = hub.subscribe(), *right = hub.subscribe();
+/// hub.open("/module/vBottle:i");
+///
+/// The packets are immutable and reference counted: a packet is recycled
+/// once no reader holds it. A reader that falls behind drops packets (or
+/// applies its drop policy) without affecting the others.
+class vHub : private vReadPortBase<vQueue, vGenPortInterface>
+{
+    typedef vReadPortBase<vQueue, vGenPortInterface> base;
+
+private:
+
+    std::list<vHubReader> readers;
+    std::mutex readers_mutex;
+
+    //packets sent, reused once the readers release them
+    std::deque< std::shared_ptr<vHubPacket> > recycle;
+    unsigned int recycle_size;
+
+    std::shared_ptr<vHubPacket> nextPacket()
+    {
+        if(recycle.size() && recycle.front().use_count() == 1) {
+            //use_count is a relaxed read: order the reuse of the packet after
+            //the last reads of the readers that released it
+            std::atomic_thread_fence(std::memory_order_acquire);
+            std::shared_ptr<vHubPacket> p = recycle.front();
+            recycle.pop_front();
+            p->q.clear();
+            return p;
+        }
+        return std::make_shared<vHubPacket>();
+    }
+
+public:
+
+    vHub() : recycle_size(64) {}
+
+    /// \brief add a reader. The reader is valid until unsubscribed or the
+    /// hub is destroyed.
+    vHubReader* subscribe()
+    {
+        std::lock_guard<std::mutex> lock(readers_mutex);
+        readers.emplace_back();
+        return &readers.back();
+    }
+
+    /// \brief remove a reader, once no thread is reading from it. Any
+    /// pointer given by its read becomes invalid.
+    void unsubscribe(vHubReader *reader)
+    {
+        std::lock_guard<std::mutex> lock(readers_mutex);
+        for(std::list<vHubReader>::iterator i = readers.begin();
+            i != readers.end(); i++) {
+            if(&(*i) == reader) {
+                readers.erase(i);
+                break;
+            }
+        }
+    }
+
+    /// \brief the number of readers subscribed
+    unsigned int queryReaders()
+    {
+        std::lock_guard<std::mutex> lock(readers_mutex);
+        return readers.size();
+    }
+
+    using base::open;
+    using base::connectFrom;
+    using base::isSharedMemory;
+    using base::registerStats;
+
+    /// \brief close the port and release the readers
+    void close()
+    {
+        base::close();
+        std::lock_guard<std::mutex> lock(readers_mutex);
+        for(std::list<vHubReader>::iterator i = readers.begin();
+            i != readers.end(); i++)
+            i->releaseDataLock();
+    }
+
+    void run()
+    {
+        while(!isStopping()) {
+
+            std::shared_ptr<vHubPacket> p = nextPacket();
+            internal_storage.setReadContainer(p->q);
+            if(!readPacket(p->stamp)) {
+                yInfo() << "hub: read return false. closing.";
+                break;
+            }
+
+            if(p->q.empty()) {
+                recycle.push_front(p);
+                continue;
+            }
+            p->dt = packetDuration(p->q);
+            recordPacket(p->q, p->dt);
+            p->trace = internal_storage.getTrace();
+            if(!p->trace.empty())
+                p->trace.add(name);
+
+            {
+                std::lock_guard<std::mutex> lock(readers_mutex);
+                for(std::list<vHubReader>::iterator i = readers.begin();
+                    i != readers.end(); i++)
+                    i->push(p);
+            }
+
+            recycle.push_back(p);
+            if(recycle.size() > recycle_size)
+                recycle.pop_front();
+        }
+    }
+
+};
+
+}
+
+#endif
@@ -0,0 +1,291 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VPACKET__
+#define __VPACKET__
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <type_traits>
+#include <algorithm>
+#include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vCodecBatch.h"
+
+namespace ev {
+
+template <class T> class vPacket;
+template <class T> void decodePacket(vPacket<T> &p, size_t offset, int *data,
+                                     size_t n, codecLayout layout);
+template <class T> void encodePacket(const vPacket<T> &p, std::int32_t *data,
+                                     codecLayout layout);
+void decodePacket(vPacket<AddressEvent> &p, size_t offset, int *data, size_t n,
+                  codecLayout layout);
+void encodePacket(const vPacket<AddressEvent> &p, std::int32_t *data,
+                  codecLayout layout);
+
+/// \brief a packet of events stored as a structure-of-arrays. Each field of
+/// the AddressEvent is held in its own contiguous array so that no per-event
+/// memory allocation is required. Only the AddressEvent is stored: a derived
+/// event-type would lose its extra fields.
+template <class T = AddressEvent> class vPacket
+{
+public:
+
+    std::vector<stamp_t> stamp;
+    std::vector<std::uint16_t> x;
+    std::vector<std::uint16_t> y;
+    std::vector<std::uint8_t> polarity;
+    std::vector<std::uint8_t> channel;
+    std::vector<std::uint8_t> type;
+
+    /// \brief an empty packet. The event-type is checked here rather than in
+    /// the class, such that the vPacket overloads of the port interfaces of
+    /// other event-types can be declared.
+    vPacket()
+    {
+        static_assert(std::is_same<AddressEvent, T>::value,
+                      "vPacket only stores the fields of an AddressEvent");
+    }
+
+    /// \brief the number of events in the packet
+    size_t size() const { return stamp.size(); }
+
+    /// \brief true if the packet contains no events
+    bool empty() const { return stamp.empty(); }
+
+    /// \brief remove all events. Allocated memory is kept for re-use.
+    void clear()
+    {
+        stamp.clear(); x.clear(); y.clear();
+        polarity.clear(); channel.clear(); type.clear();
+    }
+
+    /// \brief allocate memory for n events
+    void reserve(size_t n)
+    {
+        stamp.reserve(n); x.reserve(n); y.reserve(n);
+        polarity.reserve(n); channel.reserve(n); type.reserve(n);
+    }
+
+    /// \brief set the number of events to n
+    void resize(size_t n)
+    {
+        stamp.resize(n); x.resize(n); y.resize(n);
+        polarity.resize(n); channel.resize(n); type.resize(n);
+    }
+
+    /// \brief add an event to the end of the packet given its fields
+    void push_back(stamp_t ts, int ex, int ey, int p, int c, int t = 0)
+    {
+        stamp.push_back(ts);
+        x.push_back(ex);
+        y.push_back(ey);
+        polarity.push_back(p);
+        channel.push_back(c);
+        type.push_back(t);
+    }
+
+    /// \brief add an event to the end of the packet
+    void push_back(const AddressEvent &v)
+    {
+        push_back(v.stamp, v.x, v.y, v.polarity, v.channel, v.type);
+    }
+
+    /// \brief copy the i-th event into an event object
+    void get(size_t i, AddressEvent &v) const
+    {
+        v.stamp = stamp[i];
+        v.x = x[i];
+        v.y = y[i];
+        v.polarity = polarity[i];
+        v.channel = channel[i];
+        v.type = type[i];
+    }
+
+    /// \brief make a copy of the i-th event as an event object
+    T get(size_t i) const
+    {
+        T v;
+        get(i, v);
+        return v;
+    }
+
+    /// \brief overwrite the i-th event with v
+    void set(size_t i, const AddressEvent &v)
+    {
+        stamp[i] = v.stamp;
+        x[i] = v.x;
+        y[i] = v.y;
+        polarity[i] = v.polarity;
+        channel[i] = v.channel;
+        type[i] = v.type;
+    }
+
+    /// \brief copy the i-th event to position j (j <= i). Used to compact a
+    /// packet in place when events are filtered out.
+    void move(size_t i, size_t j)
+    {
+        stamp[j] = stamp[i];
+        x[j] = x[i];
+        y[j] = y[i];
+        polarity[j] = polarity[i];
+        channel[j] = channel[i];
+        type[j] = type[i];
+    }
+
+    /// \brief decode n_events events from a block of coded integers. The
+    /// events are appended to the packet. The layout of the address is only
+    /// selectable for AddressEvent packets.
+    void decode(int *data, size_t n_events, codecLayout layout = LAYOUT_DEFAULT)
+    {
+        size_t offset = size();
+        resize(offset + n_events);
+        decodePacket(*this, offset, data, n_events, layout);
+    }
+
+    /// \brief encode all events into a block of coded integers starting from
+    /// pos. b must already be large enough.
+    void encode(std::vector<std::int32_t> &b, unsigned int &pos,
+                codecLayout layout = LAYOUT_DEFAULT) const
+    {
+        encodePacket(*this, b.data() + pos, layout);
+        pos += packetSize(T::id) * size();
+    }
+
+    /// \brief append all AddressEvents from a vQueue (conversion from the
+    /// shared_ptr representation)
+    void fromQueue(const vQueue &q)
+    {
+        reserve(size() + q.size());
+        for(vQueue::const_iterator qi = q.begin(); qi != q.end(); qi++) {
+            auto v = as_event<AddressEvent>(*qi);
+            if(v) push_back(*v);
+        }
+    }
+
+    /// \brief append all events to the end of a vQueue (conversion to the
+    /// shared_ptr representation)
+    void toQueue(vQueue &q) const
+    {
+        for(size_t i = 0; i < size(); i++) {
+            auto v = make_event<T>();
+            get(i, *v);
+            q.push_back(v);
+        }
+    }
+
+    /// \brief append all events from a container of event objects
+    template <class C> void fromContainer(const C &q)
+    {
+        reserve(size() + q.size());
+        for(typename C::const_iterator qi = q.begin(); qi != q.end(); qi++)
+            push_back(*qi);
+    }
+
+    /// \brief append all events to a container of event objects
+    template <class C> void toContainer(C &q) const
+    {
+        for(size_t i = 0; i < size(); i++)
+            q.push_back(get(i));
+    }
+
+};
+
+/// \brief decode n events into a packet starting from offset
+template <class T> inline void decodePacket(vPacket<T> &p, size_t offset, int *data,
+                                            size_t n, codecLayout)
+{
+    T v;
+    for(size_t i = 0; i < n; i++) {
+        v.decode(data);
+        p.set(offset + i, v);
+    }
+}
+
+/// \brief encode all events of a packet
+template <class T> inline void encodePacket(const vPacket<T> &p, std::int32_t *data,
+                                            codecLayout)
+{
+    std::vector<std::int32_t> b(packetSize(T::id));
+    T v;
+    for(size_t i = 0; i < p.size(); i++) {
+        unsigned int pos = 0;
+        p.get(i, v);
+        v.encode(b, pos);
+        for(unsigned int j = 0; j < pos; j++)
+            *(data++) = b[j];
+    }
+}
+
+#ifdef VLIB_TIMESTAMP_64
+/// \brief decode n AddressEvents into a packet using the block decoder. The
+/// 32 bit coded stamps are widened in chunks.
+inline void decodePacket(vPacket<AddressEvent> &p, size_t offset, int *data,
+                         size_t n, codecLayout layout)
+{
+    const size_t chunk = 256;
+    unsigned int ts[chunk];
+    for(size_t i = 0; i < n; i += chunk) {
+        size_t m = std::min(chunk, n - i);
+        size_t j = offset + i;
+        decodeAEBlock(data + 2*i, m, ts, p.x.data() + j, p.y.data() + j,
+                      p.polarity.data() + j, p.channel.data() + j,
+                      p.type.data() + j, layout);
+        std::copy(ts, ts + m, p.stamp.begin() + j);
+    }
+}
+
+/// \brief encode a packet of AddressEvents using the block encoder. The
+/// stamps are narrowed to their coded 32 bits in chunks.
+inline void encodePacket(const vPacket<AddressEvent> &p, std::int32_t *data,
+                         codecLayout layout)
+{
+    const size_t chunk = 256;
+    unsigned int ts[chunk];
+    for(size_t i = 0; i < p.size(); i += chunk) {
+        size_t m = std::min(chunk, p.size() - i);
+        for(size_t k = 0; k < m; k++)
+            ts[k] = p.stamp[i + k];
+        encodeAEBlock(data + 2*i, m, ts, p.x.data() + i, p.y.data() + i,
+                      p.polarity.data() + i, p.channel.data() + i,
+                      p.type.data() + i, layout);
+    }
+}
+#else
+/// \brief decode n AddressEvents into a packet using the block decoder
+inline void decodePacket(vPacket<AddressEvent> &p, size_t offset, int *data,
+                         size_t n, codecLayout layout)
+{
+    decodeAEBlock(data, n, p.stamp.data() + offset, p.x.data() + offset,
+                  p.y.data() + offset, p.polarity.data() + offset,
+                  p.channel.data() + offset, p.type.data() + offset, layout);
+}
+
+/// \brief encode a packet of AddressEvents using the block encoder
+inline void encodePacket(const vPacket<AddressEvent> &p, std::int32_t *data,
+                         codecLayout layout)
+{
+    encodeAEBlock(data, p.size(), p.stamp.data(), p.x.data(), p.y.data(),
+                  p.polarity.data(), p.channel.data(), p.type.data(), layout);
+}
+#endif
+
+}
+
+#endif
@@ -0,0 +1,328 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VPACKETVIEW__
+#define __VPACKETVIEW__
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vCodecLayout.h"
+#include "iCub/eventdriven/vtsHelper.h"
+
+namespace ev {
+
+/// \brief decode the event starting at data. Event-types other than
+/// AddressEvent always use the default layout.
+template <class T> inline void decodeEvent(const std::int32_t *data, T &v,
+                                           codecLayout)
+{
+    int *d = (int *)data;
+    v.decode(d);
+}
+
+/// \brief decode the AddressEvent starting at data with a resolved layout
+inline void decodeEvent(const std::int32_t *data, AddressEvent &v,
+                        codecLayout layout)
+{
+    v.stamp = data[0] & vtsHelper::max_stamp;
+    switch(layout) {
+    case LAYOUT_128x128: decodeAddress<layout128x128>(data[1], v); break;
+    case LAYOUT_304x240_20: decodeAddress<layout304x240_20>(data[1], v); break;
+    default: decodeAddress<layout304x240_24>(data[1], v);
+    }
+}
+
+/// \brief a read-only forward iterator over the events of a vPacketView.
+/// Each event is decoded only when it is dereferenced, the timestamp can be
+/// read without decoding the rest of the event.
+template <class T> class vPacketViewIterator
+{
+public:
+
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T* pointer;
+    typedef const T& reference;
+
+private:
+
+    const std::int32_t *data;
+    const std::int32_t *end;
+    unsigned int ints;
+    codecLayout layout;
+    mutable T v;
+    mutable bool decoded;
+#ifdef VLIB_TIMESTAMP_64
+    vtsHelper unwrapper;
+    stamp_t ts;
+
+    void unwrapNext()
+    {
+        if(data != end)
+            ts = unwrapper.unwrap(data[0] & vtsHelper::max_stamp);
+    }
+#endif
+
+public:
+
+    vPacketViewIterator(const std::int32_t *data, const std::int32_t *end,
+                        unsigned int ints, codecLayout layout,
+                        const vtsHelper &unwrapper)
+        : data(data), end(end), ints(ints), layout(layout), decoded(false)
+    {
+#ifdef VLIB_TIMESTAMP_64
+        this->unwrapper = unwrapper;
+        ts = 0;
+        unwrapNext();
+#else
+        (void)unwrapper;
+#endif
+    }
+
+    /// \brief the timestamp of the event
+    stamp_t stamp() const
+    {
+#ifdef VLIB_TIMESTAMP_64
+        return ts;
+#else
+        return data[0] & vtsHelper::max_stamp;
+#endif
+    }
+
+    /// \brief the coded integers of the event
+    const std::int32_t * raw() const
+    {
+        return data;
+    }
+
+    const T& operator*() const
+    {
+        if(!decoded) {
+            decodeEvent(data, v, layout);
+#ifdef VLIB_TIMESTAMP_64
+            v.stamp = ts;
+#endif
+            decoded = true;
+        }
+        return v;
+    }
+
+    const T* operator->() const
+    {
+        return &(operator*());
+    }
+
+    vPacketViewIterator& operator++()
+    {
+        data += ints;
+        decoded = false;
+#ifdef VLIB_TIMESTAMP_64
+        unwrapNext();
+#endif
+        return *this;
+    }
+
+    vPacketViewIterator operator++(int)
+    {
+        vPacketViewIterator copy = *this;
+        ++(*this);
+        return copy;
+    }
+
+    bool operator==(const vPacketViewIterator &other) const
+    {
+        return data == other.data;
+    }
+
+    bool operator!=(const vPacketViewIterator &other) const
+    {
+        return data != other.data;
+    }
+};
+
+/// \brief a read-only view of a packet of events as they were received,
+/// i.e. a reference counted block of coded integers and the event-type
+/// they hold. No events are allocated or decoded until they are iterated.
+/// Copies of a view share the same block, which is recycled by the port
+/// once all copies have been released. Any event-type that inherits from
+/// the event-type of the packet can be iterated, e.g. a packet of
+/// LabelledAE as AddressEvents.
+class vPacketView
+{
+private:
+
+    std::shared_ptr< std::vector<std::int32_t> > block;
+    std::int32_t *data;
+    size_t n;
+    int type_id;
+    unsigned int ints;
+    codecLayout layout;
+
+    //the unwrapping state before the first event (VLIB_TIMESTAMP_64)
+    vtsHelper start;
+    stamp_t first_stamp;
+    stamp_t last_stamp;
+
+public:
+
+    /// \brief an empty view
+    vPacketView() : data(nullptr), n(0), type_id(-1), ints(0),
+        layout(LAYOUT_DEFAULT), first_stamp(0), last_stamp(0) {}
+
+    /// \brief a view of n events of type_id held at the start of block.
+    /// As for the codecs, only AddressEvent packets use the given layout.
+    /// With VLIB_TIMESTAMP_64 the timestamps are unwrapped continuing from
+    /// unwrapper, which is advanced to the end of the packet.
+    vPacketView(std::shared_ptr< std::vector<std::int32_t> > block,
+                size_t n, int type_id, codecLayout layout,
+                vtsHelper &unwrapper)
+        : block(block), data(block->data()), n(n), type_id(type_id),
+          ints(packetSize(type_id)),
+          layout(type_id == AddressEvent::id ? resolveLayout(layout) : getDefaultLayout()),
+          start(unwrapper), first_stamp(0), last_stamp(0)
+    {
+        if(!n) return;
+        first_stamp = data[0] & vtsHelper::max_stamp;
+        last_stamp = data[(n - 1) * ints] & vtsHelper::max_stamp;
+#ifdef VLIB_TIMESTAMP_64
+        //a packet spans much less than half the timestamp range
+        first_stamp = unwrapper.unwrap(first_stamp);
+        last_stamp = unwrapper.unwrap(last_stamp);
+#endif
+    }
+
+    /// \brief release the block and empty the view
+    void clear() { *this = vPacketView(); }
+
+    /// \brief the number of events
+    size_t size() const { return n; }
+
+    /// \brief true if the view has no events
+    bool empty() const { return n == 0; }
+
+    /// \brief the ID of the event-type of the packet
+    int typeID() const { return type_id; }
+
+    /// \brief the tag of the event-type of the packet
+    const std::string & type() const { return eventTag(type_id); }
+
+    /// \brief true if the events can be iterated as event-type T
+    template <class T> bool isType() const { return isEventType(type_id, T::id); }
+
+    /// \brief the coded integers of the packet
+    const std::int32_t * raw() const { return data; }
+
+    /// \brief the number of coded integers of the packet
+    size_t rawSize() const { return n * ints; }
+
+    /// \brief the timestamp of the first event
+    stamp_t frontStamp() const { return first_stamp; }
+
+    /// \brief the timestamp of the last event
+    stamp_t backStamp() const { return last_stamp; }
+
+    /// \brief the timestamp of the i-th event
+    stamp_t stampAt(size_t i) const
+    {
+        stamp_t ts = data[i * ints] & vtsHelper::max_stamp;
+#ifdef VLIB_TIMESTAMP_64
+        //unwrapped relative to the first event
+        std::int64_t d = (std::int64_t)ts - (data[0] & vtsHelper::max_stamp);
+        if(d < -(std::int64_t)(vtsHelper::max_stamp / 2))
+            d += vtsHelper::max_stamp;
+        else if(d > (std::int64_t)(vtsHelper::max_stamp / 2))
+            d -= vtsHelper::max_stamp;
+        ts = first_stamp + d;
+#endif
+        return ts;
+    }
+
+    /// \brief remove the first m events. As move() and resize(), to be used
+    /// by a read port before the view is handed out, as the block is shared
+    /// with any copy of the view.
+    void eraseFront(size_t m)
+    {
+        if(m >= n) {
+            data += n * ints;
+            n = 0;
+            return;
+        }
+        if(!m) return;
+#ifdef VLIB_TIMESTAMP_64
+        start.unwrap(data[(m - 1) * ints] & vtsHelper::max_stamp);
+#endif
+        first_stamp = stampAt(m);
+        data += m * ints;
+        n -= m;
+    }
+
+    /// \brief copy the i-th event to position j (j <= i)
+    void move(size_t i, size_t j)
+    {
+        if(j == 0) first_stamp = stampAt(i);
+        std::copy(data + i * ints, data + (i + 1) * ints, data + j * ints);
+    }
+
+    /// \brief keep the first m events (m <= size())
+    void resize(size_t m)
+    {
+        n = m;
+        if(n) last_stamp = stampAt(n - 1);
+    }
+
+    /// \brief an iterator to the first event, decoded as event-type T. Check
+    /// the event-type with isType<T>() first.
+    template <class T> vPacketViewIterator<T> begin() const
+    {
+        return vPacketViewIterator<T>(data, data + n * ints, ints, layout, start);
+    }
+
+    /// \brief an iterator past the last event
+    template <class T> vPacketViewIterator<T> end() const
+    {
+        const std::int32_t *e = data + n * ints;
+        return vPacketViewIterator<T>(e, e, ints, layout, start);
+    }
+
+    /// \brief decode all events into a vQueue (e.g. to keep some of them
+    /// after the view is released)
+    void toQueue(vQueue &q) const
+    {
+        event<> v = createEvent(type_id);
+        if(!v) return;
+        vtsHelper unwrapper = start;
+        int *d = (int *)data;
+        for(size_t i = 0; i < n; i++) {
+            v->decode(d);
+#ifdef VLIB_TIMESTAMP_64
+            v->stamp = unwrapper.unwrap(v->stamp);
+#endif
+            q.push_back(v->clone());
+        }
+        (void)unwrapper;
+    }
+};
+
+}
+
+#endif
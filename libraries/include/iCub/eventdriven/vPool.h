@@ -0,0 +1,274 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VPOOL__
+#define __VPOOL__
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <new>
+
+namespace ev {
+
+/// \brief usage counters of the event memory pool. A hit is an allocation
+/// served by a recycled block, a miss required new memory to be created.
+struct poolStats {
+    unsigned long hits;
+    unsigned long misses;
+};
+
+/// \brief ask for the pool usage summed over all threads and event-types
+poolStats getPoolStats();
+
+/// \brief per-thread counters of the event memory pool
+class poolCounters
+{
+private:
+
+    std::atomic<unsigned long> hits;
+    std::atomic<unsigned long> misses;
+
+public:
+
+    poolCounters() : hits(0), misses(0) {}
+
+    //only the owning thread writes, so an atomic read-modify-write is not
+    //needed. Other threads only read the values to report them.
+    void hit() { hits.store(hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    void miss() { misses.store(misses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    unsigned long getHits() const { return hits.load(std::memory_order_relaxed); }
+    unsigned long getMisses() const { return misses.load(std::memory_order_relaxed); }
+
+    /// \brief make the counters visible to getPoolStats()
+    static void add(poolCounters *c);
+    /// \brief remove the counters when the thread exits, keeping their totals
+    static void retire(poolCounters *c);
+};
+
+/// \brief a recycling pool of fixed size memory blocks. Each thread keeps a
+/// private cache of free blocks so that steady-state allocation and
+/// deallocation do not require a lock. Blocks freed by a different thread to
+/// the allocating thread (e.g. read thread and processing thread) are returned
+/// in batches through a shared depot, taking the lock once per batch.
+template <std::size_t S> class slabPool
+{
+private:
+
+    struct node { node *next; };
+
+    //blocks are moved between threads and created in batches of this size
+    static const unsigned int batch = 256;
+
+    struct chain {
+        node *head;
+        unsigned int n;
+    };
+
+    struct depot {
+        std::mutex m;
+        std::vector<chain> chains;
+    };
+
+    struct threadCache {
+        node *head;
+        unsigned int n;
+        char *slab;
+        unsigned int slab_left;
+        poolCounters *counters;
+        bool released;
+    };
+
+    struct cacheGuard {
+        ~cacheGuard() { releaseCache(); }
+    };
+
+    //the depot is never destroyed so that events released during static
+    //destruction can still be returned to it
+    static depot &getDepot()
+    {
+        static depot *d = new depot;
+        return *d;
+    }
+
+    static threadCache &getCache()
+    {
+        static thread_local threadCache c = {nullptr, 0, nullptr, 0, nullptr, false};
+        return c;
+    }
+
+    static void initCache(threadCache &c)
+    {
+        static thread_local cacheGuard guard;
+        (void)guard;
+        c.counters = new poolCounters;
+        poolCounters::add(c.counters);
+    }
+
+    static void giveToDepot(node *head, unsigned int n)
+    {
+        depot &d = getDepot();
+        std::lock_guard<std::mutex> lock(d.m);
+        d.chains.push_back({head, n});
+    }
+
+    static bool takeFromDepot(chain &c)
+    {
+        depot &d = getDepot();
+        std::lock_guard<std::mutex> lock(d.m);
+        if(d.chains.empty()) return false;
+        c = d.chains.back();
+        d.chains.pop_back();
+        return true;
+    }
+
+    static void releaseCache()
+    {
+        threadCache &c = getCache();
+
+        //unused blocks of the current slab are chained and given back too
+        while(c.slab_left) {
+            node *v = reinterpret_cast<node *>(c.slab);
+            v->next = c.head;
+            c.head = v;
+            c.n++;
+            c.slab += S;
+            c.slab_left--;
+        }
+
+        if(c.head) giveToDepot(c.head, c.n);
+        c.head = nullptr;
+        c.n = 0;
+        c.released = true;
+        if(c.counters) poolCounters::retire(c.counters);
+        c.counters = nullptr;
+    }
+
+public:
+
+    static void *allocate()
+    {
+        threadCache &c = getCache();
+        if(!c.counters && !c.released) initCache(c);
+
+        //recycled blocks first, then blocks recycled by other threads, then
+        //unused blocks of a slab
+        if(!c.head && !c.slab_left) {
+            chain f;
+            if(takeFromDepot(f)) {
+                c.head = f.head;
+                c.n = f.n;
+            } else {
+                //slabs are kept for the lifetime of the process
+                c.slab = static_cast<char *>(::operator new(S * batch));
+                c.slab_left = batch;
+            }
+        }
+
+        void *v;
+        if(c.head) {
+            if(c.counters) c.counters->hit();
+            v = c.head;
+            c.head = c.head->next;
+            c.n--;
+        } else {
+            if(c.counters) c.counters->miss();
+            v = c.slab;
+            c.slab += S;
+            c.slab_left--;
+        }
+
+        //a thread that is exiting does not keep a cache
+        if(c.released) releaseCache();
+        return v;
+    }
+
+    static void deallocate(void *p)
+    {
+        threadCache &c = getCache();
+        node *v = static_cast<node *>(p);
+
+        if(c.released) {
+            v->next = nullptr;
+            giveToDepot(v, 1);
+            return;
+        }
+
+        v->next = c.head;
+        c.head = v;
+        c.n++;
+
+        //return a batch to the depot for use by other threads
+        if(c.n >= 2 * batch) {
+            node *tail = c.head;
+            for(unsigned int i = 0; i < batch - 1; i++)
+                tail = tail->next;
+            node *remaining = tail->next;
+            tail->next = nullptr;
+            giveToDepot(c.head, batch);
+            c.head = remaining;
+            c.n -= batch;
+        }
+    }
+
+};
+
+/// \brief an allocator drawing memory from the slabPool of matching size.
+/// Used with std::allocate_shared so that the event and its reference count
+/// share a single recycled block.
+template <class T> class poolAllocator
+{
+private:
+
+    static const std::size_t align = alignof(std::max_align_t);
+    static const std::size_t block = (sizeof(T) + align - 1) / align * align;
+
+public:
+
+    typedef T value_type;
+
+    poolAllocator() {}
+    template <class U> poolAllocator(const poolAllocator<U> &) {}
+
+    T *allocate(std::size_t n)
+    {
+        static_assert(alignof(T) <= align, "poolAllocator: unsupported alignment");
+        if(n != 1)
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        return static_cast<T *>(slabPool<block>::allocate());
+    }
+
+    void deallocate(T *p, std::size_t n)
+    {
+        if(n != 1)
+            ::operator delete(p);
+        else
+            slabPool<block>::deallocate(p);
+    }
+
+};
+
+template <class T, class U>
+inline bool operator==(const poolAllocator<T> &, const poolAllocator<U> &) { return true; }
+template <class T, class U>
+inline bool operator!=(const poolAllocator<T> &, const poolAllocator<U> &) { return false; }
+
+}
+
+#endif
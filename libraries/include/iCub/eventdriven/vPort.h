@@ -20,8 +20,24 @@
 #define __VGENPORT__
 
 #include <vector>
+#include <list>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <sstream>
+#include <cstring>
 #include <yarp/os/all.h>
 #include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vPacket.h"
+#include "iCub/eventdriven/vPacketView.h"
+#include "iCub/eventdriven/vCompress.h"
+#include "iCub/eventdriven/vRing.h"
+#include "iCub/eventdriven/vDropPolicy.h"
+#include "iCub/eventdriven/vShm.h"
+#include "iCub/eventdriven/vStats.h"
+#include "iCub/eventdriven/vTrace.h"
 #include "iCub/eventdriven/vtsHelper.h"
 
 using namespace yarp::os;
@@ -43,13 +59,129 @@ protected:
     std::vector<std::int32_t> internaldata;
     vQueue *read_q;
 
+    //compression
+    std::string eventtype;
+    bool compress;
+    bool compress_lz;
+    std::vector<std::int32_t> compresseddata;
+
+    //unwraps the timestamps read with VLIB_TIMESTAMP_64
+    vtsHelper unwrapper;
+
+    //trace sent after the data as the strings "TRC" and the trace
+    std::vector<std::int32_t> header4;
+    std::vector<std::int32_t> header5;
+    std::string trace_text;
+    vTrace read_trace;
+
     //sizes
     unsigned int elementINTS;
     unsigned int elementBYTES;
 
+    /// \brief set the tag sent in the header, marking compressed data
+    void updateTag()
+    {
+        header2 = compress ? eventtype + compressed_suffix : eventtype;
+        header1[3] = header2.size();
+    }
+
+    /// \brief replace the data to send with its compressed version
+    void compressData()
+    {
+        if(!compress) return;
+        header3[1] = compressEvents((const std::int32_t *)datablock, header3[1],
+                                    elementINTS, compress_lz, compresseddata);
+        datablock = (const char *)compresseddata.data();
+        datalength = header3[1] * sizeof(std::int32_t);
+    }
+
+    /// \brief read a string of a Bottle (which may be null terminated)
+    template <class R> static bool readString(R& connection, std::string &s)
+    {
+        if(connection.expectInt() != BOTTLE_TAG_STRING)
+            return false;
+        int len = connection.expectInt();
+        if(len < 0)
+            return false;
+        s.resize(len);
+        if(len && !connection.expectBlock(&s[0], len))
+            return false;
+        s.resize(std::strlen(s.c_str()));
+        return true;
+    }
+
+    /// \brief read the trace following the data of a packet
+    template <class R> bool readTrace(R& connection)
+    {
+        std::string tag, text;
+        if(!readString(connection, tag) || tag != trace_tag)
+            return false;
+        if(!readString(connection, text) || !read_trace.fromString(text)) {
+            yError() << "Could not read the trace of a packet";
+            return false;
+        }
+        return true;
+    }
+
+    /// \brief read the headers and the data of a packet into data (e.g. a
+    /// block to be shared with a vPacketView), decompressing it if needed.
+    /// vtype is set to the event-type and ndata to the number of coded
+    /// integers. R is a yarp::os::ConnectionReader or a vMemoryReader.
+    template <class R> bool readData(R& connection, std::string &vtype,
+                                     unsigned int &ndata,
+                                     std::vector<std::int32_t> &data)
+    {
+        //META DATA OF BOTTLE
+        if(connection.expectInt() != BOTTLE_TAG_LIST) //a list
+            return false;
+        int nbottles = connection.expectInt();
+        if(nbottles != 2 && nbottles != 4) //of two internal bottles (+ trace)
+            return false;
+
+        //DATA OF FIRST INTERNAL BOTTLE (type of event)
+        if(connection.expectInt() != BOTTLE_TAG_STRING) // first of two
+            return false;
+        int str_len = connection.expectInt();
+        vtype.resize(str_len);
+        connection.expectBlock((char *)vtype.data(), str_len);
+        bool compressed = stripCompressedTag(vtype);
+
+        //DATA OF SECOND INTERNAL BOTTLE (data of events)
+        if(connection.expectInt() != (BOTTLE_TAG_LIST|BOTTLE_TAG_INT))
+            return false;
+        ndata = (unsigned int)connection.expectInt(); //in integers!!
+
+        std::vector<std::int32_t> &block = compressed ? compresseddata : data;
+        if(ndata > block.size())
+            block.resize(ndata);
+        if(!connection.expectBlock((char *)block.data(), sizeof(std::int32_t) * ndata)) {
+            yError() << "Could not read datablock";
+            return false;
+        }
+
+        read_trace.clear();
+        if(nbottles == 4 && !readTrace(connection))
+            return false;
+
+        decode_ns = 0;
+        if(compressed) {
+            std::uint64_t t0 = steadyNanos();
+            if(!decompressEvents(block.data(), ndata, packetSize(vtype), data,
+                                 ndata)) {
+                yError() << "Could not decompress datablock";
+                return false;
+            }
+            decode_ns = steadyNanos() - t0;
+        }
+
+        return true;
+    }
+
 public:
 
-    std::deque<double> meanrat;
+    /// \brief the time taken to decompress and decode the last packet read
+    /// (nanoseconds)
+    std::uint64_t decode_ns;
 
     /// \brief instantiate the correct headers for a Bottle
     vGenPortInterface() {
@@ -60,9 +192,26 @@ public:
         header2 = "";
         header3.push_back(BOTTLE_TAG_LIST|BOTTLE_TAG_INT); // bottle code + specialisation with ints
         header3.push_back(0); // <- set the number of ints here (e.g. 2 * #v's)
+        header4.push_back(BOTTLE_TAG_STRING);
+        header4.push_back(sizeof(trace_tag) - 1);
+        header5.push_back(BOTTLE_TAG_STRING);
+        header5.push_back(0); // length of the trace
         elementINTS = 0;
         elementBYTES = sizeof(std::int32_t) * elementINTS;
         read_q = 0;
+        compress = false;
+        compress_lz = false;
+        decode_ns = 0;
+    }
+
+    /// \brief compress the data sent (delta coded timestamps and bit-packed
+    /// addresses, optionally followed by an LZ stage). Readers detect
+    /// compressed packets from the event-type tag and decompress them.
+    void setCompression(bool compress, bool lz = false)
+    {
+        this->compress = compress;
+        this->compress_lz = lz;
+        updateTag();
     }
 
     /// \brief for data already allocated in contiguous space. Just send this
@@ -71,80 +220,91 @@ public:
         header3[1] = elementINTS * (datalength / elementBYTES); //forced to be x8
         this->datablock = datablock;
         this->datalength = elementBYTES * header3[1] / elementINTS; //forced to be x8
+        compressData();
 
     }
 
-    /// \brief send an entire vQueue. The queue is encoded and allocated into a single contiguous memory space. Faster than a standard vBottle.
-    void setInternalData(const vQueue &q) {
+    /// \brief encode a vQueue into block starting from pos (in integers),
+    /// increasing the size of block if needed. Returns the position after the
+    /// last event.
+    unsigned int encode(const vQueue &q, std::vector<std::int32_t> &block,
+                        unsigned int pos) const {
 
-        header3[1] = elementINTS * q.size(); //number of ints
+        unsigned int end = pos + elementINTS * q.size();
+        if(block.size() < end) //increase mem if needed
+            block.resize(end);
 
-        if((int)internaldata.size() < header3[1]) //increase internal mem if needed
-            internaldata.resize(header3[1]);
-
-        unsigned int pos = 0;
         for(unsigned int i = 0; i < q.size(); i++)  //decode the data into
-            q[i]->encode(internaldata, pos);        //internal memeory
+            q[i]->encode(block, pos);               //memeory
 
-        if(pos != (unsigned int)header3[1])
+        if(pos != end)
             yError() << "vBottleMimic: encoding incorrect";
+        return end;
+    }
+
+    /// \brief send an entire vQueue. The queue is encoded and allocated into a single contiguous memory space. Faster than a standard vBottle.
+    void setInternalData(const vQueue &q) {
+
+        header3[1] = encode(q, internaldata, 0); //number of ints
 
         this->datablock = (const char *)internaldata.data();
         this->datalength = elementBYTES * q.size();
+        compressData();
     }
 
     /// \brief set the type of event that this vBottleMimic will send
     void setHeader(std::string eventtype) {
-        header1[3] = eventtype.size();  //set the string length
-        header2 = eventtype;            //set the string itself
+        this->eventtype = eventtype;
+        updateTag();                    //set the string and its length
 
         elementINTS = packetSize(eventtype);
         elementBYTES = sizeof(std::int32_t) * elementINTS;
 
     }
 
-    void setReadContainer(vQueue &q) {
-        this->read_q = &q;
+    /// \brief send trace with the packets written, until clearTrace()
+    void setTrace(const vTrace &trace)
+    {
+        trace_text = trace.toString();
+        header5[1] = trace_text.size();
+        header1[1] = trace_text.empty() ? 2 : 4;
     }
 
-    /// \brief does nothing as this is a write-only port.
-    bool read(yarp::os::ConnectionReader& connection) {
-
-        //double cpudt = Time::now();
-
-        //META DATA OF BOTTLE
-        if(connection.expectInt() != BOTTLE_TAG_LIST) //a list
-            return false;
-        if(connection.expectInt() != 2) //of two internal bottles
-            return false;
+    /// \brief stop sending a trace
+    void clearTrace()
+    {
+        trace_text.clear();
+        header1[1] = 2;
+    }
 
-        //DATA OF FIRST INTERNAL BOTTLE (type of event)
-        if(connection.expectInt() != BOTTLE_TAG_STRING) // first of two
-            return false;
-        int str_len = connection.expectInt();
-        std::string vtype;
-        vtype.resize(str_len);
-        connection.expectBlock((char *)vtype.data(), str_len);
+    /// \brief the trace of the last packet read (empty if not traced)
+    const vTrace& getTrace() const
+    {
+        return read_trace;
+    }
 
-        //DATA OF SECOND INTERNAL BOTTLE (data of events)
-        if(connection.expectInt() != (BOTTLE_TAG_LIST|BOTTLE_TAG_INT))
-            return false;
-        unsigned int ndata = (unsigned int)connection.expectInt(); //in integers!!
+    void setReadContainer(vQueue &q) {
+        this->read_q = &q;
+    }
 
-        if(ndata > internaldata.size())
-            internaldata.resize(ndata);
-        if(!connection.expectBlock((char *)internaldata.data(), sizeof(std::int32_t) * ndata)) {
-            yError() << "Could not read datablock";
-            return false;
-        }
+    /// \brief the block the next packet is read into
+    virtual std::vector<std::int32_t>& readBlock()
+    {
+        return internaldata;
+    }
 
-        int event_size = packetSize(vtype);
+    /// \brief decode the ndata integers of event-type vtype read into
+    /// readBlock() into the read container
+    virtual bool unpack(const std::string &vtype, unsigned int ndata)
+    {
+        int type_id = eventTypeID(vtype);
+        int event_size = packetSize(type_id);
         if(!event_size) {
             yError() << "Do not know event-type";
             return false;
         }
 
-        event<> v = createEvent(vtype);
+        event<> v = createEvent(type_id);
         if(v == nullptr) {
             yError() << "Do not know event-type";
             return false;
@@ -154,14 +314,54 @@ public:
 
         for(unsigned int i = 0; i < ndata / event_size; i++) {
             v->decode(data);
+#ifdef VLIB_TIMESTAMP_64
+            v->stamp = unwrapper.unwrap(v->stamp);
+#endif
             read_q->push_back(v->clone());
         }
 
         return true;
     }
 
-    /// \brief write the data on the connection.
-    bool write(yarp::os::ConnectionWriter& connection) const {
+    /// \brief read a packet from connection into the read container
+    template <class R> bool readFrom(R& connection)
+    {
+        std::string vtype;
+        unsigned int ndata;
+        if(!readData(connection, vtype, ndata, readBlock()))
+            return false;
+        std::uint64_t t0 = steadyNanos();
+        bool ok = unpack(vtype, ndata);
+        decode_ns += steadyNanos() - t0;
+        return ok;
+    }
+
+    /// \brief decode a packet of events into the read container
+    bool read(yarp::os::ConnectionReader& connection) {
+        return readFrom(connection);
+    }
+
+    /// \brief decode a packet of events held in memory (as written by
+    /// writeTo) into the read container
+    bool read(const char *data, size_t size) {
+        vMemoryReader reader(data, size);
+        return readFrom(reader);
+    }
+
+    /// \brief the number of bytes written by write/writeTo
+    size_t wireSize() const
+    {
+        size_t n = (header1.size() + header3.size()) * sizeof(std::int32_t) +
+                header1[3] + datalength;
+        if(trace_text.size())
+            n += (header4.size() + header5.size()) * sizeof(std::int32_t) +
+                    header4[1] + header5[1];
+        return n;
+    }
+
+    /// \brief write the data to a yarp::os::ConnectionWriter or a
+    /// vMemoryWriter
+    template <class W> bool writeTo(W& connection) const {
 
         connection.appendBlock((const char *)header1.data(),
                                        header1.size() * sizeof(std::int32_t));
@@ -170,99 +370,254 @@ public:
                                        header3.size() * sizeof(std::int32_t));
         connection.appendBlock(datablock, datalength);
 
+        if(trace_text.size()) {
+            connection.appendBlock((const char *)header4.data(),
+                                   header4.size() * sizeof(std::int32_t));
+            connection.appendBlock(trace_tag, header4[1]);
+            connection.appendBlock((const char *)header5.data(),
+                                   header5.size() * sizeof(std::int32_t));
+            connection.appendBlock(trace_text.c_str(), header5[1]);
+        }
+
         return !connection.isError();
     }
 
+    /// \brief write the data on the connection.
+    bool write(yarp::os::ConnectionWriter& connection) const {
+        return writeTo(connection);
+    }
+
 };
 
 template <class T> class vPortInterface : public vGenPortInterface
 {
 protected:
     std::vector<T> *read_q;
+    vPacket<T> *read_p;
+    codecLayout layout;
 
 public:
 
     /// \brief instantiate the correct headers for a Bottle
     vPortInterface() : vGenPortInterface() {
-        header1[3] = T::tag.size(); // length of string
-        header2 = T::tag;
-        elementINTS = packetSize(T::tag);
+        eventtype = T::tag;
+        updateTag();
+        elementINTS = packetSize(T::id);
         elementBYTES = sizeof(std::int32_t) * elementINTS;
+        read_q = 0;
+        read_p = 0;
+        layout = LAYOUT_DEFAULT;
     }
 
-    /// \brief send an entire vQueue. The queue is encoded and allocated into a single contiguous memory space. Faster than a standard vBottle.
-    void setInternalData(const std::deque<T> &q) {
+    /// \brief set the address layout used to encode/decode AddressEvent data
+    /// on this port. LAYOUT_DEFAULT uses the process-wide default.
+    void setCodecLayout(codecLayout layout)
+    {
+        this->layout = layout;
+    }
 
-        header3[1] = elementINTS * q.size(); //number of ints
+    /// \brief encode a deque of events into block starting from pos (in
+    /// integers), increasing the size of block if needed. Returns the
+    /// position after the last event.
+    unsigned int encode(const std::deque<T> &q, std::vector<std::int32_t> &block,
+                        unsigned int pos) const {
 
-        if((int)internaldata.size() < header3[1]) //increase internal mem if needed
-            internaldata.resize(header3[1]);
+        unsigned int end = pos + elementINTS * q.size();
+        if(block.size() < end) //increase mem if needed
+            block.resize(end);
 
-        unsigned int pos = 0;
-        for(unsigned int i = 0; i < q.size(); i++)  //decode the data into
-            q[i].encode(internaldata, pos);        //internal memeory
+        encodeEvents(q, block, pos, layout);
 
-        if(pos != (unsigned int)header3[1])
+        if(pos != end)
             yError() << "vPortInterface: encoding incorrect";
+        return end;
+    }
+
+    /// \brief encode a vPacket into block starting from pos (in integers),
+    /// increasing the size of block if needed. Returns the position after the
+    /// last event.
+    unsigned int encode(const vPacket<T> &p, std::vector<std::int32_t> &block,
+                        unsigned int pos) const {
+
+        unsigned int end = pos + elementINTS * p.size();
+        if(block.size() < end) //increase mem if needed
+            block.resize(end);
+
+        p.encode(block, pos, layout);
+
+        if(pos != end)
+            yError() << "vPortInterface: encoding incorrect";
+        return end;
+    }
+
+    /// \brief send an entire vQueue. The queue is encoded and allocated into a single contiguous memory space. Faster than a standard vBottle.
+    void setInternalData(const std::deque<T> &q) {
+
+        header3[1] = encode(q, internaldata, 0); //number of ints
 
         this->datablock = (const char *)internaldata.data();
         this->datalength = elementBYTES * q.size();
+        compressData();
+    }
+
+    /// \brief send an entire vPacket. The packet is encoded into a single
+    /// contiguous memory space.
+    void setInternalData(const vPacket<T> &p) {
+
+        header3[1] = encode(p, internaldata, 0); //number of ints
+
+        this->datablock = (const char *)internaldata.data();
+        this->datalength = elementBYTES * p.size();
+        compressData();
     }
 
     void setReadContainer(std::vector<T> &q)
     {
         read_q = &q;
+        read_p = 0;
+    }
+
+    void setReadContainer(vPacket<T> &p)
+    {
+        read_p = &p;
+        read_q = 0;
     }
 
     using vGenPortInterface::write;
     using vGenPortInterface::PortWriter;
     using vGenPortInterface::PortReader;
 
-    /// \brief does nothing as this is a write-only port.
-    virtual bool read(yarp::os::ConnectionReader& connection) {
-
-        //double cpudt = Time::now();
+    /// \brief decode a packet of events into the read container
+    bool unpack(const std::string &vtype, unsigned int ndata) {
 
-        //META DATA OF BOTTLE
-        if(connection.expectInt() != BOTTLE_TAG_LIST) //a list
-            return false;
-        if(connection.expectInt() != 2) //of two internal bottles
-            return false;
-
-        //DATA OF FIRST INTERNAL BOTTLE (type of event)
-        if(connection.expectInt() != BOTTLE_TAG_STRING) // first of two
-            return false;
-        int str_len = connection.expectInt();
-        std::string vtype;
-        vtype.resize(str_len);
-        connection.expectBlock((char *)vtype.data(), str_len);
         if(vtype != T::tag) {
             yWarning() << "Incompatible event-type read";
             return false;
         }
 
-        //DATA OF SECOND INTERNAL BOTTLE (data of events)
-        if(connection.expectInt() != (BOTTLE_TAG_LIST|BOTTLE_TAG_INT))
-            return false;
-        unsigned int ndata = (unsigned int)connection.expectInt(); //in integers!!
-
-        if(ndata > internaldata.size())
-            internaldata.resize(ndata);
-        if(!connection.expectBlock((char *)internaldata.data(), sizeof(std::int32_t) * ndata)) {
-            yError() << "Could not read datablock";
-            return false;
+        int *data = internaldata.data();
+        if(read_p) {
+            read_p->clear();
+            read_p->decode(data, ndata / elementINTS, layout);
+#ifdef VLIB_TIMESTAMP_64
+            for(size_t i = 0; i < read_p->size(); i++)
+                read_p->stamp[i] = unwrapper.unwrap(read_p->stamp[i]);
+#endif
+            return true;
         }
 
-        int *data = internaldata.data();
         read_q->resize(ndata / elementINTS);
-        for(unsigned int i = 0; i < read_q->size(); i++) {
-            (*read_q)[i].decode(data);
+        decodeEvents(data, read_q->size(), read_q->data(), layout);
+#ifdef VLIB_TIMESTAMP_64
+        for(size_t i = 0; i < read_q->size(); i++)
+            (*read_q)[i].stamp = unwrapper.unwrap((*read_q)[i].stamp);
+#endif
+
+        return true;
+    }
+};
+
+/// \brief reads packets of any event-type as vPacketViews. The data of each
+/// packet is read into a reference counted block, that is recycled once all
+/// views of it are released.
+class vViewPortInterface : public vGenPortInterface
+{
+protected:
+
+    vPacketView *read_v;
+    codecLayout layout;
+    std::vector< std::shared_ptr< std::vector<std::int32_t> > > blocks;
+    std::shared_ptr< std::vector<std::int32_t> > block;
+
+    /// \brief a block that is not referenced by any view
+    std::shared_ptr< std::vector<std::int32_t> > freeBlock()
+    {
+        for(size_t i = 0; i < blocks.size(); i++) {
+            if(blocks[i].use_count() == 1) {
+                //use_count is a relaxed read: order the reuse of the block
+                //after the last reads of the view released on another thread
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return blocks[i];
+            }
         }
+        blocks.push_back(std::make_shared< std::vector<std::int32_t> >());
+        return blocks.back();
+    }
 
+public:
+
+    vViewPortInterface() : vGenPortInterface()
+    {
+        read_v = 0;
+        layout = LAYOUT_DEFAULT;
+    }
+
+    /// \brief set the address layout used to decode AddressEvents
+    void setCodecLayout(codecLayout layout)
+    {
+        this->layout = layout;
+    }
+
+    void setReadContainer(vPacketView &v)
+    {
+        read_v = &v;
+    }
+
+    using vGenPortInterface::write;
+
+    /// \brief the packet is read into a block that is not referenced
+    std::vector<std::int32_t>& readBlock()
+    {
+        block = freeBlock();
+        return *block;
+    }
+
+    /// \brief make a view of the packet without decoding it
+    bool unpack(const std::string &vtype, unsigned int ndata)
+    {
+        int type_id = eventTypeID(vtype);
+        int event_size = packetSize(type_id);
+        if(!event_size) {
+            yError() << "Do not know event-type";
+            return false;
+        }
+
+        *read_v = vPacketView(block, ndata / event_size, type_id, layout,
+                              unwrapper);
+        block.reset();
         return true;
     }
 };
 
+/// \brief the batches sent by a coalescing write port
+struct vBatchStats {
+    unsigned int batches;     //packets sent
+    unsigned int writes;      //calls to write
+    unsigned long int events;
+    unsigned long int bytes;
+    unsigned int by_bytes;    //batches sent as max_bytes was reached
+    unsigned int by_events;   //... max_events was reached
+    unsigned int by_latency;  //... the latency budget was reached
+    unsigned int by_flush;    //... flush() or close() was called
+};
+
+/// \brief what an asynchronous write port does with a write when all its
+/// buffers are waiting to be sent
+enum asyncPolicy {
+    ASYNC_BLOCK = 0,  //wait for the send thread to free a buffer
+    ASYNC_DROP = 1,   //discard the write
+    ASYNC_GROW = 2    //allocate another buffer
+};
+
+/// \brief the policy given its name ("block", "drop", "grow"). Returns
+/// ASYNC_BLOCK if unknown.
+inline asyncPolicy asyncPolicyFromName(const std::string &name)
+{
+    if(name == "drop") return ASYNC_DROP;
+    if(name == "grow") return ASYNC_GROW;
+    return ASYNC_BLOCK;
+}
+
 //this should open a yarp::os::Port
 class vGenWritePort
 {
@@ -270,34 +625,464 @@ class vGenWritePort
 protected:
 
     vGenPortInterface internal_storage;
+    vGenPortInterface *storage; //the interface of the derived port
     Port port;
+    std::string name;
+    vShmWriter shm;
+
+    //coalescing
+    typedef std::chrono::steady_clock clock;
+    bool coalescing;
+    size_t max_bytes;
+    unsigned int max_events;
+    clock::duration max_latency;
+    std::vector<std::int32_t> pending;
+    unsigned int pending_ints;
+    unsigned int pending_events;
+    clock::time_point pending_since;
+    Stamp pending_envelope;
+    vBatchStats stats;
+    std::mutex pending_mutex;
+    std::condition_variable pending_cv;
+    std::thread flusher;
+    bool flusher_stop;
+    vTrace pending_trace;
+
+    //the trace to send with the next packet written
+    vTrace next_trace;
+
+    //asynchronous sending: packets are encoded by the writing thread into a
+    //free buffer, which is queued for the send thread and then returned
+    struct encodedPacket {
+        std::vector<std::int32_t> data;
+        unsigned int ints;
+        Stamp envelope;
+        vTrace trace;
+    };
+    typedef std::list<encodedPacket>::iterator slot_t;
+    bool async;
+    asyncPolicy async_policy;
+    std::list<encodedPacket> free_slots;
+    std::list<encodedPacket> ready_slots;
+    std::list<encodedPacket> busy_slots;
+    std::mutex async_mutex;
+    std::condition_variable async_ready;
+    std::condition_variable async_free;
+    std::thread sender;
+    bool sender_stop;
+    unsigned int async_dropped;
+
+    /// \brief take a free buffer to encode a packet into, according to the
+    /// asyncPolicy if there is none. Returns false if the packet is dropped.
+    bool acquireSlot(slot_t &slot)
+    {
+        std::unique_lock<std::mutex> lock(async_mutex);
+        if(free_slots.empty()) {
+            if(async_policy == ASYNC_DROP) {
+                async_dropped++;
+                return false;
+            }
+            if(async_policy == ASYNC_GROW)
+                free_slots.emplace_back();
+            else
+                async_free.wait(lock, [this]{ return !free_slots.empty(); });
+        }
+        slot = free_slots.begin();
+        busy_slots.splice(busy_slots.begin(), free_slots, slot);
+        return true;
+    }
+
+    /// \brief pass an encoded buffer to the send thread
+    void queueSlot(slot_t slot)
+    {
+        std::lock_guard<std::mutex> lock(async_mutex);
+        ready_slots.splice(ready_slots.end(), busy_slots, slot);
+        async_ready.notify_one();
+    }
+
+    /// \brief encode a packet with encoder(block) (which returns the number
+    /// of ints) into a buffer and queue it to be sent
+    template <class E> bool sendAsync(const Stamp &envelope, vTrace &trace,
+                                      E encoder)
+    {
+        slot_t slot;
+        if(!acquireSlot(slot))
+            return false;
+        std::uint64_t t0 = steadyNanos();
+        slot->ints = encoder(slot->data);
+        encode_hist.record(steadyNanos() - t0);
+        slot->envelope = envelope;
+        slot->trace.swap(trace);
+        queueSlot(slot);
+        return true;
+    }
+
+    /// \brief send the queued buffers until stopped with none queued
+    void sendLoop()
+    {
+        std::unique_lock<std::mutex> lock(async_mutex);
+        while(true) {
+            async_ready.wait(lock, [this]{
+                return sender_stop || !ready_slots.empty(); });
+            if(ready_slots.empty())
+                return;
+            slot_t slot = ready_slots.begin();
+            busy_slots.splice(busy_slots.begin(), ready_slots, slot);
+            lock.unlock();
+
+            if(slot->ints) {
+                storage->setExternalData((const char *)slot->data.data(),
+                                         slot->ints * sizeof(std::int32_t));
+                send(*storage, slot->envelope, slot->trace);
+            }
+            slot->trace.clear();
+
+            lock.lock();
+            free_slots.splice(free_slots.end(), busy_slots, slot);
+            async_free.notify_one();
+        }
+    }
+
+    /// \brief send the queued buffers and stop the send thread
+    void stopSender()
+    {
+        if(!sender.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(async_mutex);
+            sender_stop = true;
+            async_ready.notify_one();
+        }
+        sender.join();
+        sender_stop = false;
+    }
+
+    //distributions of the time to encode and to send a packet (ns) and of
+    //the packet size (bytes)
+    vHistogram encode_hist;
+    vHistogram send_hist;
+    vHistogram bytes_hist;
+
+    /// \brief write events q with the interface S, coalesced, from the send
+    /// thread or immediately
+    template <class S, class Q> bool writeWith(S &interface, const Q &q,
+                                               Stamp &envelope)
+    {
+        vTrace trace;
+        trace.swap(next_trace);
+        if(coalescing) {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            if(!trace.empty())
+                pending_trace.swap(trace);
+            std::uint64_t t0 = steadyNanos();
+            pending_ints = interface.encode(q, pending, pending_ints);
+            encode_hist.record(steadyNanos() - t0);
+            return pended(q.size(), envelope);
+        }
+        if(async)
+            return sendAsync(envelope, trace,
+                             [&](std::vector<std::int32_t> &block) {
+                return interface.encode(q, block, 0); });
+        std::uint64_t t0 = steadyNanos();
+        interface.setInternalData(q);
+        encode_hist.record(steadyNanos() - t0);
+        return send(interface, envelope, trace);
+    }
+
+    enum flushReason { FLUSH_BYTES, FLUSH_EVENTS, FLUSH_LATENCY, FLUSH_CALL };
+
+    /// \brief send the pending events (pending_mutex is locked)
+    bool flushPending(flushReason reason)
+    {
+        if(!pending_events)
+            return true;
+
+        bool ok = true;
+        if(pending_ints && async) {
+            //hand the pending buffer itself to the send thread
+            slot_t slot;
+            ok = acquireSlot(slot);
+            if(ok) {
+                slot->data.swap(pending);
+                slot->ints = pending_ints;
+                slot->envelope = pending_envelope;
+                slot->trace.swap(pending_trace);
+                queueSlot(slot);
+            }
+        } else if(pending_ints) {
+            storage->setExternalData((const char *)pending.data(),
+                                     pending_ints * sizeof(std::int32_t));
+            ok = send(*storage, pending_envelope, pending_trace);
+        }
+        pending_trace.clear();
+
+        //a batch dropped by ASYNC_DROP is counted in async_dropped only
+        if(ok) {
+            stats.batches++;
+            stats.events += pending_events;
+            stats.bytes += pending_ints * sizeof(std::int32_t);
+            switch(reason) {
+            case FLUSH_BYTES: stats.by_bytes++; break;
+            case FLUSH_EVENTS: stats.by_events++; break;
+            case FLUSH_LATENCY: stats.by_latency++; break;
+            default: stats.by_flush++;
+            }
+        }
+
+        pending_ints = 0;
+        pending_events = 0;
+        return ok;
+    }
+
+    /// \brief n events were encoded into pending (pending_mutex is
+    /// locked). Send them if a limit is reached, otherwise wake the flusher
+    /// to send them within the latency budget.
+    bool pended(unsigned int n, const Stamp &envelope)
+    {
+        stats.writes++;
+        pending_envelope = envelope;
+        if(!n) return true;
+        if(!pending_events) {
+            pending_since = clock::now();
+            pending_cv.notify_one();
+        }
+        pending_events += n;
+
+        if(max_bytes && pending_ints * sizeof(std::int32_t) >= max_bytes)
+            return flushPending(FLUSH_BYTES);
+        if(max_events && pending_events >= max_events)
+            return flushPending(FLUSH_EVENTS);
+        return true;
+    }
+
+    /// \brief send the pending events once they have waited max_latency
+    void flushLoop()
+    {
+        std::unique_lock<std::mutex> lock(pending_mutex);
+        while(!flusher_stop) {
+            if(!pending_events) {
+                pending_cv.wait(lock);
+                continue;
+            }
+            clock::time_point deadline = pending_since + max_latency;
+            if(clock::now() < deadline) {
+                pending_cv.wait_until(lock, deadline);
+                continue;
+            }
+            flushPending(FLUSH_LATENCY);
+        }
+    }
+
+    void stopFlusher()
+    {
+        if(!flusher.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            flusher_stop = true;
+            pending_cv.notify_one();
+        }
+        flusher.join();
+    }
+
+    /// \brief write a packet to the shared memory readers, and to the YARP
+    /// connections if any (or if shared memory is not used). A trace is sent
+    /// with the time the packet left this port.
+    bool send(vGenPortInterface &storage, Stamp &envelope, vTrace &trace)
+    {
+        bool traced = !trace.empty();
+        if(traced) {
+            trace.add(name);
+            storage.setTrace(trace);
+            trace.clear();
+        }
+        std::uint64_t t0 = steadyNanos();
+        bool ok = transmit(storage, envelope);
+        send_hist.record(steadyNanos() - t0);
+        bytes_hist.record(storage.wireSize());
+        if(traced)
+            storage.clearTrace();
+        return ok;
+    }
+
+    bool transmit(const vGenPortInterface &storage, Stamp &envelope)
+    {
+        if(shm.isOpen()) {
+            if(!shm.write(storage, envelope))
+                return false;
+            if(!port.getOutputCount())
+                return true;
+        }
+        if(!port.setEnvelope(envelope))
+            return false;
+        if(!port.write(storage))
+            return false;
+        return true;
+    }
 
 public:
 
+    vGenWritePort() : storage(&internal_storage), coalescing(false),
+        max_bytes(0), max_events(0), pending_ints(0), pending_events(0),
+        flusher_stop(false), async(false), async_policy(ASYNC_BLOCK),
+        sender_stop(false), async_dropped(0)
+    {
+        stats = vBatchStats();
+    }
+
+    /// \brief send any pending events and stop the flusher and send threads.
+    /// A derived port whose storage is its own member does this in its own
+    /// destructor, while the storage still exists.
+    ~vGenWritePort()
+    {
+        stopFlusher();
+        flush();
+        stopSender();
+    }
+
     bool open(std::string name)
     {
+        this->name = name;
         return port.open(name);
     }
 
     void close()
     {
+        stopFlusher();
+        flush();
+        stopSender();
+        shm.close();
         port.close();
     }
 
+    /// \brief send the packets from a separate thread, such that write()
+    /// returns once the events are encoded into one of buffers buffers.
+    /// policy selects what write() does when all buffers are waiting to be
+    /// sent. 0 buffers sends from the writing thread (the default).
+    void setAsync(unsigned int buffers, asyncPolicy policy = ASYNC_BLOCK)
+    {
+        stopSender();
+        std::lock_guard<std::mutex> lock(async_mutex);
+        async = buffers > 0;
+        async_policy = policy;
+        free_slots.resize(buffers);
+        if(async)
+            sender = std::thread(&vGenWritePort::sendLoop, this);
+    }
+
+    /// \brief the number of writes discarded by ASYNC_DROP
+    unsigned int queryAsyncDropped()
+    {
+        std::lock_guard<std::mutex> lock(async_mutex);
+        return async_dropped;
+    }
+
+    /// \brief the number of buffers allocated (increased by ASYNC_GROW)
+    size_t queryAsyncBuffers()
+    {
+        std::lock_guard<std::mutex> lock(async_mutex);
+        return free_slots.size() + ready_slots.size() + busy_slots.size();
+    }
+
+    /// \brief accumulate the events written and send them together once
+    /// max_bytes of data or max_events are accumulated, or the first event
+    /// waiting has waited latency_us microseconds. A limit of 0 is not
+    /// applied. The envelope sent is the envelope of the last write. A
+    /// latency of 0 sends every write immediately (the default).
+    void setCoalescing(double latency_us, unsigned int max_events = 0,
+                       size_t max_bytes = 0)
+    {
+        stopFlusher();
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        flushPending(FLUSH_CALL);
+        coalescing = latency_us > 0;
+        this->max_events = max_events;
+        this->max_bytes = max_bytes;
+        max_latency = std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<double, std::micro>(latency_us));
+        if(coalescing) {
+            flusher_stop = false;
+            flusher = std::thread(&vGenWritePort::flushLoop, this);
+        }
+    }
+
+    /// \brief send any events accumulated by a coalescing port now
+    bool flush()
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        return flushPending(FLUSH_CALL);
+    }
+
+    /// \brief the batches sent by a coalescing port
+    vBatchStats queryBatchStats()
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        return stats;
+    }
+
+    std::string batchStatString()
+    {
+        vBatchStats s = queryBatchStats();
+        double b = s.batches ? s.batches : 1;
+        std::ostringstream oss;
+        oss << "batches: " << s.batches << " events/batch: " << s.events / b
+            << " bytes/batch: " << s.bytes / b << " writes/batch: "
+            << s.writes / b << " (bytes " << s.by_bytes << " events "
+            << s.by_events << " latency " << s.by_latency << " flush "
+            << s.by_flush << ")";
+        return oss.str();
+    }
+
+    /// \brief also publish the packets in a shared memory ring of bytes,
+    /// that readers on the same host attach to with connectFrom(name).
+    /// YARP connections (e.g. to remote readers) continue to be written.
+    /// Call after open().
+    bool enableSharedMemory(size_t bytes = 16 * 1024 * 1024)
+    {
+        if(name.empty()) {
+            yError() << "Open the port before enabling shared memory";
+            return false;
+        }
+        return shm.open(name, bytes);
+    }
+
+    /// \brief the number of readers attached through shared memory
+    int getSharedMemoryCount()
+    {
+        return shm.queryReaders();
+    }
+
     void setWriteType(std::string tag)
     {
         internal_storage.setHeader(tag);
     }
 
+    /// \brief send compressed packets (see vGenPortInterface::setCompression)
+    void setCompression(bool compress, bool lz = false)
+    {
+        internal_storage.setCompression(compress, lz);
+    }
+
     bool write(const vQueue &q, Stamp envelope)
     {
-        internal_storage.setInternalData(q);
-        if(!port.setEnvelope(envelope))
-            return false;
-        if(!port.write(internal_storage))
-            return false;
-        return true;
+        return writeWith(internal_storage, q, envelope);
+    }
 
+    /// \brief send trace with the next packet written (coalesced with the
+    /// following writes if coalescing), adding the time the packet is sent
+    /// from this port. Call from the writing thread before write().
+    void setTrace(const vTrace &trace)
+    {
+        next_trace = trace;
+    }
+
+    /// \brief publish the distributions of the encode and send times (us)
+    /// and of the packet size (bytes) as <name>/encode_us, <name>/send_us and
+    /// <name>/bytes. name defaults to the port name.
+    void registerStats(vStatsPublisher &stats, std::string name = "")
+    {
+        if(name.empty()) name = this->name;
+        stats.add(name + "/encode_us", &encode_hist, 1e-3);
+        stats.add(name + "/send_us", &send_hist, 1e-3);
+        stats.add(name + "/bytes", &bytes_hist);
     }
 
     int getOutputCount() {
@@ -315,77 +1100,183 @@ protected:
     vPortInterface<T> internal_storage;
 
 public:
+
+    vWritePort()
+    {
+        storage = &internal_storage;
+    }
+
+    ~vWritePort()
+    {
+        stopFlusher();
+        flush();
+        stopSender();
+    }
+
     using vGenWritePort::open;
     using vGenWritePort::close;
+    using vGenWritePort::setCoalescing;
+    using vGenWritePort::flush;
+    using vGenWritePort::queryBatchStats;
+    using vGenWritePort::batchStatString;
+    using vGenWritePort::setAsync;
+    using vGenWritePort::queryAsyncDropped;
+    using vGenWritePort::queryAsyncBuffers;
+    using vGenWritePort::enableSharedMemory;
+    using vGenWritePort::getSharedMemoryCount;
+    using vGenWritePort::registerStats;
+    using vGenWritePort::setTrace;
+
+    /// \brief set the address layout of the AddressEvents written
+    void setCodecLayout(codecLayout layout)
+    {
+        internal_storage.setCodecLayout(layout);
+    }
+
+    /// \brief send compressed packets (see vGenPortInterface::setCompression)
+    void setCompression(bool compress, bool lz = false)
+    {
+        internal_storage.setCompression(compress, lz);
+    }
 
     bool write(const std::deque<T> &q, Stamp envelope)
     {
-        internal_storage.setInternalData(q);
-        if(!port.setEnvelope(envelope))
-            return false;
-        if(!port.write(internal_storage))
-            return false;
-        return true;
+        return writeWith(internal_storage, q, envelope);
+    }
 
+    bool write(const vPacket<T> &p, Stamp envelope)
+    {
+        return writeWith(internal_storage, p, envelope);
     }
 
 };
 
-/// \brief an asynchronous reading port that accepts vBottles and decodes them
-class vGenReadPort : public yarp::os::Thread
+/// \brief the reading thread of the asynchronous read ports. Each packet is
+/// read by the interface I into a container C held in a fixed size ring, and
+/// handed to the processing thread without locking or allocating memory. A
+/// container is re-used once the processing thread has finished with it (at
+/// the next read). If the ring is full the packet read is dropped. When the
+/// processing thread falls behind, the packets waiting are discarded at each
+/// read according to a vDropPolicy.
+template <class C, class I> class vReadPortBase : public yarp::os::Thread
 {
 protected:
 
-    vGenPortInterface internal_storage;
+    //a packet with its envelope and duration
+    struct packet {
+        C q;
+        yarp::os::Stamp stamp;
+        int dt;
+        std::uint64_t arrival; //steadyNanos() when queued
+        vTrace trace;
+        packet() : dt(0), arrival(0) {}
+    };
+
+    I internal_storage;
     Port port;
+    std::string name;
+    std::string source;
+    vShmReader shm;
 
-    std::deque< vQueue* > qq;
-    std::deque<yarp::os::Stamp> sq;
-    vQueue *working_queue;
-
-    yarp::os::Mutex m;
-    yarp::os::Semaphore dataavailable;
+    vRing<packet> ring;
+    packet spare; //read into when the ring is full
+    std::atomic<bool> working;
 
     unsigned int qlimit;
-    unsigned int delay_nv;
-    long unsigned int delay_t;
-    double event_rate;
+    double spin;
+    std::atomic<unsigned int> delay_nv;
+    std::atomic<std::int64_t> delay_t;
+    std::atomic<double> event_rate;
+    std::atomic<unsigned int> dropped;
+    vDropPolicy policy;
+
+    //distributions of the time a packet waits to be read and to decode a
+    //packet (ns), and of the packet size (events) and event rate (events/s)
+    vHistogram wait_hist;
+    vHistogram decode_hist;
+    vHistogram size_hist;
+    vHistogram rate_hist;
+
+    /// \brief count the packet read in the distributions
+    void recordPacket(const C &q, int dt)
+    {
+        decode_hist.record(internal_storage.decode_ns);
+        size_hist.record(q.size());
+        if(dt > 0)
+            rate_hist.record(q.size() * vtsHelper::vtsscaler / dt);
+    }
+
+    //the waiting packets as seen by the vDropPolicy
+    struct backlog {
+        vReadPortBase &port;
+        backlog(vReadPortBase &port) : port(port) {}
+        size_t size() { return port.ring.size(); }
+        C& at(size_t i) { return port.ring.at(i).q; }
+        C& modify(size_t i) { return port.ring.at(i).q; }
+        void pop() { port.popFront(); }
+        void update(size_t i, size_t n, int dt)
+        {
+            packet &p = port.ring.at(i);
+            p.dt = packetDuration(p.q);
+            port.delay_nv -= n - p.q.size();
+            port.delay_t -= dt - p.dt;
+        }
+    };
+
+    void popFront()
+    {
+        packet &p = ring.front();
+        delay_nv -= p.q.size();
+        delay_t -= p.dt;
+        p.q.clear();
+        ring.pop();
+    }
 
+    /// \brief read the next packet from shared memory or the YARP port
+    bool readPacket(yarp::os::Stamp &stamp)
+    {
+        if(!shm.isOpen()) {
+            if(!port.read(internal_storage))
+                return false;
+            port.getEnvelope(stamp);
+            return true;
+        }
+
+        const char *data;
+        size_t size;
+        while(shm.read(data, size, stamp)) {
+            if(internal_storage.read(data, size))
+                return true;
+            yError() << "Could not decode packet from shared memory";
+        }
+        return false;
+    }
 
 public:
 
     /// \brief constructor
-    vGenReadPort()
+    vReadPortBase() : working(false), delay_nv(0), delay_t(0), event_rate(0),
+        dropped(0)
     {
         qlimit = 0;
-        delay_nv = 0;
-        delay_t = 0;
-        event_rate = 0;
-        working_queue = nullptr;
+        spin = 0;
 
         setPriority(99, SCHED_FIFO);
-
-        dataavailable.wait(); //init counter to 0
-    }
-
-    /// \brief desctructor
-    ~vGenReadPort()
-    {
-        m.lock();
-        std::deque< vQueue* >::iterator i;
-        for(i = qq.begin(); i != qq.end(); i++)
-            delete *i;
-        qq.clear();
-        m.unlock();
     }
 
     bool open(std::string name)
     {
         //port.setTimeout(1.0);
         if(!port.open(name)) {
-            yError() << "Could not open vGenReadPort input port: " << name;
+            yError() << "Could not open read port: " << name;
             return false;
         }
+        this->name = name;
+        if(source.size() && !shm.open(source)) {
+            yInfo() << "No shared memory for" << source << "- using YARP";
+            if(!yarp::os::Network::connect(source, name))
+                yWarning() << "Could not connect" << source << "to" << name;
+        }
         start();
         return true;
     }
@@ -393,111 +1284,155 @@ public:
     void close()
     {
         port.interrupt();
+        shm.release();
         this->stop();
         port.close();
+        shm.close();
         this->releaseDataLock();
     }
 
+    /// \brief read from the writing port source. If source is on this host
+    /// and has shared memory enabled its packets are read from shared memory
+    /// (and the YARP port receives nothing), otherwise source is connected to
+    /// this port with YARP. Call before open().
+    void connectFrom(std::string source)
+    {
+        this->source = source;
+    }
+
+    /// \brief true if reading from shared memory
+    bool isSharedMemory()
+    {
+        return shm.isOpen();
+    }
+
     void run()
     {
-        while(true) {
+        while(!isStopping()) {
 
-            vQueue *next_queue = new vQueue;
-            internal_storage.setReadContainer(*next_queue);
-            //internal_storage.setReadQueue(*next_queue);
-            if(!port.read(internal_storage)) {
-                yInfo() << "vGenReadPort read return false. closing.";
-                delete next_queue;
+            //if the ring is full read anyway to keep the connection flowing
+            bool full = ring.full();
+            packet &next = full ? spare : ring.back();
+            next.q.clear();
+            internal_storage.setReadContainer(next.q);
+            if(!readPacket(next.stamp)) {
+                yInfo() << "read port: read return false. closing.";
                 break;
             }
 
-            yarp::os::Stamp yarp_stamp;
-            port.getEnvelope(yarp_stamp);
+            if(next.q.empty())
+                continue;
 
-            if(qlimit && qq.size() >= qlimit) {
-                delete next_queue;
+            if(ring.full() || (qlimit && ring.size() >= qlimit)) {
+                dropped++;
                 continue;
             }
 
-            m.lock();
+            //the ring was emptied during the read
+            if(full) {
+                std::swap(ring.back().q, spare.q);
+                ring.back().stamp = spare.stamp;
+            }
 
-            qq.push_back(next_queue);
-            sq.push_back(yarp_stamp);
+            packet &p = ring.back();
+            p.dt = packetDuration(p.q);
+            p.arrival = steadyNanos();
+            p.trace = internal_storage.getTrace();
+            if(!p.trace.empty())
+                p.trace.add(name);
+            recordPacket(p.q, p.dt);
 
-            delay_nv += qq.back()->size();
-            int dt = qq.back()->back()->stamp - qq.back()->front()->stamp;
-            if(dt < 0) dt += vtsHelper::max_stamp;
-            delay_t += dt;
-            if(dt)
-                event_rate = qq.back()->size() / (double)dt;
+            delay_nv += p.q.size();
+            delay_t += p.dt;
+            if(p.dt)
+                event_rate = p.q.size() / (double)p.dt;
 
-            m.unlock();
-            dataavailable.post();
+            //if read is blocking - let it get the new data
+            ring.push();
 
         }
 
     }
 
-    /// \brief ask for a pointer to the next vQueue. Blocks if no data is ready.
-    const vQueue* read(yarp::os::Stamp &yarpstamp)
+    /// \brief ask for a pointer to the next packet. Blocks if no data is
+    /// ready. The packet is valid until the next call to read.
+    const C* read(yarp::os::Stamp &yarpstamp)
     {
-        if(working_queue) {
-            m.lock();
-
-            delay_nv -= qq.front()->size();
-            int dt = qq.front()->back()->stamp - qq.front()->front()->stamp;
-            if(dt < 0) dt += vtsHelper::max_stamp;
-            delay_t -= dt;
-
-            delete qq.front();
-            qq.pop_front();
-            sq.pop_front();
-            m.unlock();
+        if(working) {
+            popFront();
+            working = false;
         }
 
-        dataavailable.wait();
+        if(!ring.wait(spin))
+            return 0;
 
-        if(qq.size()) {
-            yarpstamp = sq.front();
-            working_queue = qq.front();
-        }  else {
-            working_queue =  0;
-        }
+        backlog b(*this);
+        policy.apply(b);
 
-        return working_queue;
+        packet &p = ring.front();
+        wait_hist.record(steadyNanos() - p.arrival);
+        yarpstamp = p.stamp;
+        working = true;
+        return &p.q;
+    }
 
+    /// \brief the trace of the packet given by the last read, with the time
+    /// it arrived at this port. Empty if the packet was not traced.
+    const vTrace& queryTrace()
+    {
+        static const vTrace none;
+        return working ? ring.front().trace : none;
     }
 
-    /// \brief set the maximum number of qs that can be stored in the buffer.
-    /// A value of 0 keeps all qs.
+    /// \brief set the maximum number of packets that can be stored in the
+    /// buffer. A value of 0 keeps packets until the buffer is full.
     void setQLimit(unsigned int number_of_qs)
     {
         qlimit = number_of_qs;
     }
 
-    /// \brief unBlocks the blocking call in getNextQ. Useful to ensure a
-    /// graceful shutdown. No guarantee the return of getNextQ will be valid.
+    /// \brief set what is discarded when the processing falls behind (see
+    /// vDropPolicy::set for the meaning of value). Call before open().
+    void setDropPolicy(dropPolicy policy, double value)
+    {
+        this->policy.set(policy, value);
+    }
+
+    /// \brief set the number of packets the buffer holds (default 512).
+    /// Call before open().
+    void setBufferSize(unsigned int number_of_qs)
+    {
+        ring.resize(number_of_qs);
+    }
+
+    /// \brief poll for new data for up to seconds before sleeping in read.
+    /// Reduces the latency of waking the processing thread at the cost of
+    /// CPU time.
+    void setSpinTime(double seconds)
+    {
+        spin = seconds;
+    }
+
+    /// \brief unBlocks the blocking call in read. Useful to ensure a
+    /// graceful shutdown. No guarantee the return of read will be valid.
     void releaseDataLock()
     {
-        dataavailable.post();
+        ring.release();
     }
 
-    /// \brief ask for the number of vQueues currently allocated.
+    /// \brief ask for the number of packets currently stored.
     unsigned int queryunprocessed()
     {
-        if(working_queue)
-            return qq.size() - 1;
-        else
-            return qq.size();
+        return ring.size() - (working ? 1 : 0);
     }
 
-    /// \brief ask for the number of events in all vQueues.
+    /// \brief ask for the number of events in all stored packets.
     unsigned int queryDelayN()
     {
         return delay_nv;
     }
 
-    /// \brief ask for the total time spanned by all vQueues.
+    /// \brief ask for the total time spanned by all stored packets.
     double queryDelayT()
     {
         return delay_t * vtsHelper::tsscaler;
@@ -509,6 +1444,24 @@ public:
         return event_rate * vtsHelper::vtsscaler;
     }
 
+    /// \brief ask for the number of packets dropped as the buffer was full
+    unsigned int queryDropped()
+    {
+        return dropped;
+    }
+
+    /// \brief ask for the number of packets discarded by the drop policy
+    unsigned int queryDiscardedPackets()
+    {
+        return policy.queryDroppedPackets();
+    }
+
+    /// \brief ask for the number of events discarded by the drop policy
+    unsigned int queryDiscardedEvents()
+    {
+        return policy.queryDroppedEvents();
+    }
+
     std::string delayStatString()
     {
         std::ostringstream oss;
@@ -517,119 +1470,142 @@ public:
         return oss.str();
     }
 
-};
+    /// \brief publish the distributions of the time packets wait to be read
+    /// and the decode time (us), and of the packet size (events) and event
+    /// rate (events/s) as <name>/wait_us, <name>/decode_us, <name>/events
+    /// and <name>/rate. name defaults to the port name.
+    void registerStats(vStatsPublisher &stats, std::string name = "")
+    {
+        if(name.empty()) name = this->name;
+        stats.add(name + "/wait_us", &wait_hist, 1e-3);
+        stats.add(name + "/decode_us", &decode_hist, 1e-3);
+        stats.add(name + "/events", &size_hist);
+        stats.add(name + "/rate", &rate_hist);
+    }
 
+};
 
-template <class T> class vReadPort : private vGenReadPort
+/// \brief an asynchronous reading port that accepts vBottles and decodes them
+class vGenReadPort : public vReadPortBase<vQueue, vGenPortInterface>
 {
-protected:
+};
 
-    vPortInterface<T> internal_storage;
-    std::deque< std::vector<T>* > qq;
-    std::vector<T> *working_queue;
+/// \brief an asynchronous reading port that decodes events of type T into a
+/// std::vector
+template <class T> class vReadPort :
+        private vReadPortBase<std::vector<T>, vPortInterface<T> >
+{
+    typedef vReadPortBase<std::vector<T>, vPortInterface<T> > base;
 
 public:
 
-    /// \brief constructor
-    vReadPort() : vGenReadPort()
+    /// \brief set the address layout of the AddressEvents read (e.g. to read
+    /// a DVS128 and an ATIS in the same process). Set before open().
+    void setCodecLayout(codecLayout layout)
     {
-        working_queue = nullptr;
+        this->internal_storage.setCodecLayout(layout);
     }
 
-    /// \brief desctructor
-    ~vReadPort()
-    {
-
-        m.lock();
-        typename std::deque< std::vector<T>* >::iterator i;
-        for(i = qq.begin(); i != qq.end(); i++)
-            delete *i;
-        qq.clear();
-        m.unlock();
-    }
-
-    using vGenReadPort::open;
-    using vGenReadPort::close;
-
-    void run()
-    {
-        while(!isStopping()) {
-
-            std::vector<T> *next_queue = new std::vector<T>;
-            internal_storage.setReadContainer(*next_queue);
-            //internal_storage.setReadQueue(*next_queue);
-            if(!port.read(internal_storage)) {
-                yInfo() << "vReadPort<> read return false. closing.";
-                delete next_queue;
-                break;
-            }
-
-            yarp::os::Stamp yarp_stamp;
-            port.getEnvelope(yarp_stamp);
-
-            if(qlimit && qq.size() >= qlimit) {
-                delete next_queue;
-                continue;
-            }
-
-            m.lock();
-
-            qq.push_back(next_queue);
-            sq.push_back(yarp_stamp);
-
-            delay_nv += qq.back()->size();
-            int dt = qq.back()->back().stamp - qq.back()->front().stamp;
-            if(dt < 0) dt += vtsHelper::max_stamp;
-            delay_t += dt;
-            if(dt)
-                event_rate = qq.back()->size() / (double)dt;
-            m.unlock();
-
-            //if getNextQ is blocking - let it get the new data
-            dataavailable.post();
-
-        }
+    using base::open;
+    using base::close;
+    using base::connectFrom;
+    using base::isSharedMemory;
+    using base::read;
+    using base::setQLimit;
+    using base::setBufferSize;
+    using base::setSpinTime;
+    using base::releaseDataLock;
+    using base::queryunprocessed;
+    using base::queryDelayN;
+    using base::queryDelayT;
+    using base::queryRate;
+    using base::queryDropped;
+    using base::setDropPolicy;
+    using base::queryDiscardedPackets;
+    using base::queryDiscardedEvents;
+    using base::registerStats;
+    using base::queryTrace;
 
+};
 
+/// \brief an asynchronous reading port that decodes events directly into
+/// structure-of-arrays vPackets
+template <class T> class vPacketReadPort :
+        private vReadPortBase<vPacket<T>, vPortInterface<T> >
+{
+    typedef vReadPortBase<vPacket<T>, vPortInterface<T> > base;
 
-    }
+public:
 
-    /// \brief ask for a pointer to the next vQueue. Blocks if no data is ready.
-    const std::vector<T>* read(yarp::os::Stamp &yarpstamp)
+    /// \brief set the address layout of the AddressEvents read (e.g. to read
+    /// a DVS128 and an ATIS in the same process). Set before open().
+    void setCodecLayout(codecLayout layout)
     {
+        this->internal_storage.setCodecLayout(layout);
+    }
 
-        if(working_queue) {
-            m.lock();
-
-            delay_nv -= qq.front()->size();
-            int dt = qq.front()->back().stamp - qq.front()->front().stamp;
-            if(dt < 0) dt += vtsHelper::max_stamp;
-            delay_t -= dt;
+    using base::open;
+    using base::close;
+    using base::connectFrom;
+    using base::isSharedMemory;
+    using base::read;
+    using base::setQLimit;
+    using base::setBufferSize;
+    using base::setSpinTime;
+    using base::releaseDataLock;
+    using base::queryunprocessed;
+    using base::queryDelayN;
+    using base::queryDelayT;
+    using base::queryRate;
+    using base::queryDropped;
+    using base::setDropPolicy;
+    using base::queryDiscardedPackets;
+    using base::queryDiscardedEvents;
+    using base::registerStats;
+    using base::queryTrace;
 
-            delete qq.front();
-            qq.pop_front();
-            sq.pop_front();
-            m.unlock();
-        }
+};
 
-        dataavailable.wait();
+/// \brief an asynchronous reading port that gives read-only vPacketViews of
+/// the packets received, of any event-type. Events are decoded only as the
+/// view is iterated, e.g.
+///
+/// const vPacketView *view = port.read(ystamp);
+/// for(auto v = view->begin<AE>(); v != view->end<AE>(); v++) v->x ...
+///
+/// A copy of the view can be kept after the next read.
+class vViewReadPort : private vReadPortBase<vPacketView, vViewPortInterface>
+{
+    typedef vReadPortBase<vPacketView, vViewPortInterface> base;
 
-        if(qq.size()) {
-            yarpstamp = sq.front();
-            working_queue = qq.front();
-        }  else {
-            working_queue =  0;
-        }
-        return working_queue;
+public:
 
+    /// \brief set the address layout of the AddressEvents read. Set before
+    /// open().
+    void setCodecLayout(codecLayout layout)
+    {
+        internal_storage.setCodecLayout(layout);
     }
 
-    using vGenReadPort::setQLimit;
-    using vGenReadPort::releaseDataLock;
-    using vGenReadPort::queryunprocessed;
-    using vGenReadPort::queryDelayN;
-    using vGenReadPort::queryDelayT;
-    using vGenReadPort::queryRate;
+    using base::open;
+    using base::close;
+    using base::connectFrom;
+    using base::isSharedMemory;
+    using base::read;
+    using base::setQLimit;
+    using base::setBufferSize;
+    using base::setSpinTime;
+    using base::releaseDataLock;
+    using base::queryunprocessed;
+    using base::queryDelayN;
+    using base::queryDelayT;
+    using base::queryRate;
+    using base::queryDropped;
+    using base::setDropPolicy;
+    using base::queryDiscardedPackets;
+    using base::queryDiscardedEvents;
+    using base::registerStats;
+    using base::queryTrace;
 
 };
 
@@ -0,0 +1,163 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VRING__
+#define __VRING__
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+
+namespace ev {
+
+/// \brief a fixed capacity ring of reusable elements passed from a single
+/// producer thread to a single consumer thread. The producer fills the
+/// element at back() and publishes it with push(), the consumer processes
+/// the element at front() and returns it with pop(). Neither side takes a
+/// lock, except for the consumer to sleep in wait() when the ring is empty.
+template <class T> class vRing
+{
+private:
+
+    std::vector<T> slots;
+    size_t mask;
+
+    //written by the producer / the consumer only, padded onto separate
+    //cache lines
+    std::atomic<size_t> head;
+    char pad1[64];
+    std::atomic<size_t> tail;
+    char pad2[64];
+
+    //sleeping consumer
+    std::atomic<bool> waiting;
+    std::atomic<int> releases;
+    std::mutex m;
+    std::condition_variable cv;
+
+public:
+
+    /// \brief a ring with space for capacity elements (rounded up to a power
+    /// of 2)
+    vRing(size_t capacity = 512) : head(0), tail(0), waiting(false), releases(0)
+    {
+        resize(capacity);
+    }
+
+    /// \brief set the capacity of an empty ring. Not thread safe.
+    void resize(size_t capacity)
+    {
+        size_t n = 1;
+        while(n < capacity) n <<= 1;
+        slots.clear();
+        slots.resize(n);
+        mask = n - 1;
+        head.store(0);
+        tail.store(0);
+    }
+
+    /// \brief the number of elements the ring can hold
+    size_t capacity() const { return slots.size(); }
+
+    /// \brief the number of elements pushed and not yet popped
+    size_t size() const
+    {
+        return head.load(std::memory_order_acquire) -
+                tail.load(std::memory_order_acquire);
+    }
+
+    /// \brief true if there is no element to pop
+    bool empty() const { return size() == 0; }
+
+    /// \brief (producer) true if there is no element to fill
+    bool full() const { return size() == slots.size(); }
+
+    /// \brief (producer) the element to fill next. Check full() first.
+    T& back() { return slots[head.load(std::memory_order_relaxed) & mask]; }
+
+    /// \brief (producer) publish the element at back() and wake the consumer
+    void push()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(waiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(m);
+            cv.notify_one();
+        }
+    }
+
+    /// \brief (consumer) the oldest element. Check empty() first.
+    T& front() { return slots[tail.load(std::memory_order_relaxed) & mask]; }
+
+    /// \brief (consumer) the i-th oldest element (i < size())
+    T& at(size_t i)
+    {
+        return slots[(tail.load(std::memory_order_relaxed) + i) & mask];
+    }
+
+    /// \brief (consumer) return the element at front() to the producer
+    void pop()
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+    }
+
+    /// \brief (consumer) wait until an element is available. The ring is
+    /// polled for spin seconds before sleeping. Returns false if woken by
+    /// release() with the ring empty.
+    bool wait(double spin = 0.0)
+    {
+        if(!empty()) return true;
+
+        if(spin > 0) {
+            auto until = std::chrono::steady_clock::now() +
+                    std::chrono::duration<double>(spin);
+            while(std::chrono::steady_clock::now() < until) {
+                if(!empty()) return true;
+                if(releases.load(std::memory_order_relaxed)) break;
+                std::this_thread::yield();
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(m);
+        waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cv.wait(lock, [this]{ return !empty() || releases.load() > 0; });
+        waiting.store(false, std::memory_order_relaxed);
+
+        if(!empty()) return true;
+        releases--;
+        return false;
+    }
+
+    /// \brief wake the consumer from wait() even if the ring is empty
+    void release()
+    {
+        releases++;
+        std::lock_guard<std::mutex> lock(m);
+        cv.notify_all();
+    }
+};
+
+}
+
+#endif
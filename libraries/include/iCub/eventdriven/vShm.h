@@ -0,0 +1,194 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VSHM__
+#define __VSHM__
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <yarp/os/all.h>
+
+namespace ev {
+
+/// \brief reads the packet format of the port interfaces from memory, with
+/// the same calls used on a yarp::os::ConnectionReader
+class vMemoryReader
+{
+private:
+
+    const char *data;
+    size_t size;
+    size_t pos;
+    bool error;
+
+public:
+
+    vMemoryReader(const char *data, size_t size) :
+        data(data), size(size), pos(0), error(false) {}
+
+    int expectInt()
+    {
+        std::int32_t v = 0;
+        expectBlock((char *)&v, sizeof(v));
+        return v;
+    }
+
+    bool expectBlock(char *dst, size_t n)
+    {
+        if(error || n > size - pos) {
+            error = true;
+            return false;
+        }
+        std::memcpy(dst, data + pos, n);
+        pos += n;
+        return true;
+    }
+
+    bool isError() const { return error; }
+};
+
+/// \brief writes the packet format of the port interfaces to memory, with
+/// the same calls used on a yarp::os::ConnectionWriter
+class vMemoryWriter
+{
+private:
+
+    char *data;
+
+public:
+
+    vMemoryWriter(char *data) : data(data) {}
+
+    void appendBlock(const char *src, size_t n)
+    {
+        std::memcpy(data, src, n);
+        data += n;
+    }
+
+    bool isError() const { return false; }
+};
+
+//the layout of a shared memory segment
+struct vShmHeader;
+
+/// \brief the name of the shared memory segment of a port
+std::string shmSegmentName(const std::string &portname);
+
+/// \brief publishes packets in a shared memory ring that any number of
+/// vShmReaders on the same host can attach to by the name of the port. The
+/// writer never waits for the readers: a reader that falls a full ring
+/// behind skips to the latest packet. Readers waiting for data are woken
+/// with a futex. Only available on linux.
+class vShmWriter
+{
+private:
+
+    std::string name;
+    vShmHeader *header;
+    char *ring;
+    size_t mapped;
+    std::uint64_t head;
+
+    //the record being written
+    std::uint64_t pending_pos;
+    size_t pending_total;
+
+public:
+
+    vShmWriter();
+    ~vShmWriter();
+
+    /// \brief create the segment of port portname holding up to bytes of
+    /// packets. An existing segment of the same name is replaced.
+    bool open(const std::string &portname, size_t bytes);
+
+    /// \brief wake any reader and remove the segment
+    void close();
+
+    /// \brief true if the segment is open
+    bool isOpen() const { return header != nullptr; }
+
+    /// \brief the number of readers attached
+    unsigned int queryReaders() const;
+
+    /// \brief write the packet p (a port interface) with its envelope
+    template <class P> bool write(const P &p, const yarp::os::Stamp &envelope)
+    {
+        size_t n = p.wireSize();
+        char *record = prepare(n, envelope);
+        if(!record) return false;
+        vMemoryWriter writer(record);
+        p.writeTo(writer);
+        publish();
+        return true;
+    }
+
+    /// \brief the memory to write a packet of n bytes to, followed by a
+    /// call to publish(). Returns nullptr if the packet does not fit.
+    char * prepare(size_t n, const yarp::os::Stamp &envelope);
+
+    /// \brief make the packet written to prepare() visible to the readers
+    void publish();
+};
+
+/// \brief reads the packets of a vShmWriter
+class vShmReader
+{
+private:
+
+    vShmHeader *header;
+    char *ring;
+    size_t mapped;
+    std::uint64_t tail;
+    std::vector<char> record;
+    std::atomic<bool> released;
+    unsigned int dropped;
+
+public:
+
+    vShmReader();
+    ~vShmReader();
+
+    /// \brief attach to the segment of the writing port portname. Fails if
+    /// there is no such segment on this host, or its writer has exited.
+    bool open(const std::string &portname);
+
+    /// \brief detach from the segment
+    void close();
+
+    /// \brief true if attached to a segment
+    bool isOpen() const { return header != nullptr; }
+
+    /// \brief wait for the next packet. data is valid until the next call.
+    /// Returns false if the writer closed or release() was called.
+    bool read(const char *&data, size_t &size, yarp::os::Stamp &envelope);
+
+    /// \brief wake the blocking call in read
+    void release();
+
+    /// \brief the number of times the reader fell a full ring behind and
+    /// skipped to the latest packet
+    unsigned int queryDropped() const { return dropped; }
+};
+
+}
+
+#endif
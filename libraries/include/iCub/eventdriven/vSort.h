@@ -0,0 +1,54 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VSORT__
+#define __VSORT__
+
+#include "iCub/eventdriven/vCodec.h"
+
+namespace ev {
+
+/// \brief the algorithms used to sort a vQueue into temporal order
+enum sortMethod {
+    SORT_AUTO = 0,  //chosen from the size and the sorted runs of the queue
+    SORT_STD = 1,   //std::sort with a timestamp comparison
+    SORT_MERGE = 2, //merge of the sorted (or reverse sorted) runs
+    SORT_RADIX = 3  //LSD radix sort of the timestamps
+};
+
+/// \brief sort a vQueue into temporal order using a specific method. With
+/// respectWraps the timestamps are ordered relative to the first event, such
+/// that a stamp more than half the timestamp range away has wrapped. Except
+/// SORT_STD the sort is stable.
+void qsort(vQueue &q, bool respectWraps, sortMethod method);
+
+/// \brief keep only the n most recent events of q, in temporal order. The
+/// result is the same as qsort(q, respectWraps) followed by removing all but
+/// the last n events, but the events that are removed are not sorted.
+void qsortNewest(vQueue &q, size_t n, bool respectWraps = false);
+
+/// \brief true if e1 occurs before e2
+bool temporalSortStraight(const event<> &e1, const event<> &e2);
+
+/// \brief true if e1 occurs before e2, where a difference of more than half
+/// the timestamp range is considered a wrap
+bool temporalSortWrap(const event<> &e1, const event<> &e2);
+
+}
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VSTATS__
+#define __VSTATS__
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <yarp/os/all.h>
+
+namespace ev {
+
+/// \brief the time in nanoseconds of a steady clock, to measure intervals
+inline std::uint64_t steadyNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// \brief the counts of a vHistogram taken over a period
+struct vHistogramSnapshot
+{
+    std::vector<std::uint64_t> counts;
+    std::uint64_t total;
+    std::uint64_t maximum;
+
+    vHistogramSnapshot() : total(0), maximum(0) {}
+
+    /// \brief the value below which percent % of the values recorded fall,
+    /// within the precision of the buckets (rounded up)
+    std::uint64_t percentile(double percent) const;
+};
+
+/// \brief a histogram of unsigned values with logarithmic buckets (as an
+/// HdrHistogram): each power of two is divided into 16 linear buckets, so
+/// the values are counted with a precision of 1/16 (6%) over the full range
+/// of 64 bits. Any number of threads record values without a lock.
+class vHistogram
+{
+public:
+
+    static const int sub_bits = 4;
+    static const int sub_count = 1 << sub_bits;
+    static const int buckets = (64 - sub_bits) * sub_count + 2 * sub_count;
+
+    /// \brief the bucket counting value
+    static int bucketOf(std::uint64_t value)
+    {
+        int msb = 63;
+#ifdef __GNUC__
+        if(!value) return 0;
+        msb -= __builtin_clzll(value);
+#else
+        while(msb > 0 && !(value >> msb)) msb--;
+#endif
+        int shift = msb > sub_bits ? msb - sub_bits : 0;
+        return (shift << sub_bits) + (int)(value >> shift);
+    }
+
+    /// \brief the smallest value counted by bucket
+    static std::uint64_t lowestOf(int bucket)
+    {
+        if(bucket < 2 * sub_count) return bucket;
+        int shift = (bucket >> sub_bits) - 1;
+        return (std::uint64_t)((bucket & (sub_count - 1)) + sub_count) << shift;
+    }
+
+private:
+
+    std::atomic<std::uint64_t> counts[buckets];
+    std::atomic<std::uint64_t> maximum;
+
+public:
+
+    vHistogram();
+
+    /// \brief count a value
+    void record(std::uint64_t value)
+    {
+        counts[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t m = maximum.load(std::memory_order_relaxed);
+        while(value > m && !maximum.compare_exchange_weak(m, value,
+                                                          std::memory_order_relaxed));
+    }
+
+    /// \brief the values counted since the previous take, resetting the
+    /// counts. Each value is in exactly one snapshot.
+    vHistogramSnapshot take();
+};
+
+/// \brief publishes the percentiles of a set of vHistograms on the port
+/// /<module>/stats:o at a fixed period. Each period a Bottle is written with
+/// a list per histogram: (name count p50 p90 p99 max), holding the values
+/// recorded during the period multiplied by the scale of the histogram.
+class vStatsPublisher
+{
+private:
+
+    struct entry {
+        std::string name;
+        vHistogram *histogram;
+        double scale;
+    };
+
+    std::vector<entry> entries;
+    std::mutex m;
+    std::condition_variable cv;
+    std::thread publisher;
+    bool stop;
+    double period;
+    yarp::os::BufferedPort<yarp::os::Bottle> port;
+
+    void publishLoop();
+
+public:
+
+    vStatsPublisher();
+    ~vStatsPublisher();
+
+    /// \brief open /<module>/stats:o and publish every period seconds
+    bool open(std::string module, double period = 1.0);
+
+    /// \brief stop publishing and close the port
+    void close();
+
+    /// \brief publish histogram as name. The values are multiplied by
+    /// scale (e.g. 1e-3 for nanoseconds published as microseconds). The
+    /// histogram must exist until the publisher is closed.
+    void add(const std::string &name, vHistogram *histogram,
+             double scale = 1.0);
+
+    /// \brief the percentiles of all histograms since the previous call (or
+    /// publish) as a Bottle
+    yarp::os::Bottle collect();
+};
+
+}
+
+#endif
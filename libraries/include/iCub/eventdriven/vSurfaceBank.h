@@ -0,0 +1,128 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VSURFACEBANK__
+#define __VSURFACEBANK__
+
+#include <vector>
+#include <algorithm>
+#include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vPacket.h"
+#include "iCub/eventdriven/vFlatSurface.h"
+
+namespace ev {
+
+/// \brief a surface for each channel, and for each polarity if polarities
+/// are split, held in a single array. The surface of an event is found from
+/// its channel and polarity by index rather than by choosing between named
+/// surfaces, such that another camera is another channel. S is a surface
+/// with addEvent(stamp, x, y, polarity, channel) and clear(), such as
+/// flatSurface.
+template <typename S = flatSurface> class surfaceBank
+{
+private:
+
+    std::vector<S> planes;
+    int channels;
+    int polarities;
+    int polaritymask;
+
+public:
+
+    ///
+    /// \brief surfaceBank constructor
+    /// \param channels the number of channels (e.g. 2 for a stereo pair)
+    /// \param splitPolarity a surface for each polarity of each channel
+    /// \param args the arguments of the constructor of each surface
+    ///
+    template <typename... Args>
+    surfaceBank(int channels, bool splitPolarity, const Args&... args)
+    {
+        this->channels = std::max(channels, 1);
+        polarities = splitPolarity ? 2 : 1;
+        polaritymask = splitPolarity ? 1 : 0;
+        planes.reserve(this->channels * polarities);
+        for(int i = 0; i < this->channels * polarities; i++)
+            planes.emplace_back(args...);
+    }
+
+    int getChannels() const { return channels; }
+    bool splitsPolarity() const { return polarities == 2; }
+    int size() const { return planes.size(); }
+
+    /// \brief the position of the surface of a channel and polarity
+    int index(int channel, int polarity) const
+    {
+        return channel * polarities + (polarity & polaritymask);
+    }
+
+    /// \brief true if the bank has a surface for the channel
+    bool hasChannel(int channel) const
+    {
+        return (unsigned int)channel < (unsigned int)channels;
+    }
+
+    /// \brief the surface of a channel and polarity (ignored if polarities
+    /// are not split)
+    S& plane(int channel, int polarity = 0)
+    {
+        return planes[index(channel, polarity)];
+    }
+    const S& plane(int channel, int polarity = 0) const
+    {
+        return planes[index(channel, polarity)];
+    }
+
+    S& operator[](int i) { return planes[i]; }
+    const S& operator[](int i) const { return planes[i]; }
+
+    ///
+    /// \brief addEvent adds an event to its surface
+    /// \return the surface, or 0 if the bank has no surface for the channel
+    ///
+    S* addEvent(const AddressEvent &v)
+    {
+        if(!hasChannel(v.channel)) return 0;
+        S &s = planes[index(v.channel, v.polarity)];
+        s.addEvent(v.stamp, v.x, v.y, v.polarity, v.channel);
+        return &s;
+    }
+
+    /// \brief addPacket adds each event of a vPacket to its surface. Events
+    /// of a channel outside the bank are ignored.
+    void addPacket(const vPacket<AE> &p)
+    {
+        for(size_t i = 0; i < p.size(); i++) {
+            if(!hasChannel(p.channel[i])) continue;
+            planes[index(p.channel[i], p.polarity[i])].addEvent(p.stamp[i],
+                    p.x[i], p.y[i], p.polarity[i], p.channel[i]);
+        }
+    }
+
+    /// \brief remove all events of all surfaces
+    void clear()
+    {
+        for(size_t i = 0; i < planes.size(); i++)
+            planes[i].clear();
+    }
+
+};
+
+}
+
+#endif
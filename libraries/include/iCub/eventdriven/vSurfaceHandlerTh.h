@@ -26,6 +26,7 @@
 #include <iCub/eventdriven/vWindow_adv.h>
 #include <iCub/eventdriven/vFilters.h>
 #include <iCub/eventdriven/vPort.h>
+#include <iCub/eventdriven/vHub.h>
 #include <deque>
 #include <string>
 #include <map>
@@ -39,6 +40,7 @@ private:
 
     std::deque<ev::vQueue *> qq;
     std::deque<yarp::os::Stamp> sq;
+    std::deque<vTrace> tq;
     yarp::os::Mutex m;
     yarp::os::Semaphore dataready;
 
@@ -46,6 +48,42 @@ private:
     unsigned int delay_nv;
     long unsigned int delay_t;
     double event_rate;
+    vtsHelper unwrapper;
+    vQueue *working_queue;
+    vTrace working_trace; //the trace of working_queue, copied under m
+    vDropPolicy policy;
+
+    //the waiting vQueues as seen by the vDropPolicy (m is locked)
+    struct backlog {
+        queueAllocator &port;
+        backlog(queueAllocator &port) : port(port) {}
+        size_t size() { return port.qq.size(); }
+        vQueue& at(size_t i) { return *(port.qq[i]); }
+        vQueue& modify(size_t i) { return *(port.qq[i]); }
+        void pop()
+        {
+            port.popFront();
+            //consume the post of the discarded vQueue
+            port.dataready.check();
+        }
+        void update(size_t i, size_t n, int dt)
+        {
+            port.delay_nv -= n - port.qq[i]->size();
+            port.delay_t -= dt - packetDuration(*(port.qq[i]));
+        }
+    };
+
+    //m is locked
+    void popFront()
+    {
+        delay_nv -= qq.front()->size();
+        delay_t -= packetDuration(*(qq.front()));
+
+        delete qq.front();
+        qq.pop_front();
+        sq.pop_front();
+        tq.pop_front();
+    }
 
 public:
 
@@ -56,6 +94,7 @@ public:
         delay_nv = 0;
         delay_t = 0;
         event_rate = 0;
+        working_queue = nullptr;
 
         dataready.wait();
 
@@ -77,32 +116,38 @@ public:
     /// list of received vBottles. The yarp, and event timestamps are updated.
     void onRead(ev::vBottle &inputbottle)
     {
-        //make a new vQueue
         m.lock();
+        bool full = qlimit && qq.size() >= qlimit;
+        m.unlock();
+        if(full) return;
 
-        if(qlimit && qq.size() >= qlimit) {
-            m.unlock();
+        //decode the data into a new vQueue
+        vQueue *q = new vQueue;
+        inputbottle.addtoendof<ev::AddressEvent>(*q);
+        if(q->empty()) {
+            delete q;
             return;
         }
-        qq.push_back(new vQueue);
+#ifdef VLIB_TIMESTAMP_64
+        for(auto &v : *q)
+            v->stamp = unwrapper.unwrap(v->stamp);
+#endif
         yarp::os::Stamp yarpstamp;
         getEnvelope(yarpstamp);
-        sq.push_back(yarpstamp);
-
-        m.unlock();
-
-
-        //and decode the data
-        inputbottle.addtoendof<ev::AddressEvent>(*(qq.back()));
+        vTrace trace;
+        if(inputbottle.getTrace(trace))
+            trace.add(getName());
 
-        //update the meta data
+        //add it to the list and update the meta data
         m.lock();
-        delay_nv += qq.back()->size();
-        int dt = qq.back()->back()->stamp - qq.back()->front()->stamp;
-        if(dt < 0) dt += vtsHelper::max_stamp;
+        qq.push_back(q);
+        sq.push_back(yarpstamp);
+        tq.push_back(trace);
+        delay_nv += q->size();
+        int dt = packetDuration(*q);
         delay_t += dt;
         if(dt)
-            event_rate = qq.back()->size() / (double)dt;
+            event_rate = q->size() / (double)dt;
         m.unlock();
 
         //if getNextQ is blocking - let it get the new data
@@ -112,29 +157,33 @@ public:
     /// \brief ask for a pointer to the next vQueue. Blocks if no data is ready.
     ev::vQueue* read(yarp::os::Stamp &yarpstamp)
     {
-        static vQueue * working_queue = nullptr;
         if(working_queue) {
             m.lock();
-
-            delay_nv -= qq.front()->size();
-            int dt = qq.front()->back()->stamp - qq.front()->front()->stamp;
-            if(dt < 0) dt += vtsHelper::max_stamp;
-            delay_t -= dt;
-
-            delete qq.front();
-            qq.pop_front();
-            sq.pop_front();
+            popFront();
             m.unlock();
+            working_queue = nullptr;
         }
         dataready.wait();
+
+        m.lock();
+        backlog b(*this);
+        policy.apply(b);
         if(qq.size()) {
             yarpstamp = sq.front();
+            working_trace = tq.front();
             working_queue = qq.front();
-            return working_queue;
-        }  else {
-            return 0;
         }
+        m.unlock();
+
+        return working_queue;
+    }
 
+    /// \brief the trace of the vQueue given by the last read, with the time
+    /// it arrived at this port. Empty if it was not traced.
+    const vTrace& queryTrace()
+    {
+        static const vTrace none;
+        return working_queue ? working_trace : none;
     }
 
     /// \brief remove the most recently read vQueue from the list and deallocate
@@ -142,18 +191,32 @@ public:
     void scrapQ()
     {
         m.lock();
+        popFront();
+        m.unlock();
+        working_queue = nullptr;
+    }
 
-        delay_nv -= qq.front()->size();
-        int dt = qq.front()->back()->stamp - qq.front()->front()->stamp;
-        if(dt < 0) dt += vtsHelper::max_stamp;
-        delay_t -= dt;
-
-        delete qq.front();
-        qq.pop_front();
-        sq.pop_front();
+    /// \brief set what is discarded when the processing falls behind (see
+    /// vDropPolicy::set for the meaning of value)
+    void setDropPolicy(dropPolicy policy, double value)
+    {
+        m.lock();
+        this->policy.set(policy, value);
         m.unlock();
     }
 
+    /// \brief ask for the number of vQueues discarded by the drop policy
+    unsigned int queryDiscardedPackets()
+    {
+        return policy.queryDroppedPackets();
+    }
+
+    /// \brief ask for the number of events discarded by the drop policy
+    unsigned int queryDiscardedEvents()
+    {
+        return policy.queryDroppedEvents();
+    }
+
     /// \brief set the maximum number of qs that can be stored in the buffer.
     /// A value of 0 keeps all qs.
     void setQLimit(unsigned int number_of_qs)
@@ -214,7 +277,7 @@ private:
 
     yarp::os::Mutex m;
     yarp::os::Stamp yarpstamp;
-    unsigned int ctime;
+    stamp_t ctime;
 
     int vcount;
 
@@ -311,14 +374,17 @@ public:
         return yarpstamp;
     }
 
-    unsigned int queryVTime()
+    stamp_t queryVTime()
     {
         return ctime;
     }
 
 };
 
-/// \brief asynchronously read events and push them in a historicalSurface
+/// \brief asynchronously read events and push them in a historicalSurface.
+/// In concurrent mode the events are pushed in a concurrentSurface, which is
+/// queried without waiting for the events being added. The time waited for
+/// each lock is recorded.
 class hSurfThread : public yarp::os::Thread
 {
 private:
@@ -330,9 +396,21 @@ private:
     historicalSurface surfaceright;
     yarp::os::Mutex m;
 
+    //the surfaces of the concurrent mode, which need no lock
+    bool concurrent;
+    concurrentSurface concurrentleft;
+    concurrentSurface concurrentright;
+
+    //the delays, stamps and trace are shared under their own lock
+    yarp::os::Mutex delays;
+    vHistogram lock_wait;
+
     //current stamp to propagate
     yarp::os::Stamp ystamp;
-    unsigned int vstamp;
+    stamp_t vstamp;
+
+    //the trace of the latest traced vQueue added to the surfaces
+    vTrace trace;
 
     //synchronising value (add to it when stamps come in, subtract from it
     // when querying events).
@@ -341,21 +419,63 @@ private:
     double cputimeR;
     int cpudelayR;
 
+    //lock a mutex, recording the time waited for it
+    void lock(yarp::os::Mutex &mutex)
+    {
+        if(mutex.tryLock()) {
+            lock_wait.record(0);
+            return;
+        }
+        std::uint64_t t0 = steadyNanos();
+        mutex.lock();
+        lock_wait.record(steadyNanos() - t0);
+    }
+
+    //reduce the delay of a channel by the cpu time since its last query
+    int updateDelay(int channel, double gain)
+    {
+        lock(delays);
+        double cpunow = yarp::os::Time::now();
+        double &cputime = channel ? cputimeR : cputimeL;
+        int &cpudelay = channel ? cpudelayR : cpudelayL;
+
+        cpudelay -= (cpunow - cputime) * vtsHelper::vtsscaler * gain;
+        cputime = cpunow;
+
+        if(cpudelay < 0) cpudelay = 0;
+        if(cpudelay > maxcpudelay) {
+            yWarning() << "CPU delay hit maximum";
+            cpudelay = maxcpudelay;
+        }
+
+        int delay = cpudelay;
+        delays.unlock();
+        return delay;
+    }
+
 public:
 
     hSurfThread()
     {
         vstamp = 0;
+        concurrent = false;
         cpudelayL = cpudelayR = 0;
         cputimeL = cputimeR = yarp::os::Time::now();
         maxcpudelay = 0.05 * vtsHelper::vtsscaler;
     }
 
-    void configure(int height, int width, double maxcpudelay)
+    void configure(int height, int width, double maxcpudelay,
+                   bool concurrent = false)
     {
         this->maxcpudelay = maxcpudelay * vtsHelper::vtsscaler;
-        surfaceleft.initialise(height, width);
-        surfaceright.initialise(height, width);
+        this->concurrent = concurrent;
+        if(concurrent) {
+            concurrentleft.initialise(height, width);
+            concurrentright.initialise(height, width);
+        } else {
+            surfaceleft.initialise(height, width);
+            surfaceright.initialise(height, width);
+        }
     }
 
     bool open(std::string portname)
@@ -367,6 +487,13 @@ public:
         return true;
     }
 
+    /// \brief publish the time waited for locks (by the thread adding events
+    /// and by the queries) with a vStatsPublisher
+    void registerStats(vStatsPublisher &stats, std::string name = "")
+    {
+        stats.add(name + "/lock_wait_us", &lock_wait, 1e-3);
+    }
+
     void onStop()
     {
         allocatorCallback.close();
@@ -376,8 +503,8 @@ public:
 
     void run()
     {
-        static int maxqs = 4;
-        bool allowproc = true;
+        //when behind, skip to the latest vQueues rather than adding all
+        allocatorCallback.setDropPolicy(DROP_OLDEST, 4);
 
         while(true) {
 
@@ -387,34 +514,40 @@ public:
             }
             if(isStopping()) break;
 
+            if(concurrent) {
+                for(ev::vQueue::iterator qi = q->begin(); qi != q->end(); qi++) {
+                    auto v = is_event<AE>(*qi);
+                    if(v->getChannel() == 0)
+                        concurrentleft.addEvent(*v);
+                    else if(v->getChannel() == 1)
+                        concurrentright.addEvent(*v);
+                }
+            } else {
+                lock(m);
+
+                for(ev::vQueue::iterator qi = q->begin(); qi != q->end(); qi++) {
 
-            int nqs = allocatorCallback.queryunprocessed();
+                    if((*qi)->getChannel() == 0)
+                        surfaceleft.addEvent(*qi);
+                    else if((*qi)->getChannel() == 1)
+                        surfaceright.addEvent(*qi);
 
-            if(allowproc)
-                m.lock();
+                }
 
-            if(nqs >= maxqs)
-                allowproc = false;
-            else if(nqs < maxqs)
-                allowproc = true;
+                m.unlock();
+            }
 
-            int dt = q->back()->stamp - vstamp;
-            if(dt < 0) dt += vtsHelper::max_stamp;
+            //the delays and stamp are moved on once the events are in the
+            //surfaces, such that a query never sees a delay that includes
+            //events it cannot find
+            lock(delays);
+            int dt = vtsHelper::elapsed(q->back()->stamp, vstamp);
             cpudelayL += dt;
             cpudelayR += dt;
             vstamp = q->back()->stamp;
-
-            for(ev::vQueue::iterator qi = q->begin(); qi != q->end(); qi++) {
-
-                if((*qi)->getChannel() == 0)
-                    surfaceleft.addEvent(*qi);
-                else if((*qi)->getChannel() == 1)
-                    surfaceright.addEvent(*qi);
-
-            }
-
-            if(allowproc)
-                m.unlock();
+            if(!allocatorCallback.queryTrace().empty())
+                trace = allocatorCallback.queryTrace();
+            delays.unlock();
 
             //allocatorCallback.scrapQ();
 
@@ -424,39 +557,17 @@ public:
 
     vQueue queryROI(int channel, int numEvts, int r)
     {
-
         vQueue q;
+        int delay = updateDelay(channel, 1.1);
 
-        m.lock();
-        double cpunow = yarp::os::Time::now();
-
-        if(channel == 0) {
-
-            cpudelayL -= (cpunow - cputimeL) * vtsHelper::vtsscaler * 1.1;
-            cputimeL = cpunow;
-
-            if(cpudelayL < 0) cpudelayL = 0;
-            if(cpudelayL > maxcpudelay) {
-                yWarning() << "CPU delay hit maximum";
-                cpudelayL = maxcpudelay;
-            }
-
-            surfaceleft.getSurfaceN(q, cpudelayL, numEvts, r);
-        }
-        else {
-
-            cpudelayR -= (cpunow - cputimeR) * vtsHelper::vtsscaler * 1.1;
-            cputimeR = cpunow;
-
-            if(cpudelayR < 0) cpudelayR = 0;
-            if(cpudelayR > maxcpudelay) {
-                yWarning() << "CPU delay hit maximum";
-                cpudelayR = maxcpudelay;
-            }
-
-            surfaceright.getSurfaceN(q, cpudelayR, numEvts, r);
+        if(concurrent) {
+            (channel ? concurrentright : concurrentleft).getSurfaceN(q, delay,
+                                                                     numEvts, r);
+            return q;
         }
 
+        lock(m);
+        (channel ? surfaceright : surfaceleft).getSurfaceN(q, delay, numEvts, r);
         m.unlock();
 
         return q;
@@ -464,40 +575,16 @@ public:
 
     vQueue queryROI(int channel, unsigned int querySize, int x, int y, int r)
     {
-
-
         vQueue q;
+        int delay = updateDelay(channel, 1.01);
 
-        m.lock();
-
-        double cpunow = yarp::os::Time::now();
-
-        if(channel == 0) {
-
-            cpudelayL -= (cpunow - cputimeL) * vtsHelper::vtsscaler * 1.01;
-            cputimeL = cpunow;
-
-            if(cpudelayL < 0) cpudelayL = 0;
-            if(cpudelayL > maxcpudelay) {
-                yWarning() << "CPU delay hit maximum";
-                cpudelayL = maxcpudelay;
-            }
-
-            q = surfaceleft.getSurface(cpudelayL, querySize, r, x, y);
-        } else {
-
-            cpudelayR -= (cpunow - cputimeR) * vtsHelper::vtsscaler * 1.01;
-            cputimeR = cpunow;
-
-            if(cpudelayR < 0) cpudelayR = 0;
-            if(cpudelayR > maxcpudelay) {
-                yWarning() << "CPU delay hit maximum";
-                cpudelayR = maxcpudelay;
-            }
-
-            q = surfaceright.getSurface(cpudelayR, querySize, r, x, y);
-        }
+        if(concurrent)
+            return (channel ? concurrentright : concurrentleft).getSurface(
+                        delay, querySize, r, x, y);
 
+        lock(m);
+        q = (channel ? surfaceright : surfaceleft).getSurface(delay, querySize,
+                                                              r, x, y);
         m.unlock();
 
         return q;
@@ -506,38 +593,14 @@ public:
     vQueue queryWindow(int channel, unsigned int querySize)
     {
         vQueue q;
+        int delay = updateDelay(channel, 1.01);
 
-        m.lock();
-
-        double cpunow = yarp::os::Time::now();
-
-        if(channel == 0) {
-
-            cpudelayL -= (cpunow - cputimeL) * vtsHelper::vtsscaler * 1.01;
-            cputimeL = cpunow;
-
-            if(cpudelayL < 0) cpudelayL = 0;
-            if(cpudelayL > maxcpudelay) {
-                yWarning() << "CPU delay hit maximum";
-                cpudelayL = maxcpudelay;
-            }
-
-            q = surfaceleft.getSurface(cpudelayL, querySize);
-        }
-        else {
-
-            cpudelayR -= (cpunow - cputimeR) * vtsHelper::vtsscaler * 1.01;
-            cputimeR = cpunow;
-
-            if(cpudelayR < 0) cpudelayR = 0;
-            if(cpudelayR > maxcpudelay) {
-                yWarning() << "CPU delay hit maximum";
-                cpudelayR = maxcpudelay;
-            }
-
-            q = surfaceright.getSurface(cpudelayR, querySize);
-        }
+        if(concurrent)
+            return (channel ? concurrentright : concurrentleft).getSurface(
+                        delay, querySize);
 
+        lock(m);
+        q = (channel ? surfaceright : surfaceleft).getSurface(delay, querySize);
         m.unlock();
 
         return q;
@@ -557,18 +620,33 @@ public:
         return ystamp;
     }
 
-    int queryVstamp(int channel = 0)
+    /// \brief the trace of the latest traced vQueue added to the surfaces
+    /// since the previous call. Empty if none.
+    vTrace queryTrace()
     {
-        int modvstamp;
-        m.lock();
+        lock(delays);
+        vTrace latest;
+        latest.swap(trace);
+        delays.unlock();
+        return latest;
+    }
+
+    stamp_t queryVstamp(int channel = 0)
+    {
+        std::int64_t modvstamp;
+        lock(delays);
         if(channel) {
-            modvstamp = vstamp - cpudelayR;
+            modvstamp = (std::int64_t)vstamp - cpudelayR;
         } else {
-            modvstamp = vstamp - cpudelayL;
+            modvstamp = (std::int64_t)vstamp - cpudelayL;
         }
-        m.unlock();
+        delays.unlock();
 
+#ifdef VLIB_TIMESTAMP_64
+        if(modvstamp < 0) modvstamp = 0;
+#else
         if(modvstamp < 0) modvstamp += vtsHelper::max_stamp;
+#endif
         return modvstamp;
 
     }
@@ -588,6 +666,7 @@ private:
 
     ev::vGenReadPort allocatorCallback;
     //ev::queueAllocator allocatorCallback;
+    ev::vHubReader *subscriber; //read from a vHub instead of the port
     vTempWindow windowleft;
     vTempWindow windowright;
 
@@ -597,13 +676,14 @@ private:
     int currentPeriod;
     yarp::os::Mutex waitforquery;
     yarp::os::Stamp yarpstamp;
-    unsigned int ctime;
+    stamp_t ctime;
     bool updated;
 
 public:
 
     tWinThread()
     {
+        subscriber = 0;
         ctime = 0;
         strictUpdatePeriod = 0;
         currentPeriod = 0;
@@ -620,9 +700,20 @@ public:
         return start();
     }
 
+    /// \brief read the packets of a vHub shared with other readers
+    bool open(ev::vHub &hub, int period = 0)
+    {
+        strictUpdatePeriod = period;
+        subscriber = hub.subscribe();
+        return start();
+    }
+
     void onStop()
     {
-        allocatorCallback.close();
+        if(subscriber)
+            subscriber->releaseDataLock();
+        else
+            allocatorCallback.close();
         //allocatorCallback.releaseDataLock();
         waitforquery.unlock();
     }
@@ -637,7 +728,8 @@ public:
         while(!isStopping()) {
 
 
-            const ev::vQueue *q = allocatorCallback.read(yarpstamp);
+            const ev::vQueue *q = subscriber ? subscriber->read(yarpstamp) :
+                                               allocatorCallback.read(yarpstamp);
             if(!q) break;
 
             if(!strictUpdatePeriod) safety.lock();
@@ -652,8 +744,7 @@ public:
             }
 
             if(strictUpdatePeriod) {
-                int dt = q->back()->stamp - ctime;
-                if(dt < 0) dt += vtsHelper::max_stamp;
+                int dt = vtsHelper::elapsed(q->back()->stamp, ctime);
                 currentPeriod += dt;
                 if(currentPeriod > strictUpdatePeriod) {
                     safety.unlock();
@@ -691,7 +782,7 @@ public:
         return q;
     }
 
-    void queryStamps(yarp::os::Stamp &yStamp, int &vStamp)
+    void queryStamps(yarp::os::Stamp &yStamp, stamp_t &vStamp)
     {
         yStamp = yarpstamp;
         vStamp = ctime;
@@ -704,11 +795,13 @@ public:
 
     unsigned int queryUnprocd()
     {
+        if(subscriber) return subscriber->queryunprocessed();
         return allocatorCallback.queryunprocessed();
     }
 
     std::string readDelayStats()
     {
+        if(subscriber) return subscriber->delayStatString();
         return allocatorCallback.delayStatString();
     }
 
@@ -723,7 +816,7 @@ private:
     std::map<std::string, ev::tWinThread> iPorts;
     //std::deque<tWinThread> iPorts;
     yarp::os::Stamp yStamp;
-    int vStamp;
+    stamp_t vStamp;
     int strictUpdatePeriod;
     bool using_yarp_stamps;
     //std::map<std::string, int> labelMap;
@@ -750,6 +843,16 @@ public:
         return true;
     }
 
+    /// \brief read eventType from a vHub shared with other readers in this
+    /// process, instead of opening a port
+    bool open(ev::vHub &hub, std::string eventType)
+    {
+        if(iPorts.count(eventType))
+            return true;
+
+        return iPorts[eventType].open(hub, strictUpdatePeriod);
+    }
+
     vQueue queryWindow(std::string vType, int channel)
     {
 
@@ -760,7 +863,7 @@ public:
     void updateStamps()
     {
         //query each input port and ask for the timestamp
-        yarp::os::Stamp ys; int vs;
+        yarp::os::Stamp ys; stamp_t vs;
         std::map<std::string, ev::tWinThread>::iterator i;
         for(i = iPorts.begin(); i != iPorts.end(); i++) {
             i->second.queryStamps(ys, vs);
@@ -793,7 +896,7 @@ public:
         return yStamp;
     }
 
-    int getvstamp()
+    stamp_t getvstamp()
     {
         return vStamp;
     }
@@ -0,0 +1,106 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VTRACE__
+#define __VTRACE__
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <yarp/os/Time.h>
+
+namespace ev {
+
+/// \brief the tag sent before the trace of a packet, after its events
+static const char trace_tag[] = "TRC";
+
+/// \brief the path of a sampled packet through a pipeline: each stage adds
+/// the name of the port the packet arrived at or left from, with the wall
+/// time (s) it did so. The trace is sent with the packet, such that the last
+/// stage holds the time spent in each stage and between stages.
+class vTrace
+{
+public:
+
+    struct point {
+        std::string name;
+        double time;
+    };
+
+    std::vector<point> points;
+
+    /// \brief add a point named name (a port or stage, without spaces) at
+    /// time, by default now
+    void add(const std::string &name, double time = yarp::os::Time::now())
+    {
+        point p;
+        p.name = name;
+        p.time = time;
+        points.push_back(p);
+    }
+
+    bool empty() const
+    {
+        return points.empty();
+    }
+
+    void clear()
+    {
+        points.clear();
+    }
+
+    void swap(vTrace &other)
+    {
+        points.swap(other.points);
+    }
+
+    /// \brief the trace as "name time name time ..." (times to the us)
+    std::string toString() const
+    {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(6);
+        for(size_t i = 0; i < points.size(); i++) {
+            if(i) oss << " ";
+            oss << points[i].name << " " << points[i].time;
+        }
+        return oss.str();
+    }
+
+    /// \brief read a trace written by toString(). Returns false (and an
+    /// empty trace) if text is not a trace.
+    bool fromString(const std::string &text)
+    {
+        points.clear();
+        std::istringstream iss(text);
+        point p;
+        while(iss >> p.name) {
+            if(!(iss >> p.time)) {
+                points.clear();
+                return false;
+            }
+            points.push_back(p);
+        }
+        return true;
+    }
+
+};
+
+}
+
+#endif
@@ -22,7 +22,10 @@
 #include <yarp/os/all.h>
 #include <yarp/sig/all.h>
 #include <vector>
+#include <deque>
+#include <atomic>
 #include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vPacket.h"
 #include "iCub/eventdriven/vtsHelper.h"
 #include "iCub/eventdriven/vWindow_basic.h"
 
@@ -63,6 +66,13 @@ public:
     virtual vQueue addEvent(event<> v);
     void fastAddEvent(event <> v, bool onlyAdd = false);
 
+    ///
+    /// \brief fastAddPacket adds all events of a vPacket to the surface
+    /// \param p the packet of events to add
+    /// \param channel only add events from this channel (-1 adds all)
+    ///
+    void fastAddPacket(const vPacket<AE> &p, int channel = -1);
+
     virtual vQueue removeEvents(event<> toAdd) = 0;
     virtual void fastRemoveEvents(event<> toAdd) = 0;
 
@@ -220,19 +230,43 @@ public:
 
 };
 
-/// \brief a surface that can be queried at any time in the past.
+/// \brief a surface that can be queried at any time in the past. The
+/// position in the history of each 1 ms of time is indexed, such that a query
+/// starts from the time it asks for, rather than from the most recent event.
+/// Events are expected in time order, as from a single sensor.
 class historicalSurface : public vTempWindow
 {
 private:
 
-    yarp::sig::ImageOf<yarp::sig::PixelMono> surface;
+    //a pixel is visited by the current query if its marker is the generation
+    std::vector<unsigned int> visited;
+    unsigned int generation;
+    int width;
+
+    //index[i] is the position of the first event at or after bucket
+    //first_bucket + i, counting all events ever added. The clock is the time
+    //of the most recent event, unwrapped.
+    std::deque<std::uint64_t> index;
+    std::int64_t first_bucket;
+    std::int64_t bucket_size;
+    std::int64_t clock;
+    stamp_t latest;
+    std::uint64_t popped;
+
+    void push(const event<> &v);
+    void pop();
+    void nextGeneration();
+    size_t startOf(int queryTime);
 
 public:
 
-    historicalSurface() {}
+    historicalSurface();
 
     void initialise(int height, int width);
 
+    void addEvent(event<> v);
+    void addEvents(const vQueue &events);
+
     vQueue getSurface(int queryTime, int queryWindow);
     vQueue getSurface(int queryTime, int queryWindow, int d);
     vQueue getSurface(int queryTime, int queryWindow, int d, int x, int y);
@@ -243,6 +277,151 @@ public:
 
 };
 
+/// \brief a surface that can be queried at any time in the past, as the
+/// historicalSurface, by any number of threads while a single thread adds
+/// events, without a lock. Events are copied into a ring of a fixed number of
+/// slots, each protected by its sequence number (a seqlock): a query reads
+/// the events added before it started, and its history ends at an event that
+/// has since been overwritten. The history is the shorter of the ring and ~2
+/// seconds. Queries return copies of the events.
+class concurrentSurface
+{
+private:
+
+    //seq is the position of the event in the history + 1, or 0 while the
+    //slot is written
+    struct slot {
+        std::atomic<std::uint64_t> seq;
+        std::atomic<std::int64_t> clock;
+        std::atomic<std::uint64_t> stamp;
+        std::atomic<std::uint64_t> address;
+    };
+
+    //an event as read from a slot
+    struct entry {
+        std::int64_t clock;
+        stamp_t stamp;
+        int x, y, polarity, channel;
+    };
+
+    std::vector<slot> ring;
+    size_t mask;
+    std::atomic<std::uint64_t> head;
+    int width;
+    int height;
+    int tLower;
+    std::int64_t margin;
+
+    //the time of the most recent event, unwrapped. Used by the writer only.
+    std::int64_t clock;
+    stamp_t latest;
+
+    bool read(std::uint64_t s, entry &e) const;
+    std::uint64_t startOf(std::uint64_t h, std::int64_t now, int queryTime) const;
+    template <typename F> void scan(int queryTime, F f) const;
+
+public:
+
+    concurrentSurface();
+
+    /// \brief set the size of the surface and the number of events in the
+    /// ring (rounded up to a power of 2). Not thread safe.
+    void initialise(int height, int width, size_t capacity = 1 << 20);
+
+    /// \brief add events. Only one thread can add events.
+    void addEvent(const AddressEvent &v);
+    void addEvents(const vQueue &events);
+
+    vQueue getSurface(int queryTime, int queryWindow) const;
+    vQueue getSurface(int queryTime, int queryWindow, int d, int x, int y) const;
+    vQueue getSurface(int queryTime, int queryWindow, int xl, int xh, int yl, int yh) const;
+    void getSurfaceN(ev::vQueue &qret, int queryTime, int numEvents, int d) const;
+    void getSurfaceN(ev::vQueue &qret, int queryTime, int numEvents, int xl, int xh, int yl, int yh) const;
+
+};
+
+/// \brief a time surface: the time of the most recent event at each pixel,
+/// with a plane for each polarity and channel. Adding an event is O(1) and the
+/// surface is exported as exp(-(t - t_last) / tau), where t is the time of
+/// the most recent event. Events are expected in time order, as from a single
+/// sensor. An event more than ~2^30 ticks old is treated as decayed to 0.
+class decaySurface
+{
+private:
+
+    int width;
+    int height;
+    int channels;
+    float rate; //1 / tau
+
+    //the time of the most recent event at each pixel of each plane, in ticks
+    //from base. The clock is the time of the most recent event from base,
+    //unwrapped, and base is moved forward before the clock overflows.
+    std::vector<std::int32_t> planes;
+    std::int64_t base;
+    std::int64_t clock;
+    stamp_t latest;
+    bool started;
+
+    void rebase();
+    const std::int32_t* plane(int polarity, int channel) const
+    {
+        return planes.data() + (channel * 2 + (polarity ? 1 : 0)) * width * height;
+    }
+    void clip(int &xl, int &xh, int &yl, int &yh) const;
+
+public:
+
+    ///
+    /// \brief decaySurface constructor
+    /// \param width retina width
+    /// \param height retina height
+    /// \param tau the time constant of the decay (ts)
+    /// \param channels the number of channels (e.g. 2 for a stereo pair)
+    ///
+    decaySurface(int width = 128, int height = 128,
+                 int tau = 0.05 * vtsHelper::vtsscaler, int channels = 1);
+
+    /// \brief set the time constant of the decay (ts)
+    void setDecay(int tau);
+
+    ///
+    /// \brief addEvent sets the time of the pixel of an event. Events outside
+    /// the surface or of a channel outside the surface are ignored, as is an
+    /// event older than the time already at its pixel.
+    ///
+    void addEvent(stamp_t stamp, int x, int y, int polarity, int channel = 0);
+    void addEvent(const AddressEvent &v);
+    void addEvents(const vQueue &q);
+    void addPacket(const vPacket<AE> &p);
+
+    /// \brief set all pixels to decayed
+    void clear();
+
+    ///
+    /// \brief getSurface fills an image (resized to the window) with the decay
+    /// of each pixel of a spatial window, in [0, 1]
+    /// \param image the image to fill
+    /// \param polarity the polarity plane
+    /// \param channel the channel plane
+    /// \param xl lower x value of window
+    /// \param xh upper x value of window
+    /// \param yl lower y value of window
+    /// \param yh upper y value of window
+    ///
+    void getSurface(yarp::sig::ImageOf<yarp::sig::PixelFloat> &image,
+                    int polarity, int channel, int xl, int xh, int yl, int yh) const;
+    void getSurface(yarp::sig::ImageOf<yarp::sig::PixelFloat> &image,
+                    int polarity, int channel = 0) const;
+
+    /// \brief as above, scaled to [0, 255]
+    void getSurface(yarp::sig::ImageOf<yarp::sig::PixelMono> &image,
+                    int polarity, int channel, int xl, int xh, int yl, int yh) const;
+    void getSurface(yarp::sig::ImageOf<yarp::sig::PixelMono> &image,
+                    int polarity, int channel = 0) const;
+
+};
+
 }
 
 
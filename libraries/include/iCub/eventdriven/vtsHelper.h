@@ -22,9 +22,20 @@
 
 #include <yarp/os/all.h>
 #include <fstream>
+#include <cstdint>
 
 namespace ev {
 
+#ifdef VLIB_TIMESTAMP_64
+/// \brief the type of an event timestamp. With VLIB_TIMESTAMP_64 events
+/// carry a 64 bit timestamp that is unwrapped once as it enters the process
+/// (see vtsHelper::unwrap) and never wraps afterwards.
+typedef std::uint64_t stamp_t;
+#else
+/// \brief the type of an event timestamp, which wraps at vtsHelper::max_stamp
+typedef unsigned int stamp_t;
+#endif
+
 /// \brief helper class to deal with timestamp conversion and wrapping
 class vtsHelper {
 
@@ -45,6 +56,13 @@ public:
     /// \brief constructor
     vtsHelper(): last_stamp(0), n_wraps(0) {}
 
+#ifdef VLIB_TIMESTAMP_64
+    /// \brief event timestamps are already unwrapped as they enter the
+    /// process and are returned unchanged
+    std::uint64_t operator() (stamp_t timestamp) {
+        return timestamp;
+    }
+#else
     /// \brief unwrap a timestamp, given previously unwrapped timestamps
     unsigned long int operator() (int timestamp) {
         if(last_stamp > timestamp)
@@ -52,6 +70,55 @@ public:
         last_stamp = timestamp;
         return currentTime();
     }
+#endif
+
+    /// \brief unwrap the timestamp of an event as it enters the process.
+    /// Unlike operator() a small reordering of events is not counted as a
+    /// wrap: a stamp more than half the range before the last stamp has
+    /// wrapped, a stamp more than half the range after it was sent before
+    /// the last wrap.
+    std::uint64_t unwrap(unsigned int timestamp) {
+        std::int64_t d = (std::int64_t)timestamp - last_stamp;
+        if(d < -(std::int64_t)(max_stamp / 2)) {
+            n_wraps++;
+        } else if(d > (std::int64_t)(max_stamp / 2) && n_wraps) {
+            return timestamp + (std::uint64_t)max_stamp * (n_wraps - 1);
+        }
+        last_stamp = timestamp;
+        return timestamp + (std::uint64_t)max_stamp * n_wraps;
+    }
+
+    /// \brief move a clock that only goes forward on to the timestamp of an
+    /// event. clock is an unwrapped count of ticks and latest is the
+    /// timestamp at which it was last moved. An event older than latest
+    /// leaves the clock where it is. Returns the time of the event on the
+    /// clock.
+    static inline std::int64_t advance(std::int64_t &clock, stamp_t &latest,
+                                       stamp_t stamp) {
+        std::int64_t dt = elapsed(stamp, latest);
+#ifdef VLIB_TIMESTAMP_64
+        if(dt <= 0) return clock + dt;
+#else
+        //a stamp more than half the range after latest was sent before it
+        if(dt == 0 || dt >= max_stamp / 2) return clock - elapsed(latest, stamp);
+#endif
+        clock += dt;
+        latest = stamp;
+        return clock;
+    }
+
+    /// \brief the number of ticks from the timestamp t0 to the later
+    /// timestamp t1. A wrap between the two is corrected without a branch.
+    /// With VLIB_TIMESTAMP_64 timestamps do not wrap and this is a
+    /// subtraction.
+    static inline std::int64_t elapsed(stamp_t t1, stamp_t t0) {
+#ifdef VLIB_TIMESTAMP_64
+        return (std::int64_t)(t1 - t0);
+#else
+        int dt = t1 - t0;
+        return dt + ((dt >> 31) & max_stamp);
+#endif
+    }
 
     /// \brief DEPRECATED - access to max_stamp member variable is public
     static long int maxStamp() { return max_stamp; }
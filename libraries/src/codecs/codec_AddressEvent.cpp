@@ -18,10 +18,30 @@
 
 #include <yarp/os/Bottle.h>
 #include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vCodecLayout.h"
 
 namespace ev {
 
+static std::int32_t encodeAE(const AddressEvent &v)
+{
+    switch(getDefaultLayout()) {
+    case LAYOUT_128x128: return encodeAddress<layout128x128>(v);
+    case LAYOUT_304x240_20: return encodeAddress<layout304x240_20>(v);
+    default: return encodeAddress<layout304x240_24>(v);
+    }
+}
+
+static void decodeAE(std::int32_t data, AddressEvent &v)
+{
+    switch(getDefaultLayout()) {
+    case LAYOUT_128x128: decodeAddress<layout128x128>(data, v); break;
+    case LAYOUT_304x240_20: decodeAddress<layout304x240_20>(data, v); break;
+    default: decodeAddress<layout304x240_24>(data, v);
+    }
+}
+
 const std::string AddressEvent::tag = "AE";
+constexpr int AddressEvent::id;
 
 AddressEvent::AddressEvent() : vEvent(), x(0), y(0), channel(0), polarity(0), type(0) {}
 
@@ -48,55 +68,25 @@ AddressEvent::AddressEvent(const AddressEvent &v) : vEvent(v)
 
 event<> AddressEvent::clone()
 {
-    return std::make_shared<AddressEvent>(*this);
+    return std::allocate_shared<AddressEvent>(poolAllocator<AddressEvent>(), *this);
 }
 
 void AddressEvent::encode(yarp::os::Bottle &b) const
 {
     vEvent::encode(b);
-#if defined CODEC_128x128
-    b.addInt(((channel&0x01)<<15)|((x&0x7f)<<8)|(((127-y)&0x7f)<<1)|(polarity&0x01));
-#elif defined CODEC_304x240_20 //ATIS 20 bits encoding
-    b.addInt(((channel&0x01)<<20)|((type&0x1)<<18)|((y&0x0FF)<<10)|((x&0x1FF)<<1)|(polarity&0x01));
-#else //CODEC_304x240_24
-    b.addInt(((channel&0x01)<<22)|((type&0x1)<<23)|((y&0x0FF)<<12)|((x&0x1FF)<<1)|(polarity&0x01));
-#endif
+    b.addInt(encodeAE(*this));
 }
 
 void AddressEvent::encode(std::vector<std::int32_t> &b, unsigned int &pos) const
 {
     vEvent::encode(b, pos);
-#if defined CODEC_128x128
-    b[pos++] = (((channel&0x01)<<15)|((x&0x7f)<<8)|(((127-y)&0x7f)<<1)|(polarity&0x01));
-#elif defined CODEC_304x240_20 //ATIS 20 bits encoding
-    b[pos++] = (((channel&0x01)<<20)|((type&0x1)<<18)|((y&0x0FF)<<10)|((x&0x1FF)<<1)|(polarity&0x01));
-#else
-    b[pos++] = (((channel&0x01)<<22)|((type&0x1)<<23)|((y&0x0FF)<<12)|((x&0x1FF)<<1)|(polarity&0x01));
-#endif
+    b[pos++] = encodeAE(*this);
 }
 
 void AddressEvent::decode(int *&data)
 {
     vEvent::decode(data);
-
-#if defined CODEC_128x128
-    polarity = (*data >> 0) & 0x0001;
-    y = 127 - (*data >> 1) & 0x007F;
-    x = (*data >> 8) & 0x007F;
-    channel = (*data >> 15) & 0x0001;
-#elif defined CODEC_304x240_20 //ATIS 20 bits encoding
-    polarity = (*data >> 0) & 0x0001;
-    x = (*data >> 1) & 0x01FF;
-    y = (*data >> 10) & 0x00FF;
-    type = (*data >> 18) & 0x0001;
-    channel = (*data >> 20) & 0x0001;
-#else
-    polarity = (*data >> 0) & 0x0001;
-    x = (*data >> 1) & 0x01FF;
-    y = (*data >> 12) & 0x00FF;
-    type = (*data >> 23) & 0x0001;
-    channel = (*data >> 22) & 0x0001;
-#endif
+    decodeAE(*data, *this);
     data++;
 }
 
@@ -105,26 +95,7 @@ bool AddressEvent::decode(const yarp::os::Bottle &packet, size_t &pos)
     // check length
     if (vEvent::decode(packet, pos) && pos + 1 <= packet.size())
     {
-        int data=packet.get(pos).asInt();
-
-#if defined CODEC_128x128
-        polarity = (data >> 0) & 0x0001;
-        y = 127 - (data >> 1) & 0x007F;
-        x = (data >> 8) & 0x007F;
-        channel = (data >> 15) & 0x0001;
-#elif defined CODEC_304x240_20 //ATIS 20 bits encoding
-        polarity = (data >> 0) & 0x0001;
-        x = (data >> 1) & 0x001FF;
-        y = (data >> 10) & 0x00FF;
-        type = (data >> 18) & 0x0001;
-        channel = (data >> 20) & 0x0001;
-#else
-        polarity = (data >> 0) & 0x0001;
-        x = (data >> 1) & 0x001FF;
-        y = (data >> 12) & 0x00FF;
-        type = (data >> 23) & 0x0001;
-        channel = (data >> 22) & 0x0001;
-#endif
+        decodeAE(packet.get(pos).asInt(), *this);
 
         pos += 1;
         return true;
@@ -149,6 +120,11 @@ std::string AddressEvent::getType() const
     return AddressEvent::tag;
 }
 
+int AddressEvent::getTypeID() const
+{
+    return AddressEvent::id;
+}
+
 int AddressEvent::getChannel() const
 {
     return (int)channel;
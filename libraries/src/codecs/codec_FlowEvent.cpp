@@ -22,6 +22,7 @@
 namespace ev {
 
 const std::string FlowEvent::tag = "FLOW";
+constexpr int FlowEvent::id;
 
 FlowEvent::FlowEvent() : AddressEvent(), vx(0), vy(0) {}
 
@@ -42,7 +43,7 @@ FlowEvent::FlowEvent(const FlowEvent &v) : AddressEvent(v)
 
 event<> FlowEvent::clone()
 {
-    return std::make_shared<FlowEvent>(*this);
+    return std::allocate_shared<FlowEvent>(poolAllocator<FlowEvent>(), *this);
 }
 
 void FlowEvent::encode(yarp::os::Bottle &b) const
@@ -97,10 +98,19 @@ std::string FlowEvent::getType() const
     return FlowEvent::tag;
 }
 
+int FlowEvent::getTypeID() const
+{
+    return FlowEvent::id;
+}
+
 int FlowEvent::getDeath() const
 {
-    return stamp + 1.0 / (sqrt(pow(vx, 2.0f) + pow(vy, 2.0f))
-                          * vtsHelper::tstosecs());
+    return stamp + getLifetime();
+}
+
+int FlowEvent::getLifetime() const
+{
+    return 1.0 / (sqrt(pow(vx, 2.0f) + pow(vy, 2.0f)) * vtsHelper::tstosecs());
 }
 
 }
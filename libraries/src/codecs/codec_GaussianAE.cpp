@@ -22,6 +22,7 @@
 namespace ev {
 
 const std::string GaussianAE::tag = "GAE";
+constexpr int GaussianAE::id;
 
 GaussianAE::GaussianAE() : LabelledAE(), sigx(0), sigy(0), sigxy(0) {}
 
@@ -44,7 +45,7 @@ GaussianAE::GaussianAE(const GaussianAE &v) : LabelledAE(v)
 
 event<> GaussianAE::clone()
 {
-    return std::make_shared<GaussianAE>(*this);
+    return std::allocate_shared<GaussianAE>(poolAllocator<GaussianAE>(), *this);
 }
 
 void GaussianAE::encode(yarp::os::Bottle &b) const
@@ -102,5 +103,10 @@ std::string GaussianAE::getType() const
     return GaussianAE::tag;
 }
 
+int GaussianAE::getTypeID() const
+{
+    return GaussianAE::id;
+}
+
 
 }
@@ -22,6 +22,7 @@
 namespace ev {
 
 const std::string LabelledAE::tag = "LAE";
+constexpr int LabelledAE::id;
 
 LabelledAE::LabelledAE() : AddressEvent(), ID(0) {}
 
@@ -40,7 +41,7 @@ LabelledAE::LabelledAE(const LabelledAE &v) : AddressEvent(v)
 
 event<> LabelledAE::clone()
 {
-    return std::make_shared<LabelledAE>(*this);
+    return std::allocate_shared<LabelledAE>(poolAllocator<LabelledAE>(), *this);
 }
 
 void LabelledAE::encode(yarp::os::Bottle &b) const
@@ -85,4 +86,9 @@ std::string LabelledAE::getType() const
     return LabelledAE::tag;
 }
 
+int LabelledAE::getTypeID() const
+{
+    return LabelledAE::id;
+}
+
 }
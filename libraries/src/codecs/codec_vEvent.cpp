@@ -26,6 +26,7 @@
 namespace ev {
 
 const std::string vEvent::tag = "TS";
+constexpr int vEvent::id;
 
 vEvent::vEvent() : stamp(0) {}
 
@@ -33,7 +34,7 @@ vEvent::~vEvent() {}
 
 event<> vEvent::clone()
 {
-    return std::make_shared<vEvent>(*this);
+    return std::allocate_shared<vEvent>(poolAllocator<vEvent>(), *this);
 }
 
 void vEvent::encode(yarp::os::Bottle &b) const
@@ -78,6 +79,11 @@ std::string vEvent::getType() const
     return vEvent::tag;
 }
 
+int vEvent::getTypeID() const
+{
+    return vEvent::id;
+}
+
 int vEvent::getChannel() const
 {
     return -1;
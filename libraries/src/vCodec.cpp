@@ -17,66 +17,144 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <yarp/os/Bottle.h>
+#include <yarp/os/LogStream.h>
 #include "iCub/eventdriven/vCodec.h"
 #include "iCub/eventdriven/vtsHelper.h"
 
 namespace ev {
 
-event<> createEvent(const std::string &type)
-{
-
-    if(type == AddressEvent::tag)
-        return make_event<AE>();
-    if(type == LabelledAE::tag)
-        return make_event<LabelledAE>();
-    if(type == FlowEvent::tag)
-        return make_event<FlowEvent>();
-    if(type == GaussianAE::tag)
-        return make_event<GaussianAE>();
-    return event<>(nullptr);
+//the registry is filled in order of registration and entries are never
+//removed, so lookups only need the number of entries published so far
+struct eventTypeEntry {
+    std::string tag;
+    unsigned int size;
+    event<> (*create)();
+    int parent;
+};
 
+class eventTypeRegistry
+{
+private:
+
+    eventTypeEntry types[max_event_types];
+    std::atomic<int> n;
+    std::mutex m;
+
+public:
+
+    eventTypeRegistry() : n(0)
+    {
+        //the library event-types take the IDs declared in the classes. The
+        //tags are repeated here as the static tags may not be initialised yet
+        add("TS", 1, nullptr, -1);
+        add("AE", 2, &createEventOf<AddressEvent>, vEvent::id);
+        add("FLOW", 4, &createEventOf<FlowEvent>, AddressEvent::id);
+        add("LAE", 3, &createEventOf<LabelledAE>, AddressEvent::id);
+        add("GAE", 6, &createEventOf<GaussianAE>, LabelledAE::id);
+    }
+
+    int add(const std::string &tag, unsigned int size, event<> (*create)(),
+            int parent)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        int i = find(tag);
+        if(i >= 0) {
+            if(types[i].size != size)
+                yWarning() << "Event-type" << tag
+                           << "registered twice with different sizes";
+            return i;
+        }
+
+        i = n.load(std::memory_order_relaxed);
+        if(i >= max_event_types) {
+            yError() << "Too many event-types. Could not register" << tag;
+            return -1;
+        }
+
+        types[i].tag = tag;
+        types[i].size = size;
+        types[i].create = create;
+        types[i].parent = parent;
+        n.store(i + 1, std::memory_order_release);
+        return i;
+    }
+
+    int find(const std::string &tag) const
+    {
+        int count = n.load(std::memory_order_acquire);
+        for(int i = 0; i < count; i++)
+            if(types[i].tag == tag) return i;
+        return -1;
+    }
+
+    const eventTypeEntry *get(int id) const
+    {
+        if(id < 0 || id >= n.load(std::memory_order_acquire)) return nullptr;
+        return types + id;
+    }
+
+};
+
+static eventTypeRegistry &getRegistry()
+{
+    static eventTypeRegistry registry;
+    return registry;
 }
 
-unsigned int packetSize(const std::string &type)
+int registerEventType(const std::string &tag, unsigned int size,
+                      event<> (*create)(), int parent)
 {
-    if(type == AddressEvent::tag)
-        return 2;
-    if(type == vEvent::tag)
-        return 1;
-    if(type == LabelledAE::tag)
-        return 3;
-    if(type == FlowEvent::tag)
-        return 4;
-    if(type == GaussianAE::tag)
-        return 6;
-    return 0;
-
-
+    return getRegistry().add(tag, size, create, parent);
 }
 
-bool temporalSortStraight(const event<> &e1, const event<> &e2) {
-    return e2->stamp > e1->stamp;
+int eventTypeID(const std::string &tag)
+{
+    return getRegistry().find(tag);
 }
 
-bool temporalSortWrap(const event<> &e1, const event<> &e2)
+const std::string &eventTag(int id)
 {
+    static const std::string unknown;
+    const eventTypeEntry *t = getRegistry().get(id);
+    return t ? t->tag : unknown;
+}
 
-    if((unsigned int)(std::abs(e1->stamp - e2->stamp)) > vtsHelper::max_stamp/2)
-        return e1->stamp > e2->stamp;
-    else
-        return e2->stamp > e1->stamp;
+event<> createEvent(int id)
+{
+    const eventTypeEntry *t = getRegistry().get(id);
+    if(!t || !t->create) return event<>(nullptr);
+    return t->create();
+}
 
+unsigned int packetSize(int id)
+{
+    const eventTypeEntry *t = getRegistry().get(id);
+    return t ? t->size : 0;
 }
 
-void qsort(vQueue &q, bool respectWraps)
+bool isEventType(int id, int base)
 {
+    const eventTypeRegistry &r = getRegistry();
+    const eventTypeEntry *t = r.get(id);
+    while(t) {
+        if(id == base) return true;
+        id = t->parent;
+        t = r.get(id);
+    }
+    return false;
+}
 
-    if(respectWraps)
-        std::sort(q.begin(), q.end(), temporalSortWrap);
-    else
-        std::sort(q.begin(), q.end(), temporalSortStraight);
+event<> createEvent(const std::string &type)
+{
+    return createEvent(eventTypeID(type));
+}
 
+unsigned int packetSize(const std::string &type)
+{
+    return packetSize(eventTypeID(type));
 }
 
 }
@@ -0,0 +1,426 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vCodecBatch.h"
+#include "iCub/eventdriven/vtsHelper.h"
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define VLIB_BLOCK_X86
+#include <immintrin.h>
+#endif
+
+namespace ev {
+
+/******************************************************************************/
+//SCALAR
+/******************************************************************************/
+
+template <class L> static void decodeScalar(const std::int32_t *data, size_t n,
+                                            unsigned int *stamp, std::uint16_t *x,
+                                            std::uint16_t *y, std::uint8_t *p,
+                                            std::uint8_t *c, std::uint8_t *t)
+{
+    const unsigned int maxts = vtsHelper::max_stamp;
+    for(size_t i = 0; i < n; i++) {
+        unsigned int ts = data[2*i];
+        unsigned int a = data[2*i + 1];
+        stamp[i] = ts & maxts;
+        x[i] = (a >> L::xshift) & L::xmask;
+        y[i] = L::yflip ? L::ymask - ((a >> L::yshift) & L::ymask) :
+                          (a >> L::yshift) & L::ymask;
+        p[i] = a & 0x01;
+        c[i] = (a >> L::cshift) & 0x01;
+        t[i] = L::tshift < 0 ? 0 : (a >> (L::tshift & 31)) & 0x01;
+    }
+}
+
+template <class L> static void encodeScalar(std::int32_t *data, size_t n,
+                                            const unsigned int *stamp,
+                                            const std::uint16_t *x,
+                                            const std::uint16_t *y,
+                                            const std::uint8_t *p,
+                                            const std::uint8_t *c,
+                                            const std::uint8_t *t)
+{
+    const unsigned int maxts = vtsHelper::max_stamp;
+    for(size_t i = 0; i < n; i++) {
+        unsigned int ey = L::yflip ? L::ymask - y[i] : y[i];
+        unsigned int a = ((c[i] & 0x01) << L::cshift) |
+                ((ey & L::ymask) << L::yshift) |
+                ((x[i] & L::xmask) << L::xshift) | (p[i] & 0x01);
+        if(L::tshift >= 0)
+            a |= (t[i] & 0x01) << (L::tshift & 31);
+        data[2*i] = stamp[i] & maxts;
+        data[2*i + 1] = a;
+    }
+}
+
+/******************************************************************************/
+//SSE4.1 - 4 events per iteration
+/******************************************************************************/
+#ifdef VLIB_BLOCK_X86
+
+template <class L> __attribute__((target("sse4.1")))
+static size_t decodeSSE(const std::int32_t *data, size_t n, unsigned int *stamp,
+                        std::uint16_t *x, std::uint16_t *y, std::uint8_t *p,
+                        std::uint8_t *c, std::uint8_t *t)
+{
+    const __m128i maxts = _mm_set1_epi32(vtsHelper::max_stamp);
+    const __m128i xm = _mm_set1_epi32(L::xmask);
+    const __m128i ym = _mm_set1_epi32(L::ymask);
+    const __m128i one = _mm_set1_epi32(0x01);
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        //t0 a0 t1 a1 | t2 a2 t3 a3 -> t0 t1 t2 t3 | a0 a1 a2 a3
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(data + 2*i));
+        __m128i v2 = _mm_loadu_si128((const __m128i *)(data + 2*i + 4));
+        v1 = _mm_shuffle_epi32(v1, _MM_SHUFFLE(3, 1, 2, 0));
+        v2 = _mm_shuffle_epi32(v2, _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i ts = _mm_unpacklo_epi64(v1, v2);
+        __m128i a = _mm_unpackhi_epi64(v1, v2);
+
+        ts = _mm_and_si128(ts, maxts);
+        __m128i vx = _mm_and_si128(_mm_srli_epi32(a, L::xshift), xm);
+        __m128i vy = _mm_and_si128(_mm_srli_epi32(a, L::yshift), ym);
+        if(L::yflip) vy = _mm_sub_epi32(ym, vy);
+        __m128i vp = _mm_and_si128(a, one);
+        __m128i vc = _mm_and_si128(_mm_srli_epi32(a, L::cshift), one);
+        __m128i vt = L::tshift < 0 ? zero :
+                _mm_and_si128(_mm_srli_epi32(a, L::tshift & 31), one);
+
+        _mm_storeu_si128((__m128i *)(stamp + i), ts);
+
+        __m128i xy = _mm_packus_epi32(vx, vy);
+        _mm_storel_epi64((__m128i *)(x + i), xy);
+        _mm_storel_epi64((__m128i *)(y + i), _mm_unpackhi_epi64(xy, xy));
+
+        __m128i pct = _mm_packus_epi16(_mm_packus_epi32(vp, vc),
+                                       _mm_packus_epi32(vt, zero));
+        int pw = _mm_cvtsi128_si32(pct);
+        int cw = _mm_extract_epi32(pct, 1);
+        int tw = _mm_extract_epi32(pct, 2);
+        __builtin_memcpy(p + i, &pw, 4);
+        __builtin_memcpy(c + i, &cw, 4);
+        __builtin_memcpy(t + i, &tw, 4);
+    }
+    return i;
+}
+
+template <class L> __attribute__((target("sse4.1")))
+static size_t encodeSSE(std::int32_t *data, size_t n, const unsigned int *stamp,
+                        const std::uint16_t *x, const std::uint16_t *y,
+                        const std::uint8_t *p, const std::uint8_t *c,
+                        const std::uint8_t *t)
+{
+    const __m128i maxts = _mm_set1_epi32(vtsHelper::max_stamp);
+    const __m128i xm = _mm_set1_epi32(L::xmask);
+    const __m128i ym = _mm_set1_epi32(L::ymask);
+    const __m128i one = _mm_set1_epi32(0x01);
+
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        int pw, cw, tw;
+        __builtin_memcpy(&pw, p + i, 4);
+        __builtin_memcpy(&cw, c + i, 4);
+        __builtin_memcpy(&tw, t + i, 4);
+
+        __m128i ts = _mm_and_si128(_mm_loadu_si128((const __m128i *)(stamp + i)), maxts);
+        __m128i vx = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(x + i)));
+        __m128i vy = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(y + i)));
+        __m128i vp = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(pw));
+        __m128i vc = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(cw));
+        if(L::yflip) vy = _mm_sub_epi32(ym, vy);
+
+        __m128i a = _mm_and_si128(vp, one);
+        a = _mm_or_si128(a, _mm_slli_epi32(_mm_and_si128(vx, xm), L::xshift));
+        a = _mm_or_si128(a, _mm_slli_epi32(_mm_and_si128(vy, ym), L::yshift));
+        a = _mm_or_si128(a, _mm_slli_epi32(_mm_and_si128(vc, one), L::cshift));
+        if(L::tshift >= 0) {
+            __m128i vt = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(tw));
+            a = _mm_or_si128(a, _mm_slli_epi32(_mm_and_si128(vt, one), L::tshift & 31));
+        }
+
+        _mm_storeu_si128((__m128i *)(data + 2*i), _mm_unpacklo_epi32(ts, a));
+        _mm_storeu_si128((__m128i *)(data + 2*i + 4), _mm_unpackhi_epi32(ts, a));
+    }
+    return i;
+}
+
+/******************************************************************************/
+//AVX2 - 8 events per iteration
+/******************************************************************************/
+
+template <class L> __attribute__((target("avx2")))
+static size_t decodeAVX2(const std::int32_t *data, size_t n, unsigned int *stamp,
+                         std::uint16_t *x, std::uint16_t *y, std::uint8_t *p,
+                         std::uint8_t *c, std::uint8_t *t)
+{
+    const __m256i maxts = _mm256_set1_epi32(vtsHelper::max_stamp);
+    const __m256i xm = _mm256_set1_epi32(L::xmask);
+    const __m256i ym = _mm256_set1_epi32(L::ymask);
+    const __m256i one = _mm256_set1_epi32(0x01);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i split = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256i bytes = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        //t0 a0 .. t3 a3 | t4 a4 .. t7 a7 -> t0 .. t7 | a0 .. a7
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(data + 2*i));
+        __m256i v2 = _mm256_loadu_si256((const __m256i *)(data + 2*i + 8));
+        v1 = _mm256_permutevar8x32_epi32(v1, split);
+        v2 = _mm256_permutevar8x32_epi32(v2, split);
+        __m256i ts = _mm256_permute2x128_si256(v1, v2, 0x20);
+        __m256i a = _mm256_permute2x128_si256(v1, v2, 0x31);
+
+        ts = _mm256_and_si256(ts, maxts);
+        __m256i vx = _mm256_and_si256(_mm256_srli_epi32(a, L::xshift), xm);
+        __m256i vy = _mm256_and_si256(_mm256_srli_epi32(a, L::yshift), ym);
+        if(L::yflip) vy = _mm256_sub_epi32(ym, vy);
+        __m256i vp = _mm256_and_si256(a, one);
+        __m256i vc = _mm256_and_si256(_mm256_srli_epi32(a, L::cshift), one);
+        __m256i vt = L::tshift < 0 ? zero :
+                _mm256_and_si256(_mm256_srli_epi32(a, L::tshift & 31), one);
+
+        _mm256_storeu_si256((__m256i *)(stamp + i), ts);
+
+        //packs work within 128 bit lanes so the results are reordered
+        __m256i xy = _mm256_permute4x64_epi64(_mm256_packus_epi32(vx, vy), 0xD8);
+        _mm_storeu_si128((__m128i *)(x + i), _mm256_castsi256_si128(xy));
+        _mm_storeu_si128((__m128i *)(y + i), _mm256_extracti128_si256(xy, 1));
+
+        __m256i pct = _mm256_packus_epi16(_mm256_packus_epi32(vp, vc),
+                                          _mm256_packus_epi32(vt, zero));
+        pct = _mm256_permutevar8x32_epi32(pct, bytes);
+        __m128i pc = _mm256_castsi256_si128(pct);
+        _mm_storel_epi64((__m128i *)(p + i), pc);
+        _mm_storel_epi64((__m128i *)(c + i), _mm_unpackhi_epi64(pc, pc));
+        _mm_storel_epi64((__m128i *)(t + i), _mm256_extracti128_si256(pct, 1));
+    }
+    return i;
+}
+
+template <class L> __attribute__((target("avx2")))
+static size_t encodeAVX2(std::int32_t *data, size_t n, const unsigned int *stamp,
+                         const std::uint16_t *x, const std::uint16_t *y,
+                         const std::uint8_t *p, const std::uint8_t *c,
+                         const std::uint8_t *t)
+{
+    const __m256i maxts = _mm256_set1_epi32(vtsHelper::max_stamp);
+    const __m256i xm = _mm256_set1_epi32(L::xmask);
+    const __m256i ym = _mm256_set1_epi32(L::ymask);
+    const __m256i one = _mm256_set1_epi32(0x01);
+
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m256i ts = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(stamp + i)), maxts);
+        __m256i vx = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(x + i)));
+        __m256i vy = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(y + i)));
+        __m256i vp = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(p + i)));
+        __m256i vc = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(c + i)));
+        if(L::yflip) vy = _mm256_sub_epi32(ym, vy);
+
+        __m256i a = _mm256_and_si256(vp, one);
+        a = _mm256_or_si256(a, _mm256_slli_epi32(_mm256_and_si256(vx, xm), L::xshift));
+        a = _mm256_or_si256(a, _mm256_slli_epi32(_mm256_and_si256(vy, ym), L::yshift));
+        a = _mm256_or_si256(a, _mm256_slli_epi32(_mm256_and_si256(vc, one), L::cshift));
+        if(L::tshift >= 0) {
+            __m256i vt = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(t + i)));
+            a = _mm256_or_si256(a, _mm256_slli_epi32(_mm256_and_si256(vt, one), L::tshift & 31));
+        }
+
+        //t0 a0 t1 a1 | t4 a4 t5 a5 and t2 a2 t3 a3 | t6 a6 t7 a7
+        __m256i lo = _mm256_unpacklo_epi32(ts, a);
+        __m256i hi = _mm256_unpackhi_epi32(ts, a);
+        _mm256_storeu_si256((__m256i *)(data + 2*i), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(data + 2*i + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    return i;
+}
+
+#endif
+
+/******************************************************************************/
+//DISPATCH
+/******************************************************************************/
+
+enum { ISA_SCALAR = 0, ISA_SSE41 = 1, ISA_AVX2 = 2 };
+
+static int detectISA()
+{
+#ifdef VLIB_BLOCK_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) return ISA_AVX2;
+    if(__builtin_cpu_supports("sse4.1")) return ISA_SSE41;
+#endif
+    return ISA_SCALAR;
+}
+
+static int &activeISA()
+{
+    static int isa = detectISA();
+    return isa;
+}
+
+std::string blockCodecISA()
+{
+    switch(activeISA()) {
+    case ISA_AVX2: return "avx2";
+    case ISA_SSE41: return "sse4.1";
+    default: return "scalar";
+    }
+}
+
+void setBlockCodecScalar(bool scalar)
+{
+    activeISA() = scalar ? ISA_SCALAR : detectISA();
+}
+
+template <class L> static void decodeBlock(const std::int32_t *data, size_t n,
+                                           unsigned int *stamp, std::uint16_t *x,
+                                           std::uint16_t *y, std::uint8_t *polarity,
+                                           std::uint8_t *channel, std::uint8_t *type)
+{
+    size_t i = 0;
+#ifdef VLIB_BLOCK_X86
+    if(activeISA() == ISA_AVX2)
+        i = decodeAVX2<L>(data, n, stamp, x, y, polarity, channel, type);
+    else if(activeISA() == ISA_SSE41)
+        i = decodeSSE<L>(data, n, stamp, x, y, polarity, channel, type);
+#endif
+    decodeScalar<L>(data + 2*i, n - i, stamp + i, x + i, y + i,
+                    polarity + i, channel + i, type + i);
+}
+
+template <class L> static void encodeBlock(std::int32_t *data, size_t n,
+                                           const unsigned int *stamp,
+                                           const std::uint16_t *x,
+                                           const std::uint16_t *y,
+                                           const std::uint8_t *polarity,
+                                           const std::uint8_t *channel,
+                                           const std::uint8_t *type)
+{
+    size_t i = 0;
+#ifdef VLIB_BLOCK_X86
+    if(activeISA() == ISA_AVX2)
+        i = encodeAVX2<L>(data, n, stamp, x, y, polarity, channel, type);
+    else if(activeISA() == ISA_SSE41)
+        i = encodeSSE<L>(data, n, stamp, x, y, polarity, channel, type);
+#endif
+    encodeScalar<L>(data + 2*i, n - i, stamp + i, x + i, y + i,
+                    polarity + i, channel + i, type + i);
+}
+
+//the layout is selected once per block, the kernels are specialised for it
+void decodeAEBlock(const std::int32_t *data, size_t n, unsigned int *stamp,
+                   std::uint16_t *x, std::uint16_t *y, std::uint8_t *polarity,
+                   std::uint8_t *channel, std::uint8_t *type, codecLayout layout)
+{
+    switch(resolveLayout(layout)) {
+    case LAYOUT_128x128:
+        decodeBlock<layout128x128>(data, n, stamp, x, y, polarity, channel, type);
+        break;
+    case LAYOUT_304x240_20:
+        decodeBlock<layout304x240_20>(data, n, stamp, x, y, polarity, channel, type);
+        break;
+    default:
+        decodeBlock<layout304x240_24>(data, n, stamp, x, y, polarity, channel, type);
+    }
+}
+
+void encodeAEBlock(std::int32_t *data, size_t n, const unsigned int *stamp,
+                   const std::uint16_t *x, const std::uint16_t *y,
+                   const std::uint8_t *polarity, const std::uint8_t *channel,
+                   const std::uint8_t *type, codecLayout layout)
+{
+    switch(resolveLayout(layout)) {
+    case LAYOUT_128x128:
+        encodeBlock<layout128x128>(data, n, stamp, x, y, polarity, channel, type);
+        break;
+    case LAYOUT_304x240_20:
+        encodeBlock<layout304x240_20>(data, n, stamp, x, y, polarity, channel, type);
+        break;
+    default:
+        encodeBlock<layout304x240_24>(data, n, stamp, x, y, polarity, channel, type);
+    }
+}
+
+//AddressEvent objects are filled from a small block of field arrays so that
+//the address is still unpacked with the vector kernels
+static const size_t block_size = 256;
+
+void decodeAEBlock(const std::int32_t *data, size_t n, AddressEvent *out,
+                   codecLayout layout)
+{
+    unsigned int ts[block_size];
+    std::uint16_t x[block_size], y[block_size];
+    std::uint8_t p[block_size], c[block_size], t[block_size];
+
+    for(size_t i = 0; i < n; i += block_size) {
+        size_t m = std::min(block_size, n - i);
+        decodeAEBlock(data + 2*i, m, ts, x, y, p, c, t, layout);
+        for(size_t j = 0; j < m; j++) {
+            AddressEvent &v = out[i + j];
+            v.stamp = ts[j];
+            v.x = x[j];
+            v.y = y[j];
+            v.polarity = p[j];
+            v.channel = c[j];
+            v.type = t[j];
+        }
+    }
+}
+
+template <class I> static void encodeObjects(std::int32_t *data, size_t n, I in,
+                                             codecLayout layout)
+{
+    unsigned int ts[block_size];
+    std::uint16_t x[block_size], y[block_size];
+    std::uint8_t p[block_size], c[block_size], t[block_size];
+
+    for(size_t i = 0; i < n; i += block_size) {
+        size_t m = std::min(block_size, n - i);
+        for(size_t j = 0; j < m; j++, in++) {
+            const AddressEvent &v = *in;
+            ts[j] = v.stamp;
+            x[j] = v.x;
+            y[j] = v.y;
+            p[j] = v.polarity;
+            c[j] = v.channel;
+            t[j] = v.type;
+        }
+        encodeAEBlock(data + 2*i, m, ts, x, y, p, c, t, layout);
+    }
+}
+
+void encodeAEBlock(std::int32_t *data, size_t n, const AddressEvent *in,
+                   codecLayout layout)
+{
+    encodeObjects(data, n, in, layout);
+}
+
+void encodeAEBlock(std::int32_t *data, const std::deque<AddressEvent> &q,
+                   codecLayout layout)
+{
+    encodeObjects(data, q.size(), q.begin(), layout);
+}
+
+}
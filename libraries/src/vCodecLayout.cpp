@@ -0,0 +1,65 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vCodecLayout.h"
+
+namespace ev {
+
+//static constexpr members still need a definition when odr-used (C++11)
+constexpr codecLayout layout128x128::id;
+constexpr codecLayout layout304x240_20::id;
+constexpr codecLayout layout304x240_24::id;
+
+#if defined CODEC_128x128
+codecLayout default_layout = LAYOUT_128x128;
+#elif defined CODEC_304x240_20
+codecLayout default_layout = LAYOUT_304x240_20;
+#else //CODEC_304x240_24
+codecLayout default_layout = LAYOUT_304x240_24;
+#endif
+
+codecLayout layoutFromName(std::string name)
+{
+    if(name.compare(0, 6, "CODEC_") == 0)
+        name = name.substr(6);
+
+    if(name == "128x128")
+        return LAYOUT_128x128;
+    if(name == "304x240_20")
+        return LAYOUT_304x240_20;
+    if(name == "304x240_24")
+        return LAYOUT_304x240_24;
+    return LAYOUT_DEFAULT;
+}
+
+std::string layoutName(codecLayout layout)
+{
+    switch(resolveLayout(layout)) {
+    case LAYOUT_128x128: return "128x128";
+    case LAYOUT_304x240_20: return "304x240_20";
+    default: return "304x240_24";
+    }
+}
+
+void setDefaultLayout(codecLayout layout)
+{
+    if(layout != LAYOUT_DEFAULT)
+        default_layout = layout;
+}
+
+}
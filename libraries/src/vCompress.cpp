@@ -0,0 +1,358 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vCompress.h"
+#include <cstring>
+#include <algorithm>
+
+namespace ev {
+
+const std::string compressed_suffix = "~Z";
+
+//the compressed block is:
+//[version|flags] [coded ints] [ints per event] [payload bytes] [stage bytes]
+//followed by the payload padded to a multiple of 4 bytes
+static const unsigned int header_words = 5;
+static const std::uint32_t format_version = 1;
+static const std::uint32_t flag_lz = 0x100;
+
+/******************************************************************************/
+//STAGE 1 - delta coded timestamps, bit-packed addresses
+/******************************************************************************/
+
+static void putWord(std::vector<std::uint8_t> &s, std::uint32_t w)
+{
+    std::uint8_t b[4];
+    std::memcpy(b, &w, 4);
+    s.insert(s.end(), b, b + 4);
+}
+
+static void packEvents(const std::int32_t *data, unsigned int nints,
+                       unsigned int event_ints, std::vector<std::uint8_t> &s)
+{
+    unsigned int n = event_ints ? nints / event_ints : 0;
+    unsigned int remainder = nints - n * event_ints;
+
+    s.clear();
+    s.reserve(1 + n * (5 + 4 * event_ints) + 4 * remainder);
+
+    //the address width is the highest bit used in the block
+    std::uint32_t used = 0;
+    if(event_ints > 1)
+        for(unsigned int i = 0; i < n; i++)
+            used |= data[i * event_ints + 1];
+    int width = 0;
+    while(width < 32 && (used >> width)) width++;
+    s.push_back(width);
+
+    //timestamps as zig-zag varints of the difference to the previous event
+    std::uint32_t prev = 0;
+    for(unsigned int i = 0; i < n; i++) {
+        std::uint32_t ts = data[i * event_ints];
+        std::int32_t d = (std::int32_t)(ts - prev);
+        std::uint32_t z = ((std::uint32_t)d << 1) ^ (std::uint32_t)(d >> 31);
+        while(z >= 0x80) {
+            s.push_back((z & 0x7F) | 0x80);
+            z >>= 7;
+        }
+        s.push_back(z);
+        prev = ts;
+    }
+
+    //addresses packed at width bits
+    if(width) {
+        std::uint64_t acc = 0;
+        int bits = 0;
+        for(unsigned int i = 0; i < n; i++) {
+            acc |= (std::uint64_t)(std::uint32_t)data[i * event_ints + 1] << bits;
+            bits += width;
+            while(bits >= 8) {
+                s.push_back(acc & 0xFF);
+                acc >>= 8;
+                bits -= 8;
+            }
+        }
+        if(bits) s.push_back(acc & 0xFF);
+    }
+
+    //any other integers of the event-type are copied
+    for(unsigned int i = 0; i < n; i++)
+        for(unsigned int k = 2; k < event_ints; k++)
+            putWord(s, data[i * event_ints + k]);
+
+    for(unsigned int i = n * event_ints; i < nints; i++)
+        putWord(s, data[i]);
+}
+
+static bool unpackEvents(const std::uint8_t *s, size_t len, unsigned int nints,
+                         unsigned int event_ints, std::int32_t *data)
+{
+    unsigned int n = event_ints ? nints / event_ints : 0;
+    const std::uint8_t *end = s + len;
+
+    if(s >= end) return false;
+    int width = *(s++);
+    if(width > 32) return false;
+
+    std::uint32_t prev = 0;
+    for(unsigned int i = 0; i < n; i++) {
+        std::uint32_t z = 0;
+        int shift = 0;
+        while(true) {
+            if(s >= end || shift > 28) return false;
+            std::uint8_t b = *(s++);
+            z |= (std::uint32_t)(b & 0x7F) << shift;
+            if(!(b & 0x80)) break;
+            shift += 7;
+        }
+        std::int32_t d = (std::int32_t)((z >> 1) ^ (0 - (z & 1)));
+        prev += d;
+        data[i * event_ints] = prev;
+    }
+
+    if(event_ints > 1) {
+        if((size_t)(end - s) < ((size_t)n * width + 7) / 8) return false;
+        std::uint64_t mask = width == 32 ? 0xFFFFFFFF : (1ULL << width) - 1;
+        std::uint64_t acc = 0;
+        int bits = 0;
+        for(unsigned int i = 0; i < n; i++) {
+            while(bits < width) {
+                acc |= (std::uint64_t)*(s++) << bits;
+                bits += 8;
+            }
+            data[i * event_ints + 1] = (std::uint32_t)(acc & mask);
+            acc >>= width;
+            bits -= width;
+        }
+    }
+
+    size_t words = (size_t)n * (event_ints > 2 ? event_ints - 2 : 0) +
+            (nints - n * event_ints);
+    if((size_t)(end - s) != 4 * words) return false;
+
+    for(unsigned int i = 0; i < n; i++)
+        for(unsigned int k = 2; k < event_ints; k++, s += 4)
+            std::memcpy(data + i * event_ints + k, s, 4);
+
+    for(unsigned int i = n * event_ints; i < nints; i++, s += 4)
+        std::memcpy(data + i, s, 4);
+
+    return true;
+}
+
+/******************************************************************************/
+//STAGE 2 - LZ77 with a single hash probe (LZ4 style sequences)
+/******************************************************************************/
+
+static void putLength(std::vector<std::uint8_t> &out, size_t l)
+{
+    while(l >= 255) {
+        out.push_back(255);
+        l -= 255;
+    }
+    out.push_back(l);
+}
+
+static void putSequence(std::vector<std::uint8_t> &out, const std::uint8_t *lit,
+                        size_t nlit, size_t offset, size_t mlen)
+{
+    std::uint8_t token = std::min(nlit, (size_t)15) << 4;
+    if(mlen) token |= std::min(mlen - 4, (size_t)15);
+    out.push_back(token);
+    if(nlit >= 15) putLength(out, nlit - 15);
+    out.insert(out.end(), lit, lit + nlit);
+    if(!mlen) return;
+    out.push_back(offset & 0xFF);
+    out.push_back(offset >> 8);
+    if(mlen - 4 >= 15) putLength(out, mlen - 4 - 15);
+}
+
+static void lzCompress(const std::uint8_t *in, size_t n, std::vector<std::uint8_t> &out)
+{
+    static const int hash_bits = 12;
+    static const size_t min_match = 4;
+    static const size_t end_literals = 5;
+    std::uint32_t table[1 << hash_bits];
+    std::memset(table, 0, sizeof(table));
+
+    out.clear();
+    out.reserve(n + n / 255 + 16);
+
+    size_t anchor = 0, ip = 0;
+    while(n > 12 && ip + min_match + end_literals < n) {
+        std::uint32_t seq;
+        std::memcpy(&seq, in + ip, 4);
+        std::uint32_t h = (seq * 2654435761U) >> (32 - hash_bits);
+        size_t candidate = table[h];
+        table[h] = ip;
+
+        std::uint32_t cseq;
+        std::memcpy(&cseq, in + candidate, 4);
+        if(candidate >= ip || ip - candidate > 0xFFFF || cseq != seq) {
+            ip++;
+            continue;
+        }
+
+        size_t mlen = min_match;
+        while(ip + mlen + end_literals < n && in[candidate + mlen] == in[ip + mlen])
+            mlen++;
+        putSequence(out, in + anchor, ip - anchor, ip - candidate, mlen);
+        ip += mlen;
+        anchor = ip;
+    }
+
+    putSequence(out, in + anchor, n - anchor, 0, 0);
+}
+
+static bool getLength(const std::uint8_t *&ip, const std::uint8_t *end, size_t &l)
+{
+    std::uint8_t b;
+    do {
+        if(ip >= end) return false;
+        b = *(ip++);
+        l += b;
+    } while(b == 255);
+    return true;
+}
+
+static bool lzDecompress(const std::uint8_t *ip, size_t n, std::uint8_t *op, size_t on)
+{
+    const std::uint8_t *end = ip + n;
+    std::uint8_t *ostart = op, *oend = op + on;
+
+    while(ip < end) {
+        std::uint8_t token = *(ip++);
+
+        size_t nlit = token >> 4;
+        if(nlit == 15 && !getLength(ip, end, nlit)) return false;
+        if((size_t)(end - ip) < nlit || (size_t)(oend - op) < nlit) return false;
+        std::memcpy(op, ip, nlit);
+        ip += nlit;
+        op += nlit;
+
+        //the last sequence has only literals
+        if(ip == end) break;
+
+        if(end - ip < 2) return false;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if(!offset || offset > (size_t)(op - ostart)) return false;
+
+        size_t mlen = token & 0x0F;
+        if(mlen == 15 && !getLength(ip, end, mlen)) return false;
+        mlen += 4;
+        if((size_t)(oend - op) < mlen) return false;
+
+        //byte copy as the match may overlap the output
+        const std::uint8_t *match = op - offset;
+        for(size_t i = 0; i < mlen; i++)
+            *(op++) = *(match++);
+    }
+
+    return op == oend;
+}
+
+/******************************************************************************/
+//BLOCK
+/******************************************************************************/
+
+unsigned int compressEvents(const std::int32_t *data, unsigned int nints,
+                            unsigned int event_ints, bool lz,
+                            std::vector<std::int32_t> &out)
+{
+    //kept between calls to avoid allocation on every packet
+    static thread_local std::vector<std::uint8_t> stage, lzstage;
+
+    packEvents(data, nints, event_ints, stage);
+    const std::vector<std::uint8_t> *payload = &stage;
+
+    std::uint32_t flags = format_version;
+    if(lz) {
+        lzCompress(stage.data(), stage.size(), lzstage);
+        if(lzstage.size() < stage.size()) {
+            payload = &lzstage;
+            flags |= flag_lz;
+        }
+    }
+
+    unsigned int nwords = header_words + (payload->size() + 3) / 4;
+    if(out.size() < nwords)
+        out.resize(nwords);
+    out[0] = flags;
+    out[1] = nints;
+    out[2] = event_ints;
+    out[3] = payload->size();
+    out[4] = stage.size();
+    out[nwords - 1] = 0; //padding
+    std::memcpy(out.data() + header_words, payload->data(), payload->size());
+
+    return nwords;
+}
+
+bool decompressEvents(const std::int32_t *data, unsigned int nwords,
+                      unsigned int event_ints, std::vector<std::int32_t> &out,
+                      unsigned int &nints)
+{
+    static thread_local std::vector<std::uint8_t> stage;
+
+    if(nwords < header_words) return false;
+    std::uint32_t flags = data[0];
+    nints = data[1];
+    size_t payload_size = (std::uint32_t)data[3];
+    size_t stage_size = (std::uint32_t)data[4];
+
+    if((flags & 0xFF) != format_version) return false;
+    if((std::uint32_t)data[2] != event_ints) return false;
+    if(payload_size > 4 * (size_t)(nwords - header_words)) return false;
+
+    const std::uint8_t *payload = (const std::uint8_t *)(data + header_words);
+    if(flags & flag_lz) {
+        //the largest possible stage for the number of integers, and for the
+        //payload (a byte of the LZ stage expands to at most 255 bytes)
+        if(stage_size > 1 + 5 * (size_t)nints + 4 * (size_t)nints) return false;
+        if(stage_size > 255 * payload_size) return false;
+        stage.resize(stage_size);
+        if(!lzDecompress(payload, payload_size, stage.data(), stage_size))
+            return false;
+        payload = stage.data();
+        payload_size = stage_size;
+    }
+
+    //the smallest stage for the number of integers: the address width, a
+    //byte of timestamp per event and the words copied (addresses may take
+    //no bytes), such that a malformed block cannot size out
+    size_t n = event_ints ? nints / event_ints : 0;
+    size_t words = n * (event_ints > 2 ? event_ints - 2 : 0) +
+            (nints - n * event_ints);
+    if(payload_size < 1 + n + 4 * words) return false;
+
+    if(out.size() < nints)
+        out.resize(nints);
+    return unpackEvents(payload, payload_size, nints, event_ints, out.data());
+}
+
+bool stripCompressedTag(std::string &tag)
+{
+    size_t n = compressed_suffix.size();
+    if(tag.size() <= n || tag.compare(tag.size() - n, n, compressed_suffix))
+        return false;
+    tag.resize(tag.size() - n);
+    return true;
+}
+
+}
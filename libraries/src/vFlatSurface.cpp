@@ -0,0 +1,340 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vFlatSurface.h"
+#include <algorithm>
+#include <climits>
+#include <math.h>
+
+namespace ev {
+
+flatSurface::flatSurface(int width, int height, surfacePolicy policy,
+                         int value, surfaceLayout layout)
+{
+    this->width = width;
+    this->height = height;
+    this->layout = layout;
+    tiles = (width + 7) / 8;
+    if(layout == SURFACE_ROWS)
+        pixels.resize(width * height);
+    else
+        pixels.resize(tiles * ((height + 7) / 8) * 64);
+    ring.resize(1024);
+    mask = ring.size() - 1;
+    result.reserve(1024);
+
+    //sequence number 0 marks an empty pixel
+    head = tail = 1;
+    count = 0;
+    latest = 0;
+    sweep = 0;
+    for(size_t i = 0; i < pixels.size(); i++) {
+        pixels[i].stamp = 0;
+        pixels[i].seq = 0;
+    }
+
+    setPolicy(policy, value);
+}
+
+void flatSurface::setPolicy(surfacePolicy policy, int value)
+{
+    this->policy = policy;
+    this->value = value;
+
+    //whichever is smaller the duration or ~1/2 of the maximum window
+    if(policy == SURFACE_TEMPORAL)
+        this->value = std::min(value, (int)(vtsHelper::max_stamp * 0.45));
+}
+
+int flatSurface::lifetime(const surfaceEvent &v)
+{
+    double speed = sqrt(v.vx * v.vx + v.vy * v.vy) * vtsHelper::tstosecs();
+    if(speed <= 0) return INT_MAX;
+    double life = 1.0 / speed;
+    return life < INT_MAX ? (int)life : INT_MAX;
+}
+
+void flatSurface::addEvent(stamp_t stamp, int x, int y, int polarity,
+                           int channel, float vx, float vy)
+{
+    if(x < 0 || y < 0 || x >= width || y >= height)
+        return;
+
+    //make space, first by dropping replaced events from the back
+    if(head - tail > mask) {
+        while(head != tail && at(ring[tail & mask]).seq != tail)
+            tail++;
+        if(head - tail > mask)
+            grow();
+    }
+
+    surfaceEvent &v = ring[head & mask];
+    v.stamp = stamp;
+    v.x = x;
+    v.y = y;
+    v.polarity = polarity;
+    v.channel = channel;
+    v.vx = vx;
+    v.vy = vy;
+
+    pixel &p = at(v);
+    if(!p.seq) count++;
+    p.stamp = stamp;
+    p.seq = head++;
+    latest = stamp;
+
+    removeEvents();
+}
+
+void flatSurface::addEvent(const AddressEvent &v)
+{
+    addEvent(v.stamp, v.x, v.y, v.polarity, v.channel);
+}
+
+void flatSurface::addEvent(const FlowEvent &v)
+{
+    addEvent(v.stamp, v.x, v.y, v.polarity, v.channel, v.vx, v.vy);
+}
+
+void flatSurface::addPacket(const vPacket<AE> &p, int channel)
+{
+    for(size_t i = 0; i < p.size(); i++) {
+        if(channel >= 0 && p.channel[i] != channel) continue;
+        addEvent(p.stamp[i], p.x[i], p.y[i], p.polarity[i], p.channel[i]);
+    }
+}
+
+void flatSurface::clear()
+{
+    for(size_t i = 0; i < pixels.size(); i++)
+        pixels[i].seq = 0;
+    head = tail = 1;
+    count = 0;
+    latest = 0;
+    sweep = 0;
+}
+
+void flatSurface::grow()
+{
+    //each event keeps its sequence number, at its position in the new ring
+    std::vector<surfaceEvent> bigger(ring.size() * 2);
+    size_t biggermask = bigger.size() - 1;
+    for(std::uint64_t s = tail; s != head; s++)
+        bigger[s & biggermask] = ring[s & mask];
+    ring.swap(bigger);
+    mask = biggermask;
+}
+
+void flatSurface::popTail()
+{
+    pixel &p = at(ring[tail & mask]);
+    if(p.seq == tail) {
+        p.seq = 0;
+        count--;
+    }
+    tail++;
+}
+
+void flatSurface::removeEvents()
+{
+    while(tail != head) {
+
+        const surfaceEvent &v = ring[tail & mask];
+        if(at(v).seq != tail) {
+            tail++;
+            continue;
+        }
+
+        bool remove = false;
+        switch(policy) {
+        case SURFACE_TEMPORAL:
+            remove = vtsHelper::elapsed(latest, v.stamp) > value;
+            break;
+        case SURFACE_FIXED:
+            remove = count > value;
+            break;
+        case SURFACE_LIFETIME:
+            remove = vtsHelper::elapsed(latest, v.stamp) > lifetime(v);
+            break;
+        }
+        if(!remove) break;
+        popTail();
+    }
+
+    //lifetimes are not ordered by the ring, so expired events are also
+    //removed from anywhere in the ring, once for every ~count events added
+    if(policy == SURFACE_LIFETIME && ++sweep > (unsigned int)count + 64) {
+        removeExpired();
+        sweep = 0;
+    }
+}
+
+void flatSurface::removeExpired()
+{
+    //compact the ring in place, renumbering the events that are kept
+    std::uint64_t kept = tail;
+    for(std::uint64_t s = tail; s != head; s++) {
+        surfaceEvent &v = ring[s & mask];
+        pixel &p = at(v);
+        if(p.seq != s) continue;
+        if(vtsHelper::elapsed(latest, v.stamp) > lifetime(v)) {
+            p.seq = 0;
+            count--;
+            continue;
+        }
+        p.seq = kept;
+        ring[kept++ & mask] = v;
+    }
+    head = kept;
+}
+
+void flatSurface::clip(int &xl, int &xh, int &yl, int &yh) const
+{
+    xl = std::max(xl, 0);
+    xh = std::min(xh, width-1);
+    yl = std::max(yl, 0);
+    yh = std::min(yh, height-1);
+}
+
+surfaceSpan flatSurface::getSurf()
+{
+    return getSurf(0, width, 0, height);
+}
+
+surfaceSpan flatSurface::getSurf(int d)
+{
+    const surfaceEvent *v = getMostRecent();
+    if(!v) return surfaceSpan();
+    return getSurf(v->x, v->y, d);
+}
+
+surfaceSpan flatSurface::getSurf(int x, int y, int d)
+{
+    return getSurf(x - d, x + d, y - d, y + d);
+}
+
+surfaceSpan flatSurface::getSurf(int xl, int xh, int yl, int yh)
+{
+    clip(xl, xh, yl, yh);
+    if(xl > xh || yl > yh) {
+        result.clear();
+        return surfaceSpan();
+    }
+
+    //each pixel is copied and kept only if it holds an event, without a
+    //branch that would be mispredicted on a partially filled surface
+    result.resize((xh - xl + 1) * (yh - yl + 1));
+    surfaceEvent *out = result.data();
+    size_t n = 0;
+    visit(xl, xh, yl, yh, [this, out, &n](const pixel &p) {
+        out[n] = ring[p.seq & mask];
+        n += visible(p);
+    });
+    result.resize(n);
+    return surfaceSpan(result.data(), result.data() + n);
+}
+
+surfaceSpan flatSurface::getSurf_Tlim(int dt)
+{
+    result.clear();
+    for(std::uint64_t s = head; s != tail; s--) {
+
+        //check it is on the surface
+        const pixel &p = at(ring[(s - 1) & mask]);
+        if(p.seq != s - 1 || !visible(p)) continue;
+
+        //check temporal constraint
+        if(vtsHelper::elapsed(latest, p.stamp) >= dt) break;
+
+        result.push_back(ring[(s - 1) & mask]);
+    }
+    return surfaceSpan(result.data(), result.data() + result.size());
+}
+
+surfaceSpan flatSurface::getSurf_Tlim(int dt, int d)
+{
+    const surfaceEvent *v = getMostRecent();
+    if(!v) return surfaceSpan();
+    return getSurf_Tlim(dt, v->x, v->y, d);
+}
+
+surfaceSpan flatSurface::getSurf_Tlim(int dt, int x, int y, int d)
+{
+    return getSurf_Tlim(dt, x - d, x + d, y - d, y + d);
+}
+
+surfaceSpan flatSurface::getSurf_Tlim(int dt, int xl, int xh, int yl, int yh)
+{
+    //the stamps of the pixels are checked without reading the ring
+    result.clear();
+    clip(xl, xh, yl, yh);
+    visit(xl, xh, yl, yh, [this, dt](const pixel &p) {
+        if(visible(p) && vtsHelper::elapsed(latest, p.stamp) < dt)
+            result.push_back(ring[p.seq & mask]);
+    });
+    return surfaceSpan(result.data(), result.data() + result.size());
+}
+
+surfaceSpan flatSurface::getSurf_Clim(int c)
+{
+    //the ring is in the order the events were added
+    result.clear();
+    for(std::uint64_t s = head; s != tail && result.size() < (size_t)c; s--) {
+        const pixel &p = at(ring[(s - 1) & mask]);
+        if(p.seq != s - 1 || !visible(p)) continue;
+        result.push_back(ring[(s - 1) & mask]);
+    }
+    std::reverse(result.begin(), result.end());
+    return surfaceSpan(result.data(), result.data() + result.size());
+}
+
+surfaceSpan flatSurface::getSurf_Clim(int c, int d)
+{
+    const surfaceEvent *v = getMostRecent();
+    if(!v) return surfaceSpan();
+    return getSurf_Clim(c, v->x, v->y, d);
+}
+
+surfaceSpan flatSurface::getSurf_Clim(int c, int x, int y, int d)
+{
+    return getSurf_Clim(c, x - d, x + d, y - d, y + d);
+}
+
+surfaceSpan flatSurface::getSurf_Clim(int c, int xl, int xh, int yl, int yh)
+{
+    getSurf(xl, xh, yl, yh);
+
+    //the age of an event is taken from the most recent event so that
+    //wrapped timestamps are ordered correctly
+    stamp_t t = latest;
+    auto newer = [t](const surfaceEvent &a, const surfaceEvent &b) {
+        return vtsHelper::elapsed(t, a.stamp) < vtsHelper::elapsed(t, b.stamp);
+    };
+    if(result.size() > (size_t)c) {
+        std::nth_element(result.begin(), result.begin() + c, result.end(),
+                         newer);
+        result.resize(c);
+    }
+    std::sort(result.begin(), result.end(),
+              [&newer](const surfaceEvent &a, const surfaceEvent &b) {
+        return newer(b, a);
+    });
+    return surfaceSpan(result.data(), result.data() + result.size());
+}
+
+}
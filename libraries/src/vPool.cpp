@@ -0,0 +1,70 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vPool.h"
+#include <algorithm>
+
+namespace ev {
+
+//the registry is never destroyed as threads can exit during static
+//destruction
+struct poolRegistry {
+    std::mutex m;
+    std::vector<poolCounters *> active;
+    poolStats retired;
+
+    poolRegistry() { retired.hits = 0; retired.misses = 0; }
+};
+
+static poolRegistry &getRegistry()
+{
+    static poolRegistry *r = new poolRegistry;
+    return *r;
+}
+
+void poolCounters::add(poolCounters *c)
+{
+    poolRegistry &r = getRegistry();
+    std::lock_guard<std::mutex> lock(r.m);
+    r.active.push_back(c);
+}
+
+void poolCounters::retire(poolCounters *c)
+{
+    poolRegistry &r = getRegistry();
+    std::lock_guard<std::mutex> lock(r.m);
+    r.retired.hits += c->getHits();
+    r.retired.misses += c->getMisses();
+    r.active.erase(std::remove(r.active.begin(), r.active.end(), c),
+                   r.active.end());
+    delete c;
+}
+
+poolStats getPoolStats()
+{
+    poolRegistry &r = getRegistry();
+    std::lock_guard<std::mutex> lock(r.m);
+    poolStats total = r.retired;
+    for(size_t i = 0; i < r.active.size(); i++) {
+        total.hits += r.active[i]->getHits();
+        total.misses += r.active[i]->getMisses();
+    }
+    return total;
+}
+
+}
@@ -0,0 +1,402 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vShm.h"
+#include <algorithm>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <climits>
+#include <cerrno>
+#endif
+
+namespace ev {
+
+static const std::uint32_t shm_magic = 0x76534d31; //"vSM1"
+
+//a record is a recordHeader followed by the packet, padded to 8 bytes. A
+//record never wraps around the end of the ring: the space left at the end
+//is marked with a skip record (or is too small for a header).
+struct recordHeader {
+    std::uint32_t size;
+    std::uint32_t skip;
+    std::int32_t count;
+    std::int32_t unused;
+    double time;
+};
+
+//the positions are byte offsets that only increase, the offset in the ring
+//is pos % capacity. The writer stores reserved before writing a record and
+//published after, such that a reader can check a record was not overwritten
+//while it was copied.
+struct vShmHeader {
+    std::uint32_t magic;
+    std::int32_t pid;
+    std::uint64_t capacity;
+    std::atomic<std::uint32_t> closed;
+    std::atomic<std::uint32_t> readers;
+    char pad1[40];
+    std::atomic<std::uint64_t> reserved;
+    std::atomic<std::uint64_t> published;
+    std::atomic<std::uint64_t> last;
+    char pad2[40];
+    std::atomic<std::uint32_t> seq; //futex word, incremented at each publish
+    std::atomic<std::uint32_t> waiters;
+};
+
+static size_t align8(size_t n)
+{
+    return (n + 7) & ~(size_t)7;
+}
+
+std::string shmSegmentName(const std::string &portname)
+{
+    std::string name = "/ev" + portname;
+    for(size_t i = 1; i < name.size(); i++)
+        if(name[i] == '/') name[i] = '.';
+    return name;
+}
+
+#ifdef __linux__
+
+static void futexWake(std::atomic<std::uint32_t> *word)
+{
+    syscall(SYS_futex, (std::uint32_t *)word, FUTEX_WAKE, INT_MAX,
+            nullptr, nullptr, 0);
+}
+
+static void futexWait(std::atomic<std::uint32_t> *word, std::uint32_t value,
+                      double seconds)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)seconds;
+    ts.tv_nsec = (long)((seconds - ts.tv_sec) * 1e9);
+    syscall(SYS_futex, (std::uint32_t *)word, FUTEX_WAIT, value, &ts,
+            nullptr, 0);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+//vShmWriter
+/*////////////////////////////////////////////////////////////////////////////*/
+
+vShmWriter::vShmWriter() : header(nullptr), ring(nullptr), mapped(0), head(0),
+    pending_pos(0), pending_total(0)
+{
+}
+
+vShmWriter::~vShmWriter()
+{
+    close();
+}
+
+bool vShmWriter::open(const std::string &portname, size_t bytes)
+{
+    close();
+
+    name = shmSegmentName(portname);
+    bytes = align8(std::max(bytes, (size_t)4096));
+    mapped = sizeof(vShmHeader) + bytes;
+
+    //replace the segment of a writer that did not close
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(fd < 0) {
+        yError() << "Could not create shared memory" << name << ":"
+                 << strerror(errno);
+        return false;
+    }
+    if(ftruncate(fd, mapped) != 0) {
+        yError() << "Could not allocate shared memory" << name << ":"
+                 << strerror(errno);
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void *m = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(m == MAP_FAILED) {
+        yError() << "Could not map shared memory" << name << ":"
+                 << strerror(errno);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    header = new (m) vShmHeader;
+    header->pid = getpid();
+    header->capacity = bytes;
+    header->closed = 0;
+    header->readers = 0;
+    header->reserved = 0;
+    header->published = 0;
+    header->last = 0;
+    header->seq = 0;
+    header->waiters = 0;
+    ring = (char *)m + sizeof(vShmHeader);
+    head = 0;
+
+    //readers check the magic number last
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = shm_magic;
+
+    return true;
+}
+
+void vShmWriter::close()
+{
+    if(!header) return;
+    header->closed = 1;
+    header->seq++;
+    futexWake(&header->seq);
+    munmap(header, mapped);
+    shm_unlink(name.c_str());
+    header = nullptr;
+    ring = nullptr;
+}
+
+unsigned int vShmWriter::queryReaders() const
+{
+    return header ? header->readers.load() : 0;
+}
+
+char * vShmWriter::prepare(size_t n, const yarp::os::Stamp &envelope)
+{
+    if(!header) return nullptr;
+
+    std::uint64_t capacity = header->capacity;
+    size_t total = align8(sizeof(recordHeader) + n);
+    if(total > capacity / 2) {
+        yError() << "Packet of" << n << "bytes too large for shared memory"
+                 << name;
+        return nullptr;
+    }
+
+    //skip the end of the ring if the record does not fit
+    std::uint64_t offset = head % capacity;
+    std::uint64_t start = head;
+    if(capacity - offset < total)
+        start += capacity - offset;
+
+    header->reserved.store(start + total, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if(start != head) {
+        if(capacity - offset >= sizeof(recordHeader)) {
+            recordHeader *skip = (recordHeader *)(ring + offset);
+            skip->size = 0;
+            skip->skip = 1;
+        }
+        head = start;
+        offset = 0;
+    }
+
+    recordHeader *r = (recordHeader *)(ring + offset);
+    r->size = n;
+    r->skip = 0;
+    r->count = envelope.getCount();
+    r->time = envelope.getTime();
+
+    pending_pos = head;
+    pending_total = total;
+    return ring + offset + sizeof(recordHeader);
+}
+
+void vShmWriter::publish()
+{
+    head = pending_pos + pending_total;
+    header->last.store(pending_pos, std::memory_order_relaxed);
+    header->published.store(head, std::memory_order_release);
+
+    header->seq.fetch_add(1);
+    if(header->waiters.load())
+        futexWake(&header->seq);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+//vShmReader
+/*////////////////////////////////////////////////////////////////////////////*/
+
+vShmReader::vShmReader() : header(nullptr), ring(nullptr), mapped(0), tail(0),
+    released(false), dropped(0)
+{
+}
+
+vShmReader::~vShmReader()
+{
+    close();
+}
+
+bool vShmReader::open(const std::string &portname)
+{
+    close();
+
+    std::string name = shmSegmentName(portname);
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if(fd < 0)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(vShmHeader)) {
+        ::close(fd);
+        return false;
+    }
+    mapped = st.st_size;
+    void *m = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(m == MAP_FAILED)
+        return false;
+
+    header = (vShmHeader *)m;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(header->magic != shm_magic || header->closed ||
+            sizeof(vShmHeader) + header->capacity != mapped ||
+            (kill(header->pid, 0) != 0 && errno == ESRCH)) {
+        munmap(m, mapped);
+        header = nullptr;
+        return false;
+    }
+
+    ring = (char *)m + sizeof(vShmHeader);
+    tail = header->published.load(std::memory_order_acquire);
+    header->readers++;
+    released = false;
+    return true;
+}
+
+void vShmReader::close()
+{
+    if(!header) return;
+    header->readers--;
+    munmap(header, mapped);
+    header = nullptr;
+    ring = nullptr;
+}
+
+void vShmReader::release()
+{
+    released = true;
+    if(header) {
+        header->seq++;
+        futexWake(&header->seq);
+    }
+}
+
+bool vShmReader::read(const char *&data, size_t &size,
+                      yarp::os::Stamp &envelope)
+{
+    if(!header) return false;
+    std::uint64_t capacity = header->capacity;
+
+    while(true) {
+
+        if(released || header->closed)
+            return false;
+
+        //wait for a new record
+        std::uint32_t seq = header->seq.load();
+        std::uint64_t published = header->published.load(std::memory_order_acquire);
+        if(tail >= published) {
+            header->waiters++;
+            if(!released && tail >= header->published.load())
+                futexWait(&header->seq, seq, 0.1);
+            header->waiters--;
+            continue;
+        }
+
+        //the writer is a full ring ahead: skip to the latest record
+        if(published - tail > capacity) {
+            dropped++;
+            tail = header->last.load(std::memory_order_acquire);
+            continue;
+        }
+
+        std::uint64_t offset = tail % capacity;
+        if(capacity - offset < sizeof(recordHeader)) {
+            tail += capacity - offset;
+            continue;
+        }
+
+        recordHeader r = *(recordHeader *)(ring + offset);
+        size_t total = align8(sizeof(recordHeader) + r.size);
+        bool valid = !r.skip && total <= capacity - offset;
+        if(valid) {
+            record.resize(r.size);
+            std::memcpy(record.data(), ring + offset + sizeof(recordHeader),
+                        r.size);
+        }
+
+        //was the record overwritten while it was read
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(header->reserved.load(std::memory_order_relaxed) - tail > capacity) {
+            dropped++;
+            tail = header->last.load(std::memory_order_acquire);
+            continue;
+        }
+
+        if(r.skip) {
+            tail += capacity - offset;
+            continue;
+        }
+        if(!valid) {
+            yError() << "Corrupt shared memory record";
+            return false;
+        }
+
+        tail += total;
+        data = record.data();
+        size = record.size();
+        envelope = yarp::os::Stamp(r.count, r.time);
+        return true;
+    }
+}
+
+#else
+
+vShmWriter::vShmWriter() : header(nullptr), ring(nullptr), mapped(0), head(0),
+    pending_pos(0), pending_total(0) {}
+vShmWriter::~vShmWriter() {}
+
+bool vShmWriter::open(const std::string &portname, size_t bytes)
+{
+    yWarning() << "Shared memory is only available on linux:" << portname
+               << "will use YARP only";
+    return false;
+}
+
+void vShmWriter::close() {}
+unsigned int vShmWriter::queryReaders() const { return 0; }
+char * vShmWriter::prepare(size_t, const yarp::os::Stamp &) { return nullptr; }
+void vShmWriter::publish() {}
+
+vShmReader::vShmReader() : header(nullptr), ring(nullptr), mapped(0), tail(0),
+    released(false), dropped(0) {}
+vShmReader::~vShmReader() {}
+bool vShmReader::open(const std::string &) { return false; }
+void vShmReader::close() {}
+void vShmReader::release() { released = true; }
+bool vShmReader::read(const char *&, size_t &, yarp::os::Stamp &) { return false; }
+
+#endif
+
+}
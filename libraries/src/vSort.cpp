@@ -0,0 +1,310 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vSort.h"
+#include "iCub/eventdriven/vtsHelper.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace ev {
+
+bool temporalSortStraight(const event<> &e1, const event<> &e2) {
+    return e2->stamp > e1->stamp;
+}
+
+bool temporalSortWrap(const event<> &e1, const event<> &e2)
+{
+#ifdef VLIB_TIMESTAMP_64
+    //unwrapped timestamps are in order
+    return e2->stamp > e1->stamp;
+#else
+    if((unsigned int)(std::abs(e1->stamp - e2->stamp)) > vtsHelper::max_stamp/2)
+        return e1->stamp > e2->stamp;
+    else
+        return e2->stamp > e1->stamp;
+#endif
+}
+
+//the events are sorted as (key, position) pairs and moved once at the end
+struct sortItem {
+    std::uint64_t key;
+    std::uint32_t index;
+};
+
+inline bool operator<(const sortItem &a, const sortItem &b)
+{
+    return a.key < b.key;
+}
+
+//below this size an insertion sort is used
+static const size_t small_sort = 32;
+
+//memory is kept between calls to avoid allocation on every sort
+struct sortBuffers {
+    std::vector<sortItem> items;
+    std::vector<sortItem> swap;
+    std::vector<size_t> runs;
+    std::vector< event<> > events;
+};
+
+static sortBuffers & buffers()
+{
+    static thread_local sortBuffers b;
+    return b;
+}
+
+/// \brief fill the sort keys and return the range of the keys
+static std::uint64_t makeKeys(const vQueue &q, bool respectWraps,
+                              std::vector<sortItem> &items, std::uint64_t &kmin)
+{
+    size_t n = q.size();
+    items.resize(n);
+
+    std::uint64_t offset = 0, mask = ~(std::uint64_t)0;
+#ifndef VLIB_TIMESTAMP_64
+    //stamps are placed in a window of the timestamp range centred on the
+    //first event, such that wrapped stamps come after it
+    if(respectWraps) {
+        offset = vtsHelper::max_stamp / 2 + 1 - q.front()->stamp;
+        mask = vtsHelper::max_stamp;
+    }
+#endif
+
+    std::uint64_t kmax = 0;
+    kmin = ~(std::uint64_t)0;
+    for(size_t i = 0; i < n; i++) {
+        std::uint64_t key = ((std::uint64_t)q[i]->stamp + offset) & mask;
+        items[i].key = key;
+        items[i].index = i;
+        kmin = std::min(kmin, key);
+        kmax = std::max(kmax, key);
+    }
+
+    return kmax - kmin;
+}
+
+/// \brief find the sorted runs, reversing the strictly descending ones.
+/// Returns the number of runs, whose boundaries are stored in runs.
+static size_t findRuns(std::vector<sortItem> &items, std::vector<size_t> &runs,
+                       bool &reordered)
+{
+    size_t n = items.size(), i = 0;
+    runs.clear();
+    reordered = false;
+
+    while(i < n) {
+        runs.push_back(i);
+        size_t j = i + 1;
+        if(j < n && items[j].key < items[i].key) {
+            while(j < n && items[j].key < items[j-1].key) j++;
+            std::reverse(items.begin() + i, items.begin() + j);
+            reordered = true;
+        } else {
+            while(j < n && items[j].key >= items[j-1].key) j++;
+        }
+        i = j;
+    }
+    runs.push_back(n);
+
+    return runs.size() - 1;
+}
+
+/// \brief merge pairs of neighbouring runs until one run is left
+static void mergeRuns(std::vector<sortItem> &items, std::vector<size_t> &runs,
+                      std::vector<sortItem> &swap)
+{
+    swap.resize(items.size());
+    std::vector<sortItem> *from = &items, *to = &swap;
+
+    while(runs.size() > 2) {
+        size_t k = 0, r = 0;
+        for(; r + 2 < runs.size(); r += 2) {
+            std::merge(from->begin() + runs[r], from->begin() + runs[r+1],
+                       from->begin() + runs[r+1], from->begin() + runs[r+2],
+                       to->begin() + runs[r]);
+            runs[k++] = runs[r];
+        }
+        if(r + 1 < runs.size()) {
+            std::copy(from->begin() + runs[r], from->begin() + runs[r+1],
+                      to->begin() + runs[r]);
+            runs[k++] = runs[r];
+        }
+        runs[k++] = runs.back();
+        runs.resize(k);
+        std::swap(from, to);
+    }
+
+    if(from != &items)
+        items.swap(swap);
+}
+
+/// \brief LSD radix sort on 8 bit digits of (key - kmin). Digits that are
+/// the same for all events are skipped.
+static void radixSort(std::vector<sortItem> &items, std::uint64_t kmin,
+                      std::uint64_t range, std::vector<sortItem> &swap)
+{
+    size_t n = items.size();
+    swap.resize(n);
+    std::vector<sortItem> *from = &items, *to = &swap;
+
+    for(int shift = 0; shift < 64 && (range >> shift); shift += 8) {
+
+        size_t count[256] = {0};
+        for(size_t i = 0; i < n; i++)
+            count[(((*from)[i].key - kmin) >> shift) & 0xFF]++;
+        if(count[(((*from)[0].key - kmin) >> shift) & 0xFF] == n)
+            continue;
+
+        size_t pos = 0;
+        for(int d = 0; d < 256; d++) {
+            size_t c = count[d];
+            count[d] = pos;
+            pos += c;
+        }
+
+        for(size_t i = 0; i < n; i++) {
+            const sortItem &item = (*from)[i];
+            (*to)[count[((item.key - kmin) >> shift) & 0xFF]++] = item;
+        }
+        std::swap(from, to);
+    }
+
+    if(from != &items)
+        items.swap(swap);
+}
+
+/// \brief a stable insertion sort for small queues
+static void insertionSort(std::vector<sortItem> &items)
+{
+    for(size_t i = 1; i < items.size(); i++) {
+        sortItem item = items[i];
+        size_t j = i;
+        for(; j > 0 && item.key < items[j-1].key; j--)
+            items[j] = items[j-1];
+        items[j] = item;
+    }
+}
+
+/// \brief move the events of q into the order of the items
+static void applyOrder(vQueue &q, const std::vector<sortItem> &items,
+                       std::vector< event<> > &events)
+{
+    size_t n = q.size();
+    events.resize(n);
+    for(size_t i = 0; i < n; i++)
+        events[i] = std::move(q[i]);
+    for(size_t i = 0; i < n; i++)
+        q[i] = std::move(events[items[i].index]);
+}
+
+void qsort(vQueue &q, bool respectWraps, sortMethod method)
+{
+    if(q.size() < 2) return;
+
+    if(method == SORT_STD) {
+        if(respectWraps)
+            std::sort(q.begin(), q.end(), temporalSortWrap);
+        else
+            std::sort(q.begin(), q.end(), temporalSortStraight);
+        return;
+    }
+
+    sortBuffers &b = buffers();
+    std::uint64_t kmin;
+    std::uint64_t range = makeKeys(q, respectWraps, b.items, kmin);
+
+    if(method == SORT_RADIX) {
+        radixSort(b.items, kmin, range, b.swap);
+        applyOrder(q, b.items, b.events);
+        return;
+    }
+
+    bool reordered;
+    size_t nruns = findRuns(b.items, b.runs, reordered);
+    if(nruns == 1 && !reordered)
+        return;
+
+    if(method == SORT_AUTO && q.size() <= small_sort) {
+        insertionSort(b.items);
+    } else if(method == SORT_MERGE || nruns == 1) {
+        mergeRuns(b.items, b.runs, b.swap);
+    } else {
+        //each level of merging and each radix digit is a pass over the data
+        int levels = 0, digits = 0;
+        while(((size_t)1 << levels) < nruns) levels++;
+        while(digits < 8 && (range >> (8 * digits))) digits++;
+        if(levels <= digits)
+            mergeRuns(b.items, b.runs, b.swap);
+        else
+            radixSort(b.items, kmin, range, b.swap);
+    }
+
+    applyOrder(q, b.items, b.events);
+}
+
+void qsort(vQueue &q, bool respectWraps)
+{
+    qsort(q, respectWraps, SORT_AUTO);
+}
+
+//the order of the stable sorts, in which equal keys keep their positions
+struct stableBefore {
+    bool operator()(const sortItem &a, const sortItem &b) const
+    {
+        return a.key < b.key || (a.key == b.key && a.index < b.index);
+    }
+};
+
+struct stableAfter {
+    bool operator()(const sortItem &a, const sortItem &b) const
+    {
+        return stableBefore()(b, a);
+    }
+};
+
+void qsortNewest(vQueue &q, size_t n, bool respectWraps)
+{
+    //the radix sort of qsort is faster than the selection unless most of the
+    //events are removed
+    if(q.size() <= 4 * n) {
+        qsort(q, respectWraps);
+        while(q.size() > n) q.pop_front();
+        return;
+    }
+
+    sortBuffers &b = buffers();
+    std::uint64_t kmin;
+    makeKeys(q, respectWraps, b.items, kmin);
+
+    //select the n last events of the sorted order, then sort only those
+    std::nth_element(b.items.begin(), b.items.begin() + n, b.items.end(),
+                     stableAfter());
+    b.items.resize(n);
+    std::sort(b.items.begin(), b.items.end(), stableBefore());
+
+    b.events.resize(n);
+    for(size_t i = 0; i < n; i++)
+        b.events[i] = std::move(q[b.items[i].index]);
+    q.resize(n);
+    for(size_t i = 0; i < n; i++)
+        q[i] = std::move(b.events[i]);
+}
+
+}
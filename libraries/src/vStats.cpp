@@ -0,0 +1,150 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vStats.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ev {
+
+/*////////////////////////////////////////////////////////////////////////////*/
+//vHistogram
+/*////////////////////////////////////////////////////////////////////////////*/
+
+vHistogram::vHistogram() : maximum(0)
+{
+    for(int i = 0; i < buckets; i++)
+        counts[i] = 0;
+}
+
+vHistogramSnapshot vHistogram::take()
+{
+    vHistogramSnapshot s;
+    s.counts.resize(buckets);
+    for(int i = 0; i < buckets; i++) {
+        s.counts[i] = counts[i].exchange(0, std::memory_order_relaxed);
+        s.total += s.counts[i];
+    }
+    s.maximum = maximum.exchange(0, std::memory_order_relaxed);
+    return s;
+}
+
+std::uint64_t vHistogramSnapshot::percentile(double percent) const
+{
+    if(!total) return 0;
+    std::uint64_t target = (std::uint64_t)std::ceil(total * percent / 100.0);
+    if(target < 1) target = 1;
+
+    std::uint64_t seen = 0;
+    for(size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if(seen >= target) {
+            std::uint64_t highest = vHistogram::lowestOf(i + 1) - 1;
+            return std::min(highest, maximum);
+        }
+    }
+    return maximum;
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+//vStatsPublisher
+/*////////////////////////////////////////////////////////////////////////////*/
+
+vStatsPublisher::vStatsPublisher() : stop(false), period(1.0)
+{
+}
+
+vStatsPublisher::~vStatsPublisher()
+{
+    close();
+}
+
+bool vStatsPublisher::open(std::string module, double period)
+{
+    if(module.empty() || module[0] != '/')
+        module = "/" + module;
+    if(!port.open(module + "/stats:o")) {
+        yError() << "Could not open" << module + "/stats:o";
+        return false;
+    }
+    this->period = period;
+    stop = false;
+    publisher = std::thread(&vStatsPublisher::publishLoop, this);
+    return true;
+}
+
+void vStatsPublisher::close()
+{
+    if(!publisher.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        stop = true;
+        cv.notify_all();
+    }
+    publisher.join();
+    port.close();
+}
+
+void vStatsPublisher::add(const std::string &name, vHistogram *histogram,
+                          double scale)
+{
+    std::lock_guard<std::mutex> lock(m);
+    entry e;
+    e.name = name;
+    e.histogram = histogram;
+    e.scale = scale;
+    entries.push_back(e);
+}
+
+yarp::os::Bottle vStatsPublisher::collect()
+{
+    yarp::os::Bottle b;
+    std::lock_guard<std::mutex> lock(m);
+    for(size_t i = 0; i < entries.size(); i++) {
+        vHistogramSnapshot s = entries[i].histogram->take();
+        double scale = entries[i].scale;
+        yarp::os::Bottle &h = b.addList();
+        h.addString(entries[i].name);
+        h.addInt((int)s.total);
+        h.addDouble(s.percentile(50) * scale);
+        h.addDouble(s.percentile(90) * scale);
+        h.addDouble(s.percentile(99) * scale);
+        h.addDouble(s.maximum * scale);
+    }
+    return b;
+}
+
+void vStatsPublisher::publishLoop()
+{
+    std::unique_lock<std::mutex> lock(m);
+    auto next = std::chrono::steady_clock::now();
+    while(true) {
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(period));
+        cv.wait_until(lock, next, [this]{ return stop; });
+        if(stop) return;
+
+        lock.unlock();
+        yarp::os::Bottle &out = port.prepare();
+        out = collect();
+        port.write();
+        lock.lock();
+    }
+}
+
+}
@@ -17,7 +17,10 @@
  */
 
 #include "iCub/eventdriven/vWindow_adv.h"
+#include "iCub/eventdriven/vSort.h"
 #include <math.h>
+#include <cstring>
+#include <cstdlib>
 
 namespace ev {
 
@@ -55,6 +58,16 @@ void vSurface2::fastAddEvent(event <> v, bool onlyAdd)
 
 }
 
+void vSurface2::fastAddPacket(const vPacket<AE> &p, int channel)
+{
+    for(size_t i = 0; i < p.size(); i++) {
+        if(channel >= 0 && p.channel[i] != channel) continue;
+        auto v = make_event<AE>();
+        p.get(i, *v);
+        fastAddEvent(v);
+    }
+}
+
 vQueue vSurface2::addEvent(event<> v)
 {
     auto c = is_event<AE>(v);
@@ -139,7 +152,7 @@ vQueue vSurface2::getSurf_Tlim(int dt)
     vQueue qcopy;
     if(q.empty()) return qcopy;
 
-    int t = q.back()->stamp;
+    stamp_t t = q.back()->stamp;
 
     for(vQueue::reverse_iterator rqit = q.rbegin(); rqit != q.rend(); rqit++) {
 
@@ -148,9 +161,7 @@ vQueue vSurface2::getSurf_Tlim(int dt)
         if(v != spatial[v->y][v->x]) continue;
 
         //check temporal constraint
-        int vt = (*rqit)->stamp;
-        if(vt > t) vt -= vtsHelper::max_stamp;
-        if(vt + dt <= t) break;
+        if(vtsHelper::elapsed(t, (*rqit)->stamp) >= dt) break;
 
         qcopy.push_back(v);
     }
@@ -183,7 +194,7 @@ vQueue vSurface2::getSurf_Tlim(int dt, int xl, int xh, int yl, int yh)
     vQueue qcopy;
     if(q.empty()) return qcopy;
 
-    int t = q.back()->stamp;
+    stamp_t t = q.back()->stamp;
 
     for(vQueue::reverse_iterator rqit = q.rbegin(); rqit != q.rend(); rqit++) {
 
@@ -192,9 +203,7 @@ vQueue vSurface2::getSurf_Tlim(int dt, int xl, int xh, int yl, int yh)
         if(v != spatial[v->y][v->x]) continue;
 
         //check temporal constraint
-        int vt = (*rqit)->stamp;
-        if(vt > t) vt -= vtsHelper::max_stamp;
-        if(vt + dt <= t) break;
+        if(vtsHelper::elapsed(t, (*rqit)->stamp) >= dt) break;
 
         //check spatial constraint
         if(v->x >= xl && v->x <= xh) {
@@ -247,9 +256,8 @@ vQueue vSurface2::getSurf_Clim(int c, int xl, int xh, int yl, int yh)
         }
     }
 
-    qsort(qcopy, true);
-    while(qcopy.size() > (unsigned int)c)
-        qcopy.pop_front();
+    //only the c most recent events are sorted
+    qsortNewest(qcopy, (unsigned int)c, true);
 
     return qcopy;
 }
@@ -273,9 +281,7 @@ vQueue temporalSurface::removeEvents(event<> toAdd)
     vQueue removed;
 
     //calculate event window boundaries based on latest timestamp
-    int ctime = toAdd->stamp;
-    int upper = ctime + vtsHelper::max_stamp - duration;
-    int lower = ctime - duration;
+    stamp_t ctime = toAdd->stamp;
 
     //remove any events falling out the back of the window
     while(q.size()) {
@@ -286,9 +292,7 @@ vQueue temporalSurface::removeEvents(event<> toAdd)
             continue;
         }
 
-        int vtime = q.front()->stamp;
-
-        if((vtime > ctime && vtime < upper) || vtime < lower) {
+        if(vtsHelper::elapsed(ctime, q.front()->stamp) > duration) {
             removed.push_back(q.front());
             if(v) spatial[v->y][v->x] = NULL;
             q.pop_front();
@@ -306,9 +310,7 @@ vQueue temporalSurface::removeEvents(event<> toAdd)
             continue;
         }
 
-        int vtime = q.back()->stamp;
-
-        if((vtime > ctime && vtime < upper) || vtime < lower) {
+        if(vtsHelper::elapsed(ctime, q.back()->stamp) > duration) {
             removed.push_back(q.back());
             if(v) spatial[v->y][v->x] = NULL;
             q.pop_back();
@@ -326,9 +328,7 @@ void temporalSurface::fastRemoveEvents(event<> toAdd)
 {
 
     //calculate event window boundaries based on latest timestamp
-    int ctime = toAdd->stamp;
-    int upper = ctime + vtsHelper::max_stamp - duration;
-    int lower = ctime - duration;
+    stamp_t ctime = toAdd->stamp;
 
     //remove any events falling out the back of the window
     while(q.size()) {
@@ -339,9 +339,7 @@ void temporalSurface::fastRemoveEvents(event<> toAdd)
             continue;
         }
 
-        int vtime = v->stamp;
-
-        if((vtime > ctime && vtime < upper) || vtime < lower) {
+        if(vtsHelper::elapsed(ctime, v->stamp) > duration) {
             if(v) spatial[v->y][v->x] = NULL;
             q.pop_front();
             count--;
@@ -443,20 +441,16 @@ vQueue lifetimeSurface::removeEvents(event<> toAdd)
     if(!toAddflow)
         return vQueue();
 
-    int cts = toAddflow->stamp;
+    stamp_t cts = toAddflow->stamp;
     int cx = toAddflow->x; int cy = toAddflow->y;
 
 
     vQueue::iterator i = q.begin();
     while(i != q.end()) {
         event<FlowEvent> v = std::static_pointer_cast<FlowEvent>(*i);
-        int modts = cts;
-        if(cts < v->stamp) //we have wrapped
-            modts += vtsHelper::max_stamp;
-
         bool samelocation = v->x == cx && v->y == cy;
 
-        if(modts > v->getDeath() || samelocation) {
+        if(vtsHelper::elapsed(cts, v->stamp) > v->getLifetime() || samelocation) {
             //it could be dangerous if spatial gets more than 1 event per pixel
             removed.push_back(*i);
             spatial[v->y][v->x] = NULL;
@@ -479,20 +473,16 @@ void lifetimeSurface::fastRemoveEvents(event<> toAdd)
     if(!toAddflow)
         return;
 
-    int cts = toAddflow->stamp;
+    stamp_t cts = toAddflow->stamp;
     int cx = toAddflow->x; int cy = toAddflow->y;
 
 
     vQueue::iterator i = q.begin();
     while(i != q.end()) {
         event<FlowEvent> v = std::static_pointer_cast<FlowEvent>(*i);
-        int modts = cts;
-        if(cts < v->stamp) //we have wrapped
-            modts += vtsHelper::max_stamp;
-
         bool samelocation = v->x == cx && v->y == cy;
 
-        if(modts > v->getDeath() || samelocation) {
+        if(vtsHelper::elapsed(cts, v->stamp) > v->getLifetime() || samelocation) {
             //it could be dangerous if spatial gets more than 1 event per pixel
             spatial[v->y][v->x] = NULL;
             i = q.erase(i);
@@ -754,9 +744,96 @@ const vQueue vFuzzyEdge::getSURF(int xl, int xh, int yl, int yh)
 
 /******************************************************************************/
 
+historicalSurface::historicalSurface()
+{
+    generation = 0;
+    width = 0;
+    first_bucket = 0;
+    clock = 0;
+    latest = 0;
+    popped = 0;
+
+    //the history is indexed every 1 ms
+    bucket_size = std::max(1.0, 0.001 * vtsHelper::vtsscaler);
+}
+
 void historicalSurface::initialise(int height, int width)
 {
-    surface.resize(width, height);
+    this->width = width;
+    visited.assign(width * height, 0);
+    generation = 0;
+}
+
+void historicalSurface::push(const event<> &v)
+{
+    if(q.empty()) {
+        index.clear();
+        clock = 0;
+        latest = v->stamp;
+    }
+
+    //the clock only moves forward. An event older than the most recent is
+    //indexed at the time of the most recent.
+    vtsHelper::advance(clock, latest, v->stamp);
+
+    std::uint64_t position = popped + q.size();
+    std::int64_t bucket = clock / bucket_size;
+    if(index.empty()) first_bucket = bucket;
+    while(first_bucket + (std::int64_t)index.size() <= bucket)
+        index.push_back(position);
+
+    q.push_back(v);
+}
+
+void historicalSurface::pop()
+{
+    q.pop_front();
+    popped++;
+    while(index.size() > 1 && index[1] <= popped) {
+        index.pop_front();
+        first_bucket++;
+    }
+}
+
+void historicalSurface::addEvent(event<> v)
+{
+    stamp_t ctime = v->stamp;
+    while(q.size() && vtsHelper::elapsed(ctime, q.front()->stamp) > tLower)
+        pop();
+    push(v);
+}
+
+void historicalSurface::addEvents(const vQueue &events)
+{
+    vQueue::const_iterator qi;
+    for(qi = events.begin(); qi != events.end() - 1; qi++)
+        push(*qi);
+
+    addEvent(events.back());
+}
+
+void historicalSurface::nextGeneration()
+{
+    //markers are only cleared when the generation wraps
+    if(++generation == 0) {
+        std::fill(visited.begin(), visited.end(), 0);
+        generation = 1;
+    }
+}
+
+size_t historicalSurface::startOf(int queryTime)
+{
+    //the number of events, from the oldest, that can be older than
+    //queryTime. Events of the bucket after the bucket of queryTime are also
+    //included, in case they arrived slightly out of order.
+    if(queryTime <= 0 || index.empty()) return q.size();
+
+    std::int64_t t = clock - queryTime;
+    std::int64_t bucket = t / bucket_size - (t % bucket_size < 0) + 2;
+    std::int64_t i = bucket - first_bucket;
+    if(i >= (std::int64_t)index.size()) return q.size();
+    if(i < 0) return 0;
+    return index[i] > popped ? index[i] - popped : 0;
 }
 
 vQueue historicalSurface::getSurface(int queryTime, int queryWindow)
@@ -764,20 +841,20 @@ vQueue historicalSurface::getSurface(int queryTime, int queryWindow)
     if(q.empty()) return vQueue();
 
     vQueue qret;
-    int ctime = q.back()->stamp;
+    stamp_t ctime = q.back()->stamp;
     int breaktime = queryTime + queryWindow;
-    surface.zero();
+    nextGeneration();
 
-    for(vQueue::reverse_iterator qi = q.rbegin(); qi != q.rend(); qi++) {
-        auto v = is_event<AE>(*qi);
-        if(surface(v->x, v->y)) continue;
+    for(size_t i = startOf(queryTime); i-- > 0;) {
+        auto v = is_event<AE>(q[i]);
+        unsigned int &marker = visited[v->y * width + v->x];
+        if(marker == generation) continue;
 
-        double cdeltat = ctime - v->stamp;
-        if(cdeltat < 0) cdeltat += vtsHelper::max_stamp;
+        double cdeltat = vtsHelper::elapsed(ctime, v->stamp);
         if(cdeltat > breaktime) break;
         if(cdeltat > queryTime) {
-            qret.push_back(*qi);
-            surface(v->x, v->y) = 1;
+            qret.push_back(q[i]);
+            marker = generation;
         }
     }
     return qret;
@@ -801,21 +878,21 @@ vQueue historicalSurface::getSurface(int queryTime, int queryWindow, int xl, int
     if(q.empty()) return vQueue();
 
     vQueue qret;
-    int ctime = q.back()->stamp;
+    stamp_t ctime = q.back()->stamp;
     int breaktime = queryTime + queryWindow;
-    surface.zero();
+    nextGeneration();
 
-    for(vQueue::reverse_iterator qi = q.rbegin(); qi != q.rend(); qi++) {
-        auto v = is_event<AE>(*qi);
-        if(surface(v->x, v->y)) continue;
+    for(size_t i = startOf(queryTime); i-- > 0;) {
+        auto v = is_event<AE>(q[i]);
+        unsigned int &marker = visited[v->y * width + v->x];
+        if(marker == generation) continue;
 
-        double cdeltat = ctime - v->stamp;
-        if(cdeltat < 0) cdeltat += vtsHelper::max_stamp;
+        double cdeltat = vtsHelper::elapsed(ctime, v->stamp);
         if(cdeltat > breaktime) break;
         if(cdeltat > queryTime) {
-            surface(v->x, v->y) = 1;
+            marker = generation;
             if(v->x >= xl && v->x <= xh && v->y >= yl && v->y <= yh)
-                qret.push_back(*qi);
+                qret.push_back(q[i]);
         }
     }
     return qret;
@@ -839,30 +916,410 @@ void historicalSurface::getSurfaceN(ev::vQueue &qret, int queryTime, int numEven
 {
     if(q.empty()) return; // vQueue();
 
-//    vQueue qret;
-    int ctime = q.back()->stamp;
+    stamp_t ctime = q.back()->stamp;
     int countEvents = 0;
-    surface.zero();
+    nextGeneration();
 
-    for(vQueue::reverse_iterator qi = q.rbegin(); qi != q.rend(); qi++) {
-        auto v = is_event<AE>(*qi);
+    for(size_t i = startOf(queryTime); i-- > 0;) {
+        auto v = is_event<AE>(q[i]);
+        unsigned int &marker = visited[v->y * width + v->x];
+        if(marker == generation) continue;
 
-        if(surface(v->x, v->y)) continue;
-
-        int cdeltat = ctime - v->stamp;
-        if(cdeltat < 0) cdeltat += vtsHelper::max_stamp;
+        int cdeltat = vtsHelper::elapsed(ctime, v->stamp);
         if(cdeltat < queryTime) continue;
 
-        surface(v->x, v->y) = 1;
+        marker = generation;
         if(v->x >= xl && v->x <= xh && v->y >= yl && v->y <= yh) {
-            qret.push_back(*qi);
+            qret.push_back(q[i]);
             countEvents++;
         }
 
         if(countEvents > numEvents) break;
     }
-//    return qret;
 }
 
+/******************************************************************************/
+//concurrentSurface
+/******************************************************************************/
+
+//each thread marks the pixels visited by its queries in its own markers
+struct surfaceMarkers {
+    std::vector<unsigned int> visited;
+    unsigned int generation;
+};
+
+static surfaceMarkers & nextMarkers(size_t pixels)
+{
+    static thread_local surfaceMarkers m;
+    if(m.visited.size() < pixels) {
+        m.visited.assign(pixels, 0);
+        m.generation = 0;
+    }
+    if(++m.generation == 0) {
+        std::fill(m.visited.begin(), m.visited.end(), 0);
+        m.generation = 1;
+    }
+    return m;
+}
+
+//flags returned for each event of a scan
+enum { SCAN_SKIP = 0, SCAN_MARK = 1, SCAN_STOP = 2 };
+
+concurrentSurface::concurrentSurface()
+{
+    mask = 0;
+    head = 0;
+    width = height = 0;
+    clock = 0;
+    latest = 0;
+
+    //as the historicalSurface: 2 seconds or 1/2 of the max stamp, and events
+    //1 ms more recent than a query time are read in case they are out of
+    //order
+    tLower = std::min(vtsHelper::max_stamp * 0.45, vtsHelper::vtsscaler * 2.0);
+    margin = std::max(1.0, 0.001 * vtsHelper::vtsscaler);
+}
+
+void concurrentSurface::initialise(int height, int width, size_t capacity)
+{
+    this->width = width;
+    this->height = height;
+
+    size_t n = 1;
+    while(n < capacity) n <<= 1;
+    std::vector<slot>(n).swap(ring);
+    for(size_t i = 0; i < ring.size(); i++)
+        ring[i].seq.store(0, std::memory_order_relaxed);
+    mask = n - 1;
+    head.store(0, std::memory_order_release);
+}
+
+void concurrentSurface::addEvent(const AddressEvent &v)
+{
+    if(ring.empty() || v.x >= width || v.y >= height)
+        return;
+
+    std::uint64_t h = head.load(std::memory_order_relaxed);
+    if(!h) {
+        clock = 0;
+        latest = v.stamp;
+    }
+
+    //the clock only moves forward, as the historicalSurface
+    vtsHelper::advance(clock, latest, v.stamp);
+
+    //the slot is marked as written before, and numbered after, its contents
+    //change, such that a reader can tell it read a consistent event
+    slot &sl = ring[h & mask];
+    sl.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    sl.clock.store(clock, std::memory_order_relaxed);
+    sl.stamp.store(v.stamp, std::memory_order_relaxed);
+    sl.address.store((std::uint64_t)v.x | ((std::uint64_t)v.y << 16) |
+                     ((std::uint64_t)v.polarity << 32) |
+                     ((std::uint64_t)v.channel << 33),
+                     std::memory_order_relaxed);
+    sl.seq.store(h + 1, std::memory_order_release);
+    head.store(h + 1, std::memory_order_release);
+}
+
+void concurrentSurface::addEvents(const vQueue &events)
+{
+    for(size_t i = 0; i < events.size(); i++)
+        addEvent(*is_event<AE>(events[i]));
+}
+
+bool concurrentSurface::read(std::uint64_t s, entry &e) const
+{
+    const slot &sl = ring[s & mask];
+    if(sl.seq.load(std::memory_order_acquire) != s + 1)
+        return false;
+
+    e.clock = sl.clock.load(std::memory_order_relaxed);
+    e.stamp = sl.stamp.load(std::memory_order_relaxed);
+    std::uint64_t a = sl.address.load(std::memory_order_relaxed);
+
+    //valid only if the slot was not written while it was read
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(sl.seq.load(std::memory_order_relaxed) != s + 1)
+        return false;
+
+    e.x = a & 0xFFFF;
+    e.y = (a >> 16) & 0xFFFF;
+    e.polarity = (a >> 32) & 1;
+    e.channel = (a >> 33) & 1;
+    return true;
+}
+
+std::uint64_t concurrentSurface::startOf(std::uint64_t h, std::int64_t now,
+                                         int queryTime) const
+{
+    //the first position with a clock after queryTime (less the margin), by
+    //bisection. An overwritten slot is before any position still in the ring.
+    if(queryTime <= 0) return h;
+    std::int64_t t = now - queryTime + margin;
+    std::uint64_t lo = h > ring.size() ? h - ring.size() : 0, hi = h;
+    while(lo < hi) {
+        std::uint64_t mid = lo + (hi - lo) / 2;
+        entry e;
+        if(!read(mid, e) || e.clock <= t)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+template <typename F> void concurrentSurface::scan(int queryTime, F f) const
+{
+    //the snapshot is the events before h
+    std::uint64_t h = head.load(std::memory_order_acquire);
+    entry now;
+    if(!h || !read(h - 1, now)) return;
+
+    surfaceMarkers &m = nextMarkers(width * height);
+    std::uint64_t oldest = h > ring.size() ? h - ring.size() : 0;
+    for(std::uint64_t s = startOf(h, now.clock, queryTime); s-- > oldest;) {
+        entry e;
+        if(!read(s, e) || now.clock - e.clock > tLower) break;
+
+        unsigned int &marker = m.visited[e.y * width + e.x];
+        if(marker == m.generation) continue;
+
+        int flags = f(now, e, (int)vtsHelper::elapsed(now.stamp, e.stamp));
+        if(flags & SCAN_MARK) marker = m.generation;
+        if(flags & SCAN_STOP) break;
+    }
+}
+
+static event<> toEvent(stamp_t stamp, int x, int y, int polarity, int channel)
+{
+    auto v = make_event<AE>();
+    v->stamp = stamp;
+    v->x = x;
+    v->y = y;
+    v->polarity = polarity;
+    v->channel = channel;
+    return v;
+}
+
+vQueue concurrentSurface::getSurface(int queryTime, int queryWindow) const
+{
+    return getSurface(queryTime, queryWindow, 0, width - 1, 0, height - 1);
+}
+
+vQueue concurrentSurface::getSurface(int queryTime, int queryWindow, int d,
+                                     int x, int y) const
+{
+    return getSurface(queryTime, queryWindow, x - d, x + d, y - d, y + d);
+}
+
+vQueue concurrentSurface::getSurface(int queryTime, int queryWindow, int xl,
+                                     int xh, int yl, int yh) const
+{
+    vQueue qret;
+    int breaktime = queryTime + queryWindow;
+    scan(queryTime, [&](const entry &, const entry &e, int cdeltat) {
+        if(cdeltat > breaktime) return (int)SCAN_STOP;
+        if(cdeltat <= queryTime) return (int)SCAN_SKIP;
+        if(e.x >= xl && e.x <= xh && e.y >= yl && e.y <= yh)
+            qret.push_back(toEvent(e.stamp, e.x, e.y, e.polarity, e.channel));
+        return (int)SCAN_MARK;
+    });
+    return qret;
+}
+
+void concurrentSurface::getSurfaceN(ev::vQueue &qret, int queryTime,
+                                    int numEvents, int d) const
+{
+    //centred on the most recent event of the snapshot
+    int countEvents = 0;
+    scan(queryTime, [&](const entry &now, const entry &e, int cdeltat) {
+        if(cdeltat < queryTime) return (int)SCAN_SKIP;
+        if(std::abs(e.x - now.x) <= d && std::abs(e.y - now.y) <= d) {
+            qret.push_back(toEvent(e.stamp, e.x, e.y, e.polarity, e.channel));
+            countEvents++;
+        }
+        return countEvents > numEvents ? SCAN_MARK | SCAN_STOP : (int)SCAN_MARK;
+    });
+}
+
+void concurrentSurface::getSurfaceN(ev::vQueue &qret, int queryTime,
+                                    int numEvents, int xl, int xh, int yl,
+                                    int yh) const
+{
+    int countEvents = 0;
+    scan(queryTime, [&](const entry &, const entry &e, int cdeltat) {
+        if(cdeltat < queryTime) return (int)SCAN_SKIP;
+        if(e.x >= xl && e.x <= xh && e.y >= yl && e.y <= yh) {
+            qret.push_back(toEvent(e.stamp, e.x, e.y, e.polarity, e.channel));
+            countEvents++;
+        }
+        return countEvents > numEvents ? SCAN_MARK | SCAN_STOP : (int)SCAN_MARK;
+    });
+}
+
+/******************************************************************************/
+//decaySurface
+/******************************************************************************/
+
+//the time of a pixel without an event, from base
+static const std::int32_t decayed = -(1 << 30);
+
+decaySurface::decaySurface(int width, int height, int tau, int channels)
+{
+    this->width = width;
+    this->height = height;
+    this->channels = channels;
+    planes.resize(2 * channels * width * height);
+    setDecay(tau);
+    clear();
+}
+
+void decaySurface::setDecay(int tau)
+{
+    rate = 1.0f / std::max(tau, 1);
+}
+
+void decaySurface::clear()
+{
+    std::fill(planes.begin(), planes.end(), decayed);
+    base = 0;
+    clock = 0;
+    latest = 0;
+    started = false;
+}
+
+void decaySurface::rebase()
+{
+    //the clock becomes 0, and pixels that become older than the time of an
+    //empty pixel are empty
+    std::int64_t shift = clock - base;
+    for(size_t i = 0; i < planes.size(); i++)
+        planes[i] = std::max((std::int64_t)planes[i] - shift,
+                             (std::int64_t)decayed);
+    base = clock;
+}
+
+void decaySurface::addEvent(stamp_t stamp, int x, int y, int polarity,
+                            int channel)
+{
+    if(x < 0 || y < 0 || x >= width || y >= height ||
+            channel < 0 || channel >= channels)
+        return;
+
+    if(!started) {
+        latest = stamp;
+        started = true;
+    }
+
+    //the clock only moves forward. An event older than the most recent is
+    //set at its age from the most recent.
+    std::int64_t t = vtsHelper::advance(clock, latest, stamp);
+    if(clock - base >= -decayed)
+        rebase();
+
+    std::int32_t &p = planes[(channel * 2 + (polarity ? 1 : 0)) * width * height
+            + y * width + x];
+    //an event older than the last at this pixel does not replace it
+    p = std::max<std::int64_t>(p, t - base);
+}
+
+void decaySurface::addEvent(const AddressEvent &v)
+{
+    addEvent(v.stamp, v.x, v.y, v.polarity, v.channel);
+}
+
+void decaySurface::addEvents(const vQueue &q)
+{
+    for(size_t i = 0; i < q.size(); i++) {
+        auto v = is_event<AE>(q[i]);
+        addEvent(v->stamp, v->x, v->y, v->polarity, v->channel);
+    }
+}
+
+void decaySurface::addPacket(const vPacket<AE> &p)
+{
+    for(size_t i = 0; i < p.size(); i++)
+        addEvent(p.stamp[i], p.x[i], p.y[i], p.polarity[i], p.channel[i]);
+}
+
+void decaySurface::clip(int &xl, int &xh, int &yl, int &yh) const
+{
+    xl = std::max(xl, 0);
+    xh = std::min(xh, width-1);
+    yl = std::max(yl, 0);
+    yh = std::min(yh, height-1);
+}
+
+//exp(x) for x in [-86, 0], as 2^i * 2^f where i = trunc(x log2(e)) and 2^f
+//is a polynomial on (-1, 0]. The result is 0 unless keep is all ones. There
+//is no branch, such that the loops calling it are vectorised by the compiler.
+static inline float decayExp(float x, std::int32_t keep)
+{
+    x *= 1.442695041f;
+    std::int32_t i = (std::int32_t)x;
+    float f = x - i;
+    float p = 1.0f + f * (0.693147181f + f * (0.240226507f + f *
+              (0.0555041087f + f * (0.00961812911f + f * 0.00133335581f))));
+    std::int32_t bits = ((i + 127) << 23) & keep;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+template <typename T> static void fillDecay(yarp::sig::ImageOf<T> &image,
+        const std::int32_t *plane, int width, std::int32_t now, float rate,
+        float gain, float offset, int xl, int xh, int yl, int yh)
+{
+    if(xl > xh || yl > yh) {
+        image.resize(0, 0);
+        return;
+    }
+
+    //pixels older than 2^-125 of decay, or without an event, are 0. The
+    //ages are limited in integers, where the comparison is not a branch.
+    std::int32_t oldest = std::max(-125.0 * M_LN2 / rate, (double)decayed);
+
+    image.resize(xh - xl + 1, yh - yl + 1);
+    for(int y = yl; y <= yh; y++) {
+        const std::int32_t *t = plane + y * width + xl;
+        T *out = (T *)(image.getRawImage() + (y - yl) * image.getRowSize());
+        for(int x = 0; x <= xh - xl; x++) {
+            std::int32_t age = std::max(t[x] - now, oldest);
+            out[x] = decayExp(age * rate, -(age > oldest)) * gain + offset;
+        }
+    }
+}
+
+void decaySurface::getSurface(yarp::sig::ImageOf<yarp::sig::PixelFloat> &image,
+                              int polarity, int channel, int xl, int xh,
+                              int yl, int yh) const
+{
+    clip(xl, xh, yl, yh);
+    fillDecay(image, plane(polarity, channel), width, clock - base, rate,
+              1.0f, 0.0f, xl, xh, yl, yh);
+}
+
+void decaySurface::getSurface(yarp::sig::ImageOf<yarp::sig::PixelFloat> &image,
+                              int polarity, int channel) const
+{
+    getSurface(image, polarity, channel, 0, width - 1, 0, height - 1);
+}
+
+void decaySurface::getSurface(yarp::sig::ImageOf<yarp::sig::PixelMono> &image,
+                              int polarity, int channel, int xl, int xh,
+                              int yl, int yh) const
+{
+    clip(xl, xh, yl, yh);
+    fillDecay(image, plane(polarity, channel), width, clock - base, rate,
+              255.0f, 0.5f, xl, xh, yl, yh);
+}
+
+void decaySurface::getSurface(yarp::sig::ImageOf<yarp::sig::PixelMono> &image,
+                              int polarity, int channel) const
+{
+    getSurface(image, polarity, channel, 0, width - 1, 0, height - 1);
+}
 
 }
@@ -147,9 +147,7 @@ vTempWindow::vTempWindow()
 
 void vTempWindow::addEvent(event<> v)
 {
-    int ctime = v->stamp;
-    int upper = ctime + tUpper;
-    int lower = ctime - tLower;
+    stamp_t ctime = v->stamp;
 
 //    while(q.size()) {
 //        int vtime = q.back()->stamp;
@@ -161,9 +159,7 @@ void vTempWindow::addEvent(event<> v)
 //    }
 
     while(q.size()) {
-
-        int vtime = q.front()->stamp;
-        if((vtime >= ctime && vtime < upper) || vtime < lower) {
+        if(vtsHelper::elapsed(ctime, q.front()->stamp) > tLower) {
             q.pop_front();
         } else {
             break;
@@ -48,6 +48,10 @@ private:
     yarp::sig::Vector leftTarget;
     yarp::sig::Vector rightTarget;
 
+    //the trace of the latest traced target
+    vTrace trace;
+    yarp::os::Mutex m;
+
 public:
 
     positionReader()
@@ -100,6 +104,14 @@ public:
             qi++;
         }
 
+        vTrace t;
+        if(vBottleIn.getTrace(t)) {
+            t.add(getName());
+            m.lock();
+            trace = t;
+            m.unlock();
+        }
+
     }
 
     void getTargets(yarp::sig::Vector &left, yarp::sig::Vector &right)
@@ -108,6 +120,17 @@ public:
         right = rightTarget;
     }
 
+    /// \brief the trace of the latest traced target received since the
+    /// previous call. Empty if none.
+    vTrace takeTrace()
+    {
+        m.lock();
+        vTrace latest;
+        latest.swap(trace);
+        m.unlock();
+        return latest;
+    }
+
 
 };
 
@@ -309,6 +332,7 @@ private:
     positionReader inputPort;
     yarp::os::BufferedPort<yarp::os::Bottle> cartOutPort;
     yarp::os::BufferedPort<yarp::sig::Vector> debugOutPort;
+    yarp::os::BufferedPort<yarp::os::Bottle> traceOutPort;
     yarp::sig::Vector arm_target_position;
 
     //the remote procedure port
@@ -83,6 +83,9 @@ bool vTrackToRobotModule::configure(yarp::os::ResourceFinder &rf)
     if(!debugOutPort.open(getName() + "/debug:o"))
         return false;
 
+    if(!traceOutPort.open(getName() + "/trace:o"))
+        return false;
+
     yarp::os::Property options;
     options.put("device", "gazecontrollerclient");
     options.put("local", getName());
@@ -421,6 +424,16 @@ bool vTrackToRobotModule::updateModule()
             controlArm(leftTarget, rightTarget);
     }
 
+    //complete the trace of a traced target with the time of the command
+    vTrace trace = inputPort.takeTrace();
+    if(gazePerformed && !trace.empty() && traceOutPort.getOutputCount()) {
+        trace.add(getName() + "/command");
+        yarp::os::Bottle &tracebottle = traceOutPort.prepare();
+        tracebottle.clear();
+        tracebottle.addString(trace.toString());
+        traceOutPort.write();
+    }
+
     //send out a debug if needed
     if(debugOutPort.getOutputCount()) {
         yarp::sig::Vector values(6);
@@ -501,6 +514,7 @@ bool vTrackToRobotModule::close()
 
 
     inputPort.close();
+    traceOutPort.close();
     return yarp::os::RFModule::close();
 }
 
@@ -0,0 +1,122 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/// \brief measures the decode/encode throughput (events/s) of AddressEvents
+/// using the per-event codec and the block codecs (scalar and SIMD).
+///
+/// usage: vCodecBench --events <events per packet> --repeats <packets>
+
+#include <yarp/os/all.h>
+#include <iCub/eventdriven/all.h>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+using namespace ev;
+
+static void report(const std::string &name, double dt, unsigned long n)
+{
+    std::cout << std::setw(24) << std::left << name << std::setw(12)
+              << std::right << std::fixed << std::setprecision(1)
+              << n / dt / 1e6 << " Mev/s" << std::endl;
+}
+
+int main(int argc, char * argv[])
+{
+    yarp::os::Property options;
+    options.fromCommand(argc, argv);
+    unsigned int n = options.check("events", yarp::os::Value(5000)).asInt();
+    unsigned int repeats = options.check("repeats", yarp::os::Value(2000)).asInt();
+    unsigned long total = (unsigned long)n * repeats;
+
+    //random events in the coded range of every codec
+    std::vector<AddressEvent> events(n);
+    std::vector<std::int32_t> coded(2 * n);
+    unsigned int pos = 0;
+    for(unsigned int i = 0; i < n; i++) {
+        events[i].stamp = (i * 10) & vtsHelper::max_stamp;
+        events[i].x = rand() % 128;
+        events[i].y = rand() % 128;
+        events[i].polarity = rand() % 2;
+        events[i].channel = rand() % 2;
+        events[i].encode(coded, pos);
+    }
+
+    std::cout << "block codec ISA: " << blockCodecISA() << std::endl;
+    std::cout << n << " events x " << repeats << " packets" << std::endl;
+
+    std::vector<AddressEvent> out(n);
+    std::deque<AddressEvent> outq(events.begin(), events.end());
+    std::vector<std::int32_t> buffer(2 * n);
+    vPacket<AE> packet;
+
+    //per-event codec (the previous implementation)
+    double t0 = yarp::os::Time::now();
+    for(unsigned int r = 0; r < repeats; r++) {
+        int *data = coded.data();
+        for(unsigned int i = 0; i < n; i++)
+            out[i].decode(data);
+    }
+    report("decode per-event", yarp::os::Time::now() - t0, total);
+
+    t0 = yarp::os::Time::now();
+    for(unsigned int r = 0; r < repeats; r++) {
+        pos = 0;
+        for(unsigned int i = 0; i < n; i++)
+            outq[i].encode(buffer, pos);
+    }
+    report("encode per-event", yarp::os::Time::now() - t0, total);
+
+    //block codecs, scalar and then best available ISA
+    for(int scalar = 1; scalar >= 0; scalar--) {
+
+        setBlockCodecScalar(scalar);
+        std::string isa = blockCodecISA();
+
+        t0 = yarp::os::Time::now();
+        for(unsigned int r = 0; r < repeats; r++)
+            decodeEvents(coded.data(), n, out.data());
+        report("decode AE " + isa, yarp::os::Time::now() - t0, total);
+
+        t0 = yarp::os::Time::now();
+        for(unsigned int r = 0; r < repeats; r++) {
+            packet.clear();
+            packet.decode(coded.data(), n);
+        }
+        report("decode vPacket " + isa, yarp::os::Time::now() - t0, total);
+
+        t0 = yarp::os::Time::now();
+        for(unsigned int r = 0; r < repeats; r++) {
+            pos = 0;
+            encodeEvents(outq, buffer, pos);
+        }
+        report("encode AE " + isa, yarp::os::Time::now() - t0, total);
+
+        t0 = yarp::os::Time::now();
+        for(unsigned int r = 0; r < repeats; r++) {
+            pos = 0;
+            packet.encode(buffer, pos);
+        }
+        report("encode vPacket " + isa, yarp::os::Time::now() - t0, total);
+
+        if(buffer != coded)
+            std::cerr << "Warning: block encoding does not match" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/// \brief measures the compression ratio and throughput of the compressed
+/// wire format on a recorded dataset (yarpdatadumper data.log of AE
+/// packets) or, if no file is given, on a synthetic stream.
+///
+/// usage: vCompressBench [--file <data.log>] [--events <synthetic events>]
+
+#include <yarp/os/all.h>
+#include <iCub/eventdriven/all.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+using namespace ev;
+
+/// \brief read the AE packets of a yarpdatadumper log. Each line is
+/// [count] [time] AE (ts addr ts addr ...)
+static bool loadLog(const std::string &filename,
+                    std::vector< std::vector<std::int32_t> > &packets)
+{
+    std::ifstream file(filename.c_str());
+    if(!file.is_open()) {
+        yError() << "Could not open" << filename;
+        return false;
+    }
+
+    std::string line;
+    while(std::getline(file, line)) {
+        size_t start = line.find("AE (");
+        size_t end = line.find(')', start);
+        if(start == std::string::npos || end == std::string::npos)
+            continue;
+
+        std::istringstream iss(line.substr(start + 4, end - start - 4));
+        std::vector<std::int32_t> packet;
+        long long v;
+        while(iss >> v)
+            packet.push_back((std::int32_t)v);
+        if(packet.size() >= 2)
+            packets.push_back(packet);
+    }
+
+    return packets.size();
+}
+
+/// \brief a stream of events moving across an ATIS sized sensor
+static void makeSynthetic(unsigned int n,
+                          std::vector< std::vector<std::int32_t> > &packets)
+{
+    AddressEvent v;
+    unsigned int ts = 0;
+    std::vector<std::int32_t> packet(2 * 5000);
+    unsigned int pos = 0;
+    for(unsigned int i = 0; i < n; i++) {
+        ts += rand() % 20;
+        v.stamp = ts;
+        v.x = (ts / 2000 + rand() % 10) % 304;
+        v.y = rand() % 240;
+        v.polarity = rand() % 2;
+        v.encode(packet, pos);
+        if(pos == packet.size()) {
+            packets.push_back(packet);
+            pos = 0;
+        }
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    yarp::os::Property options;
+    options.fromCommand(argc, argv);
+
+    std::vector< std::vector<std::int32_t> > packets;
+    if(options.check("file")) {
+        if(!loadLog(options.find("file").asString(), packets))
+            return -1;
+    } else {
+        makeSynthetic(options.check("events", yarp::os::Value(5000000)).asInt(),
+                      packets);
+    }
+
+    unsigned long total_ints = 0;
+    for(size_t i = 0; i < packets.size(); i++)
+        total_ints += packets[i].size();
+    std::cout << packets.size() << " packets, " << total_ints / 2
+              << " events" << std::endl;
+
+    std::vector<std::int32_t> compressed, decompressed;
+    for(int lz = 0; lz < 2; lz++) {
+
+        unsigned long total_words = 0;
+        double t_compress = 0, t_decompress = 0;
+        bool correct = true;
+
+        for(size_t i = 0; i < packets.size(); i++) {
+            double t0 = yarp::os::Time::now();
+            unsigned int nwords = compressEvents(packets[i].data(), packets[i].size(),
+                                                 2, lz, compressed);
+            double t1 = yarp::os::Time::now();
+            unsigned int nints = 0;
+            correct &= decompressEvents(compressed.data(), nwords, 2,
+                                        decompressed, nints);
+            double t2 = yarp::os::Time::now();
+
+            correct &= nints == packets[i].size() &&
+                    std::equal(packets[i].begin(), packets[i].end(), decompressed.begin());
+            total_words += nwords;
+            t_compress += t1 - t0;
+            t_decompress += t2 - t1;
+        }
+
+        double mbytes = total_ints * sizeof(std::int32_t) / 1e6;
+        std::cout << (lz ? "delta+pack+lz" : "delta+pack   ")
+                  << std::fixed << std::setprecision(2)
+                  << "  ratio " << total_ints / (double)total_words
+                  << "  bytes/event " << 8.0 * total_words / total_ints
+                  << std::setprecision(1)
+                  << "  compress " << mbytes / t_compress << " MB/s"
+                  << "  decompress " << mbytes / t_decompress << " MB/s"
+                  << (correct ? "" : "  DECOMPRESSION ERROR") << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/// \brief compares the latency and CPU time of a hop between a vWritePort
+/// and a vReadPort through shared memory and through a YARP tcp connection
+/// on the loopback. A writing thread sends packets of AEs at a fixed rate,
+/// stamped with the time they were written, and the reading thread measures
+/// the time each packet is received. A yarpserver is needed for tcp.
+///
+/// usage: vShmBench [--transport shm|tcp|both] [--events <per packet>]
+///                  [--rate <packets/s>] [--seconds <s>]
+
+#include <yarp/os/all.h>
+#include <iCub/eventdriven/all.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <sys/resource.h>
+
+using namespace ev;
+
+/// \brief the user and system time of the process in seconds
+static double cpuTime()
+{
+    struct rusage r;
+    getrusage(RUSAGE_SELF, &r);
+    return r.ru_utime.tv_sec + r.ru_utime.tv_usec * 1e-6 +
+            r.ru_stime.tv_sec + r.ru_stime.tv_usec * 1e-6;
+}
+
+static void runHop(const std::string &transport, unsigned int nevents,
+                   double rate, double seconds)
+{
+    std::string outname = "/vShmBench/" + transport + ":o";
+    std::string inname = "/vShmBench/" + transport + ":i";
+
+    vWritePort<AE> writer;
+    vReadPort<AE> reader;
+    if(!writer.open(outname)) {
+        yError() << "Could not open" << outname;
+        return;
+    }
+    if(transport == "shm") {
+        if(!writer.enableSharedMemory()) {
+            writer.close();
+            return;
+        }
+        reader.connectFrom(outname);
+        if(!reader.open(inname) || !reader.isSharedMemory()) {
+            yError() << "Could not read" << outname << "from shared memory";
+            reader.close();
+            writer.close();
+            return;
+        }
+    } else {
+        if(!reader.open(inname) ||
+                !yarp::os::Network::connect(outname, inname, "tcp")) {
+            yError() << "Could not connect" << outname << "to" << inname;
+            reader.close();
+            writer.close();
+            return;
+        }
+    }
+    yarp::os::Time::delay(0.5);
+
+    std::deque<AE> packet;
+    for(unsigned int i = 0; i < nevents; i++) {
+        AE v;
+        v.stamp = i * 10;
+        v.x = rand() % 304;
+        v.y = rand() % 240;
+        v.polarity = rand() % 2;
+        packet.push_back(v);
+    }
+
+    unsigned int npackets = rate * seconds;
+    std::vector<double> latency;
+    latency.reserve(npackets);
+
+    double cpu0 = cpuTime();
+    double t0 = yarp::os::Time::now();
+
+    std::atomic<bool> done(false);
+    std::thread sender([&] {
+        auto next = std::chrono::steady_clock::now();
+        auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>
+                (std::chrono::duration<double>(1.0 / rate));
+        for(unsigned int i = 0; i < npackets; i++) {
+            std::this_thread::sleep_until(next);
+            next += period;
+            writer.write(packet, yarp::os::Stamp(i, yarp::os::Time::now()));
+        }
+        //wake the reader if packets were lost
+        auto until = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while(!done && std::chrono::steady_clock::now() < until)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if(!done) reader.releaseDataLock();
+    });
+
+    yarp::os::Stamp stamp;
+    while(latency.size() < npackets) {
+        const std::vector<AE> *q = reader.read(stamp);
+        if(!q) break;
+        latency.push_back(yarp::os::Time::now() - stamp.getTime());
+    }
+    done = true;
+
+    sender.join();
+    double cpu = cpuTime() - cpu0;
+    double wall = yarp::os::Time::now() - t0;
+
+    reader.close();
+    writer.close();
+
+    if(latency.empty()) {
+        std::cout << std::setw(6) << transport << ": no packets received"
+                  << std::endl;
+        return;
+    }
+
+    std::sort(latency.begin(), latency.end());
+    double mean = 0;
+    for(size_t i = 0; i < latency.size(); i++)
+        mean += latency[i];
+    mean /= latency.size();
+
+    std::cout << std::setw(6) << transport << std::fixed << std::setprecision(1)
+              << std::setw(10) << mean * 1e6
+              << std::setw(10) << latency[latency.size() / 2] * 1e6
+              << std::setw(10) << latency[latency.size() * 99 / 100] * 1e6
+              << std::setw(10) << latency.back() * 1e6
+              << std::setw(10) << 100.0 * cpu / wall
+              << std::setw(10) << latency.size() << "/" << npackets
+              << std::endl;
+}
+
+int main(int argc, char * argv[])
+{
+    yarp::os::Property options;
+    options.fromCommand(argc, argv);
+
+    std::string transport = options.check("transport",
+                                          yarp::os::Value("both")).asString();
+    unsigned int nevents = options.check("events", yarp::os::Value(500)).asInt();
+    double rate = options.check("rate", yarp::os::Value(1000)).asDouble();
+    double seconds = options.check("seconds", yarp::os::Value(5)).asDouble();
+
+    yarp::os::Network yarp;
+    if(transport != "shm" && !yarp.checkNetwork()) {
+        yWarning() << "No yarpserver: measuring shared memory only";
+        transport = "shm";
+    }
+
+    std::cout << nevents << " events per packet, " << rate << " packets/s for "
+              << seconds << " s" << std::endl;
+    std::cout << std::setw(6) << " " << std::setw(10) << "mean(us)"
+              << std::setw(10) << "50%(us)" << std::setw(10) << "99%(us)"
+              << std::setw(10) << "max(us)" << std::setw(10) << "cpu(%)"
+              << std::setw(10) << "received" << std::endl;
+
+    if(transport == "shm" || transport == "both")
+        runHop("shm", nevents, rate, seconds);
+    if(transport == "tcp" || transport == "both")
+        runHop("tcp", nevents, rate, seconds);
+
+    return 0;
+}
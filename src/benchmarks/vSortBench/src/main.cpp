@@ -0,0 +1,194 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/// \brief compares the methods of ev::qsort on queues of events collected
+/// from a recorded dataset (yarpdatadumper data.log of AE packets, e.g. a
+/// stereo recording with interleaved left and right packets) or, if no file
+/// is given, on a synthetic stereo stream that wraps. Each queue holds
+/// --packets consecutive packets, as a module accumulating a window would.
+///
+/// usage: vSortBench [--file <data.log>] [--events <synthetic events>]
+///                   [--packets <n>] [--shuffle]
+
+#include <yarp/os/all.h>
+#include <iCub/eventdriven/all.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+using namespace ev;
+
+/// \brief read the AE packets of a yarpdatadumper log. Each line is
+/// [count] [time] AE (ts addr ts addr ...)
+static bool loadLog(const std::string &filename, std::vector<vQueue> &packets)
+{
+    std::ifstream file(filename.c_str());
+    if(!file.is_open()) {
+        yError() << "Could not open" << filename;
+        return false;
+    }
+
+    std::string line;
+    std::vector<int> data;
+    while(std::getline(file, line)) {
+        size_t start = line.find("AE (");
+        size_t end = line.find(')', start);
+        if(start == std::string::npos || end == std::string::npos)
+            continue;
+
+        std::istringstream iss(line.substr(start + 4, end - start - 4));
+        data.clear();
+        long long v;
+        while(iss >> v)
+            data.push_back((int)v);
+
+        vQueue packet;
+        for(size_t i = 0; i + 1 < data.size(); i += 2) {
+            event<AE> e = make_event<AE>();
+            int *d = data.data() + i;
+            e->decode(d);
+            packet.push_back(e);
+        }
+        if(packet.size())
+            packets.push_back(packet);
+    }
+
+    return packets.size();
+}
+
+/// \brief a stereo stream in which each camera sends packets that are in
+/// order but overlap in time with the packets of the other camera. The
+/// timestamps wrap part way through.
+static void makeSynthetic(unsigned int n, std::vector<vQueue> &packets)
+{
+    unsigned int ts[2];
+    ts[VLEFT] = vtsHelper::max_stamp - 10 * (n / 2);
+    ts[VRIGHT] = ts[VLEFT] + 500;
+
+    unsigned int count = 0;
+    while(count < n) {
+        for(int c = VLEFT; c <= VRIGHT; c++) {
+            vQueue packet;
+            unsigned int size = 200 + rand() % 400;
+            for(unsigned int i = 0; i < size; i++) {
+                event<AE> e = make_event<AE>();
+                ts[c] += rand() % 40;
+                e->stamp = ts[c] & vtsHelper::max_stamp;
+                e->x = rand() % 304;
+                e->y = rand() % 240;
+                e->channel = c;
+                packet.push_back(e);
+            }
+            count += size;
+            packets.push_back(packet);
+        }
+    }
+}
+
+static bool sameOrder(const vQueue &a, const vQueue &b)
+{
+    if(a.size() != b.size()) return false;
+    for(size_t i = 0; i < a.size(); i++)
+        if(a[i] != b[i]) return false;
+    return true;
+}
+
+static bool isSorted(const vQueue &q, bool respectWraps)
+{
+    for(size_t i = 1; i < q.size(); i++) {
+        if(respectWraps) {
+            std::int64_t dt = vtsHelper::elapsed(q[i]->stamp, q[i-1]->stamp);
+            if(dt < 0 || dt > vtsHelper::max_stamp / 2)
+                return false;
+        } else if(q[i]->stamp < q[i-1]->stamp) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char * argv[])
+{
+    yarp::os::Property options;
+    options.fromCommand(argc, argv);
+
+    std::vector<vQueue> packets;
+    if(options.check("file")) {
+        if(!loadLog(options.find("file").asString(), packets))
+            return -1;
+    } else {
+        makeSynthetic(options.check("events", yarp::os::Value(2000000)).asInt(),
+                      packets);
+    }
+    unsigned int window = options.check("packets", yarp::os::Value(16)).asInt();
+    bool shuffle = options.check("shuffle");
+
+    //the queues to sort
+    std::vector<vQueue> queues;
+    unsigned int nevents = 0;
+    for(size_t i = 0; i < packets.size(); i += window) {
+        vQueue q;
+        for(size_t j = i; j < i + window && j < packets.size(); j++)
+            q.insert(q.end(), packets[j].begin(), packets[j].end());
+        if(shuffle)
+            std::random_shuffle(q.begin(), q.end());
+        nevents += q.size();
+        queues.push_back(q);
+    }
+
+    std::cout << nevents << " events in " << queues.size() << " queues of "
+              << window << " packets" << std::endl;
+
+    const char *names[] = {"auto", "std::sort", "merge", "radix"};
+    for(int wraps = 0; wraps < 2; wraps++) {
+
+        std::vector<vQueue> reference = queues;
+        for(size_t i = 0; i < reference.size(); i++)
+            std::stable_sort(reference[i].begin(), reference[i].end(),
+                             wraps ? temporalSortWrap : temporalSortStraight);
+
+        std::cout << (wraps ? "respecting wraps" : "not respecting wraps")
+                  << std::endl;
+        for(int m = SORT_AUTO; m <= SORT_RADIX; m++) {
+
+            std::vector<vQueue> sorted = queues;
+            double t0 = yarp::os::Time::now();
+            for(size_t i = 0; i < sorted.size(); i++)
+                qsort(sorted[i], wraps, (sortMethod)m);
+            double dt = yarp::os::Time::now() - t0;
+
+            bool ok = true;
+            for(size_t i = 0; i < sorted.size(); i++) {
+                if(m == SORT_STD)
+                    ok = ok && isSorted(sorted[i], wraps);
+                else
+                    ok = ok && sameOrder(sorted[i], reference[i]);
+            }
+
+            std::cout << std::setw(24) << std::left << names[m] << std::right
+                      << std::fixed << std::setprecision(2)
+                      << std::setw(10) << 1e9 * dt / nevents << " ns/event";
+            if(!ok) std::cout << "  ERROR: incorrect order";
+            std::cout << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/// \brief compares the surfaces on the queries of vFlow (a 3x3 grid of
+/// planes of --filterSize 3 to 7 around each event) and vHarrisCallback (the
+/// --qsize most recent events within a window of radius 3 to 7): the
+/// temporalSurface, and a flatSurface with its pixels in rows or in tiles.
+/// The stream is a bar sweeping across the sensor with background noise.
+///
+/// usage: vSurfaceBench [--events <n>] [--width <w>] [--height <h>]
+///                      [--tempsize <s>] [--qsize <n>]
+
+#include <yarp/os/all.h>
+#include <iCub/eventdriven/all.h>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+using namespace ev;
+
+static std::vector<AE> makeStream(unsigned int n, int width, int height)
+{
+    std::vector<AE> events(n);
+    stamp_t ts = 0;
+    for(unsigned int i = 0; i < n; i++) {
+        AE &v = events[i];
+        ts += 1 + rand() % 20;
+        v.stamp = ts & vtsHelper::max_stamp;
+        v.polarity = rand() % 2;
+        if(rand() % 10) {
+            //the bar moves 1 pixel every 1000 events and wraps around
+            int x = (i / 1000 + rand() % 4) % width;
+            v.x = x;
+            v.y = rand() % height;
+        } else {
+            v.x = rand() % width;
+            v.y = rand() % height;
+        }
+    }
+    return events;
+}
+
+static void report(const std::string &name, double seconds, double n,
+                   unsigned int found)
+{
+    std::cout << std::setw(24) << std::left << name << std::right
+              << std::fixed << std::setprecision(2)
+              << std::setw(10) << 1e9 * seconds / n << " ns/event"
+              << std::setw(10) << found / n << " events/query" << std::endl;
+}
+
+/// \brief the vFlow pattern: add each event, then query the surfaces
+/// centred on a 3x3 grid around it, each of radius fRad
+template <typename A, typename Q> static double flowPattern(
+        const std::vector<AE> &events, int fRad, A add, Q query)
+{
+    double t0 = yarp::os::Time::now();
+    for(size_t i = 0; i < events.size(); i++) {
+        const AE &v = events[i];
+        add(i);
+        for(int x = v.x - fRad; x <= v.x + fRad; x += fRad)
+            for(int y = v.y - fRad; y <= v.y + fRad; y += fRad)
+                query(x, y);
+    }
+    return yarp::os::Time::now() - t0;
+}
+
+int main(int argc, char * argv[])
+{
+    yarp::os::Property options;
+    options.fromCommand(argc, argv);
+
+    unsigned int nevents = options.check("events", yarp::os::Value(500000)).asInt();
+    int width = options.check("width", yarp::os::Value(304)).asInt();
+    int height = options.check("height", yarp::os::Value(240)).asInt();
+    int tempsize = options.check("tempsize", yarp::os::Value(0.1)).asDouble() *
+            vtsHelper::vtsscaler;
+    int qsize = options.check("qsize", yarp::os::Value(36)).asInt();
+
+    std::vector<AE> events = makeStream(nevents, width, height);
+    std::vector< event<AE> > shared(nevents);
+    for(unsigned int i = 0; i < nevents; i++) {
+        shared[i] = make_event<AE>();
+        *shared[i] = events[i];
+    }
+
+    const char *layouts[] = {"rows", "tiled"};
+    unsigned int found;
+
+    std::cout << "vFlow: 3x3 grid of getSurf(x, y, filterSize / 2)" << std::endl;
+    for(int filterSize = 3; filterSize <= 7; filterSize += 2) {
+        int fRad = filterSize / 2;
+
+        temporalSurface surface(width, height, tempsize);
+        found = 0;
+        double dt = flowPattern(events, fRad, [&](size_t i) {
+            surface.fastAddEvent(shared[i]);
+        }, [&](int x, int y) {
+            found += surface.getSurf(x, y, fRad).size();
+        });
+        report("temporalSurface " + std::to_string(filterSize), dt,
+               nevents, found / 9);
+
+        for(int l = SURFACE_ROWS; l <= SURFACE_TILED; l++) {
+            flatSurface flat(width, height, SURFACE_TEMPORAL, tempsize,
+                             (surfaceLayout)l);
+            found = 0;
+            dt = flowPattern(events, fRad, [&](size_t i) {
+                flat.addEvent(events[i]);
+            }, [&](int x, int y) {
+                found += flat.getSurf(x, y, fRad).size();
+            });
+            report(std::string("flatSurface ") + layouts[l] + " " +
+                   std::to_string(filterSize), dt, nevents, found / 9);
+        }
+    }
+
+    std::cout << "vHarrisCallback: getSurf_Clim(" << qsize
+              << ", x, y, windowRad)" << std::endl;
+    for(int windowRad = 3; windowRad <= 7; windowRad += 2) {
+
+        temporalSurface surface(width, height, tempsize);
+        found = 0;
+        double t0 = yarp::os::Time::now();
+        for(unsigned int i = 0; i < nevents; i++) {
+            surface.fastAddEvent(shared[i]);
+            found += surface.getSurf_Clim(qsize, shared[i]->x, shared[i]->y,
+                                          windowRad).size();
+        }
+        report("temporalSurface " + std::to_string(windowRad),
+               yarp::os::Time::now() - t0, nevents, found);
+
+        for(int l = SURFACE_ROWS; l <= SURFACE_TILED; l++) {
+            flatSurface flat(width, height, SURFACE_TEMPORAL, tempsize,
+                             (surfaceLayout)l);
+            found = 0;
+            t0 = yarp::os::Time::now();
+            for(unsigned int i = 0; i < nevents; i++) {
+                flat.addEvent(events[i]);
+                found += flat.getSurf_Clim(qsize, events[i].x, events[i].y,
+                                           windowRad).size();
+            }
+            report(std::string("flatSurface ") + layouts[l] + " " +
+                   std::to_string(windowRad), yarp::os::Time::now() - t0,
+                   nevents, found);
+        }
+    }
+
+    return 0;
+}
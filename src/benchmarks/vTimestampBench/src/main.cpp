@@ -0,0 +1,184 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/// \brief compares the wrap-aware timestamp arithmetic with the unwrapped
+/// 64 bit timestamps of VLIB_TIMESTAMP_64. The age kernels are run on a
+/// stream of stamps that wraps part way through. The surface queries use the
+/// timestamp mode the library was built with: run the benchmark from a build
+/// with and without VLIB_TIMESTAMP_64 to compare them.
+///
+/// usage: vTimestampBench [--events <n>] [--window <us>] [--repeats <n>]
+
+#include <yarp/os/all.h>
+#include <iCub/eventdriven/all.h>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+using namespace ev;
+
+/// \brief the number of events younger than window, with the branch used
+/// before VLIB_TIMESTAMP_64
+static unsigned int countBranch(const std::vector<unsigned int> &ts,
+                                unsigned int now, int window)
+{
+    unsigned int n = 0;
+    for(size_t i = 0; i < ts.size(); i++) {
+        int dt = now - ts[i];
+        if(dt < 0) dt += vtsHelper::max_stamp;
+        n += dt < window;
+    }
+    return n;
+}
+
+/// \brief the number of events younger than window, wrap corrected without
+/// a branch (as vtsHelper::elapsed without VLIB_TIMESTAMP_64)
+static unsigned int countWrapped(const std::vector<unsigned int> &ts,
+                                 unsigned int now, int window)
+{
+    const int maxts = vtsHelper::max_stamp;
+    unsigned int n = 0;
+    for(size_t i = 0; i < ts.size(); i++) {
+        int dt = now - ts[i];
+        dt += (dt >> 31) & maxts;
+        n += dt < window;
+    }
+    return n;
+}
+
+/// \brief the number of events younger than window, with unwrapped stamps
+/// (as vtsHelper::elapsed with VLIB_TIMESTAMP_64)
+static unsigned int countUnwrapped(const std::vector<std::uint64_t> &ts,
+                                   std::uint64_t now, int window)
+{
+    unsigned int n = 0;
+    for(size_t i = 0; i < ts.size(); i++)
+        n += now - ts[i] < (std::uint64_t)window;
+    return n;
+}
+
+static void report(const std::string &name, double seconds, double n)
+{
+    std::cout << std::setw(24) << std::left << name << std::right
+              << std::fixed << std::setprecision(2)
+              << std::setw(10) << 1e9 * seconds / n << " ns/event" << std::endl;
+}
+
+int main(int argc, char * argv[])
+{
+    yarp::os::Property options;
+    options.fromCommand(argc, argv);
+
+    unsigned int nevents = options.check("events", yarp::os::Value(1000000)).asInt();
+    int window = options.check("window", yarp::os::Value(10000)).asInt() *
+            1e-6 * vtsHelper::vtsscaler;
+    int repeats = options.check("repeats", yarp::os::Value(50)).asInt();
+
+#ifdef VLIB_TIMESTAMP_64
+    std::cout << "library timestamps: 64 bit unwrapped" << std::endl;
+#else
+    std::cout << "library timestamps: " << vtsHelper::max_stamp
+              << " wrap-aware" << std::endl;
+#endif
+
+    //a stream that wraps half way through
+    std::vector<unsigned int> wrapped(nevents);
+    std::vector<std::uint64_t> unwrapped(nevents);
+    unsigned int ts = vtsHelper::max_stamp - 10 * (nevents / 2);
+    for(unsigned int i = 0; i < nevents; i++) {
+        ts += rand() % 20;
+        wrapped[i] = ts & vtsHelper::max_stamp;
+    }
+
+    //unwrapping at ingest
+    double t0 = yarp::os::Time::now();
+    for(int r = 0; r < repeats; r++) {
+        vtsHelper unwrapper;
+        for(unsigned int i = 0; i < nevents; i++)
+            unwrapped[i] = unwrapper.unwrap(wrapped[i]);
+    }
+    report("unwrap at ingest", yarp::os::Time::now() - t0,
+           (double)repeats * nevents);
+
+    //age of every event relative to query times spread over the stream
+    unsigned int nb = 0, nw = 0, nu = 0;
+    t0 = yarp::os::Time::now();
+    for(int r = 0; r < repeats; r++)
+        nb += countBranch(wrapped, wrapped[(r + 1) * (nevents - 1) / repeats], window);
+    double t1 = yarp::os::Time::now();
+    for(int r = 0; r < repeats; r++)
+        nw += countWrapped(wrapped, wrapped[(r + 1) * (nevents - 1) / repeats], window);
+    double t2 = yarp::os::Time::now();
+    for(int r = 0; r < repeats; r++)
+        nu += countUnwrapped(unwrapped, unwrapped[(r + 1) * (nevents - 1) / repeats], window);
+    double t3 = yarp::os::Time::now();
+
+    report("age (wrap branch)", t1 - t0, (double)repeats * nevents);
+    report("age (wrap branch-free)", t2 - t1, (double)repeats * nevents);
+    report("age (64 bit)", t3 - t2, (double)repeats * nevents);
+    if(nb != nw || nb != nu)
+        std::cout << "ERROR: the counts of the kernels differ" << std::endl;
+
+    //the surfaces of the library in the mode it was built with
+    temporalSurface surface(304, 240, 0.1 * vtsHelper::vtsscaler);
+    historicalSurface hsurface;
+    hsurface.initialise(240, 304);
+    std::vector< event<AE> > events(nevents);
+    for(unsigned int i = 0; i < nevents; i++) {
+        events[i] = make_event<AE>();
+#ifdef VLIB_TIMESTAMP_64
+        events[i]->stamp = unwrapped[i];
+#else
+        events[i]->stamp = wrapped[i];
+#endif
+        events[i]->x = rand() % 304;
+        events[i]->y = rand() % 240;
+    }
+
+    double tadd = 0, tquery = 0, thist = 0, tdelayed = 0;
+    unsigned int nq = 0, nqueries = 0;
+    for(unsigned int i = 0; i < nevents; i++) {
+        t0 = yarp::os::Time::now();
+        surface.fastAddEvent(events[i]);
+        hsurface.addEvent(events[i]);
+        t1 = yarp::os::Time::now();
+        tadd += t1 - t0;
+        if(i % 1000) continue;
+        nq += surface.getSurf_Tlim(window, 10).size();
+        t2 = yarp::os::Time::now();
+        nq += hsurface.getSurface(0, window, 10).size();
+        t3 = yarp::os::Time::now();
+        //as the particle filter compensating a delay of one window
+        hsurface.getSurface(window, window, 10);
+        tquery += t2 - t1;
+        thist += t3 - t2;
+        tdelayed += yarp::os::Time::now() - t3;
+        nqueries++;
+    }
+
+    report("surface add", tadd, nevents);
+    std::cout << std::setw(24) << std::left << "getSurf_Tlim" << std::right
+              << std::setw(10) << 1e6 * tquery / nqueries << " us/query" << std::endl;
+    std::cout << std::setw(24) << std::left << "historical getSurface" << std::right
+              << std::setw(10) << 1e6 * thist / nqueries << " us/query" << std::endl;
+    std::cout << std::setw(24) << std::left << "historical delayed" << std::right
+              << std::setw(10) << 1e6 * tdelayed / nqueries << " us/query" << std::endl;
+    std::cout << nq / (2 * nqueries) << " events per query" << std::endl;
+
+    return 0;
+}
@@ -83,7 +83,11 @@ private:
     //parameters
     unsigned int packet_size;
     bool direct_read;
+    bool compress;
+    bool compress_lz;
     Stamp yarp_stamp;
+    unsigned int trace_every;
+    unsigned int trace_count;
 
     int countAEs;
     int countLoss;
@@ -91,6 +95,8 @@ private:
     int prevAEs;
     double prevTS;
 
+    void writePacket(vGenPortInterface &storage, double read_time);
+
 public:
 
     device2yarp();
@@ -98,6 +104,8 @@ public:
               bool direct_read, unsigned int packet_size,
               unsigned int internal_storage_size);
     void setDirectRead(bool value = true);
+    void setCompression(bool compress, bool lz = false);
+    void setTrace(unsigned int every);
 
     void run();
     void onStop();
@@ -155,6 +163,8 @@ public:
                       unsigned int packet_size,
                       unsigned int maximum_internal_memory);
     bool openWritePort(string module_name);
+    void setCompression(bool compress, bool lz = false);
+    void setTrace(unsigned int every);
     void start();
     void stop();
 
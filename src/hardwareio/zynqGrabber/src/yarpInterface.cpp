@@ -144,6 +144,10 @@ device2yarp::device2yarp()
     prevAEs = 0;
     device_reader = 0;
     direct_read = false;
+    compress = false;
+    compress_lz = false;
+    trace_every = 0;
+    trace_count = 0;
 }
 
 bool device2yarp::open(string module_name, int fd, unsigned int read_size,
@@ -161,6 +165,37 @@ bool device2yarp::open(string module_name, int fd, unsigned int read_size,
     return output_port.open(module_name + "/AE:o");
 }
 
+void device2yarp::setCompression(bool compress, bool lz)
+{
+    this->compress = compress;
+    this->compress_lz = lz;
+}
+
+void device2yarp::setTrace(unsigned int every)
+{
+    trace_every = every;
+}
+
+void device2yarp::writePacket(vGenPortInterface &storage, double read_time)
+{
+    yarp_stamp.update();
+    output_port.setEnvelope(yarp_stamp);
+
+    //trace every trace_every packets from the time the data was read
+    if(trace_every && ++trace_count >= trace_every) {
+        trace_count = 0;
+        vTrace trace;
+        trace.add(output_port.getName() + "/device", read_time);
+        trace.add(output_port.getName());
+        storage.setTrace(trace);
+        output_port.write(storage);
+        storage.clearTrace();
+        return;
+    }
+
+    output_port.write(storage);
+}
+
 void device2yarp::afterStart(bool success)
 {
     if(success && !direct_read)
@@ -171,6 +206,7 @@ void  device2yarp::run() {
 
     vGenPortInterface external_storage;
     external_storage.setHeader(AE::tag);
+    external_storage.setCompression(compress, compress_lz);
     yInfo() << "packet size: " << packet_size;
 
     while(!isStopping()) {
@@ -199,15 +235,14 @@ void  device2yarp::run() {
         countAEs += nBytesRead / 8;
         countLoss += nBytesLost / 8;
         if (!output_port.getOutputCount() || nBytesRead <= 8) continue;
+        double read_time = trace_every ? yarp::os::Time::now() : 0;
 
         unsigned int i = 0;
         while((i+1) * packet_size < nBytesRead) {
 
             external_storage.setExternalData((const char *)data.data() +
                                              i * packet_size, packet_size);
-            yarp_stamp.update();
-            output_port.setEnvelope(yarp_stamp);
-            output_port.write(external_storage);
+            writePacket(external_storage, read_time);
 
             i++;
         }
@@ -215,9 +250,7 @@ void  device2yarp::run() {
         external_storage.setExternalData((const char *)data.data() +
                                          i * packet_size,
                                          nBytesRead - i * packet_size);
-        yarp_stamp.update();
-        output_port.setEnvelope(yarp_stamp);
-        output_port.write(external_storage);
+        writePacket(external_storage, read_time);
     }
 
 }
@@ -488,6 +521,16 @@ bool hpuInterface::openReadPort(string module_name, bool direct_read,
     return true;
 }
 
+void hpuInterface::setCompression(bool compress, bool lz)
+{
+    D2Y.setCompression(compress, lz);
+}
+
+void hpuInterface::setTrace(unsigned int every)
+{
+    D2Y.setTrace(every);
+}
+
 bool hpuInterface::openWritePort(string module_name)
 {
     if(fd < 0 || !Y2D.open(module_name, fd))
@@ -199,6 +199,13 @@ bool zynqGrabberModule::configure(yarp::os::ResourceFinder &rf) {
         int buffer_size  = 8 * rf.check("buffer_size", yarp::os::Value("5120000")).asInt();
         bool direct_read = rf.check("direct_read") &&
                 rf.check("direct_read", yarp::os::Value(true)).asBool();
+        bool compress = rf.check("compress") &&
+                rf.check("compress", yarp::os::Value(true)).asBool();
+        bool compress_lz = rf.check("compress_lz") &&
+                rf.check("compress_lz", yarp::os::Value(true)).asBool();
+
+        hpu.setCompression(compress || compress_lz, compress_lz);
+        hpu.setTrace(rf.check("trace", yarp::os::Value(0)).asInt());
 
         if(read_flag)
             if(!hpu.openReadPort(moduleName, direct_read, packet_size,
@@ -64,6 +64,7 @@ public:
     int factorial(int a);
     int Pasc(int k, int n);
     void applysobel(ev::event<ev::AE> evt);
+    void applysobel(int x, int y);
     void applygaussian();
     double getScore();
     void reset();
@@ -40,13 +40,12 @@ private:
 
     bool strictness;
 
-    //output port for the vBottle with the new events computed by the module
-    yarp::os::BufferedPort<ev::vBottle> outPort;
+    //output port for the corner events computed by the module
+    ev::vWritePort<ev::LabelledAE> outPort;
     yarp::os::BufferedPort<yarp::os::Bottle> debugPort;
 
     //data structures
-    ev::temporalSurface *surfaceleft;
-    ev::temporalSurface *surfaceright;
+    ev::surfaceBank<ev::flatSurface> *surfaces; //per channel
 
     //parameters
     int height;
@@ -56,15 +55,14 @@ private:
     int windowRad;
     double thresh;
 
-    double tout;
-
     filters convolution;
-    bool detectcorner(const ev::vQueue subsurf, int x, int y);
+    bool detectcorner(const ev::surfaceSpan &subsurf, int x, int y);
 
 public:
 
     vHarrisCallback(int height, int width, double temporalsize, int qlen,
-                    int filterSize, int windowRad, double sigma, double thresh);
+                    int filterSize, int windowRad, double sigma, double thresh,
+                    int channels = 2);
 
     bool    open(const std::string moduleName, bool strictness = false);
     void    close();
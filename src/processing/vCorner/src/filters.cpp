@@ -65,13 +65,18 @@ void filters::reset() {
 }
 
 void filters::applysobel(ev::event<AE> evt)
+{
+    applysobel(evt->x, evt->y);
+}
+
+void filters::applysobel(int x, int y)
 {
 
     //apply sobel filters
-    int lx = std::max(evt->x-sobelrad, rx-lrad);
-    int ux = std::min(evt->x+sobelrad, rx+lrad);
-    int ly = std::max(evt->y-sobelrad, ry-lrad);
-    int uy = std::min(evt->y+sobelrad, ry+lrad);
+    int lx = std::max(x-sobelrad, rx-lrad);
+    int ux = std::min(x+sobelrad, rx+lrad);
+    int ly = std::max(y-sobelrad, ry-lrad);
+    int uy = std::min(y+sobelrad, ry+lrad);
     for(int cx = lx; cx <= ux; cx++)
     {
         for(int cy = ly; cy <= uy; cy++)
@@ -79,8 +84,8 @@ void filters::applysobel(ev::event<AE> evt)
             //(cx,cy) is the pixel where we apply the sobel filter
             this->setFilterCenter(cx, cy);
 
-            int diffx = evt->x - cx;
-            int diffy = evt->y - cy;
+            int diffx = x - cx;
+            int diffy = y - cy;
 
             double gainx = sobelx(diffx + sobelrad, diffy + sobelrad);
             double gainy = sobely(diffx + sobelrad, diffy + sobelrad);
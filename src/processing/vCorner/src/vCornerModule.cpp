@@ -43,11 +43,12 @@ bool vCornerModule::configure(yarp::os::ResourceFinder &rf)
     bool callback = rf.check("callback", yarp::os::Value(false)).asBool();
     int nthreads = rf.check("nthreads", yarp::os::Value(2)).asInt();
     double gain = rf.check("gain", yarp::os::Value(0.1)).asDouble();
+    int channels = rf.check("channels", yarp::os::Value(2)).asInt();
 
     /* create the thread and pass pointers to the module parameters */
     if(callback) {
         harristhread = 0;
-        harriscallback = new vHarrisCallback(height, width, temporalsize, qlen, sobelsize, windowRad, sigma, thresh);
+        harriscallback = new vHarrisCallback(height, width, temporalsize, qlen, sobelsize, windowRad, sigma, thresh, channels);
         return harriscallback->open(moduleName, strict);
     }
     else {
@@ -21,7 +21,8 @@
 using namespace ev;
 
 vHarrisCallback::vHarrisCallback(int height, int width, double temporalsize, int qlen,
-                                 int sobelsize, int windowRad, double sigma, double thresh)
+                                 int sobelsize, int windowRad, double sigma, double thresh,
+                                 int channels)
 {
     std::cout << "Using HARRIS implementation..." << std::endl;
 
@@ -51,10 +52,9 @@ vHarrisCallback::vHarrisCallback(int height, int width, double temporalsize, int
 
     //create surface representations
     std::cout << "Creating surfaces..." << std::endl;
-    surfaceleft = new temporalSurface(width, height, this->temporalsize);
-    surfaceright = new temporalSurface(width, height, this->temporalsize);
-
-    this->tout = 0;
+    surfaces = new surfaceBank<flatSurface>(channels, false, width, height,
+                                            SURFACE_TEMPORAL,
+                                            this->temporalsize);
 
 }
 /**********************************************************/
@@ -70,9 +70,11 @@ bool vHarrisCallback::open(const std::string moduleName, bool strictness)
     std::string inPortName = "/" + moduleName + "/vBottle:i";
     bool check1 = BufferedPort<ev::vBottle>::open(inPortName);
 
-    if(strictness) outPort.setStrict();
+    //corners are sent together at most 1 ms after they are detected. The
+    //port waits for each send, so strictness is needed only on input
     std::string outPortName = "/" + moduleName + "/vBottle:o";
     bool check2 = outPort.open(outPortName);
+    outPort.setCoalescing(1000);
 
     std::string debugPortName = "/" + moduleName + "/debug:o";
     bool check3 = debugPort.open(debugPortName);
@@ -89,8 +91,7 @@ void vHarrisCallback::close()
     outPort.close();
     yarp::os::BufferedPort<ev::vBottle>::close();
 
-    delete surfaceleft;
-    delete surfaceright;
+    delete surfaces;
 
 }
 
@@ -99,7 +100,6 @@ void vHarrisCallback::interrupt()
 {
     //pass on the interrupt call to everything needed
     debugPort.interrupt();
-    outPort.interrupt();
     yarp::os::BufferedPort<ev::vBottle>::interrupt();
 
 }
@@ -107,7 +107,7 @@ void vHarrisCallback::interrupt()
 /**********************************************************/
 void vHarrisCallback::onRead(ev::vBottle &bot)
 {
-    ev::vBottle fillerbottle;
+    std::deque<LabelledAE> corners;
     bool isc = false;
 
     /*get the event queue in the vBottle bot*/
@@ -115,22 +115,18 @@ void vHarrisCallback::onRead(ev::vBottle &bot)
     for(ev::vQueue::iterator qi = q.begin(); qi != q.end(); qi++)
     {
         auto ae = is_event<AE>(*qi);
-        ev::temporalSurface *cSurf;
-        if(ae->getChannel() == 0)
-            cSurf = surfaceleft;
-        else
-            cSurf = surfaceright;
-        cSurf->fastAddEvent(*qi);
-
-        vQueue subsurf;
-        subsurf = cSurf->getSurf_Clim(qlen, ae->x, ae->y, windowRad);
+        ev::flatSurface *cSurf = surfaces->addEvent(*ae);
+        if(!cSurf) continue;
+
+        const surfaceSpan subsurf =
+                cSurf->getSurf_Clim(qlen, ae->x, ae->y, windowRad);
         isc = detectcorner(subsurf, ae->x, ae->y);
 
         //if it's a corner, add it to the output bottle
         if(isc) {
-            auto ce = make_event<LabelledAE>(ae);
-            ce->ID = 1;
-            fillerbottle.addEvent(ce);
+            LabelledAE ce(*ae);
+            ce.ID = 1;
+            corners.push_back(ce);
         }
 
         if(debugPort.getOutputCount()) {
@@ -142,22 +138,16 @@ void vHarrisCallback::onRead(ev::vBottle &bot)
 
     }
 
-    if( (yarp::os::Time::now() - tout) > 0.001 && fillerbottle.size() ) {
+    if(corners.size()) {
         yarp::os::Stamp st;
         this->getEnvelope(st);
-        outPort.setEnvelope(st);
-        ev::vBottle &eventsout = outPort.prepare();
-        eventsout.clear();
-        eventsout = fillerbottle;
-        outPort.write(strictness);
-        fillerbottle.clear();
-        tout = yarp::os::Time::now();
+        outPort.write(corners, st);
     }
 
 }
 
 /**********************************************************/
-bool vHarrisCallback::detectcorner(const vQueue subsurf, int x, int y)
+bool vHarrisCallback::detectcorner(const surfaceSpan &subsurf, int x, int y)
 {
 
     //set the final response to be centred on the curren event
@@ -167,8 +157,7 @@ bool vHarrisCallback::detectcorner(const vQueue subsurf, int x, int y)
     for(unsigned int i = 0; i < subsurf.size(); i++)
     {
         //events are in the surface
-        auto vi = is_event<AE>(subsurf[i]);
-        convolution.applysobel(vi);
+        convolution.applysobel(subsurf[i].x, subsurf[i].y);
 
     }
     convolution.applygaussian();
@@ -108,8 +108,10 @@ void vHarrisThread::onStop()
 
 void vHarrisThread::run()
 {
-    int maxV = 10000;
-    //int minAcceptableDelay =  51200;
+    //when behind, process only the latest events waiting
+    inputPort.setDropPolicy(ev::KEEP_LATEST_N, 10000);
+    unsigned int discarded = 0;
+
     while(!isStopping()) {
 
         ev::vQueue *q = 0;
@@ -118,34 +120,12 @@ void vHarrisThread::run()
         }
         if(isStopping()) break;
 
-        //skip events based on delay in the queue
         unsigned int delay_n = inputPort.queryDelayN();
-//        double increment = gain * (delay_n - q->size()) / minAcceptableDelay;
-        double increment = ((double)delay_n)/maxV;
-        if(increment < 1.0)
-            increment = 1;
-
-        double currCount;
-        unsigned int currSkip,lastSkip = 0;
-        currCount = 0.0;
-        currSkip = (unsigned int)currCount;
+        unsigned int ndiscarded = inputPort.queryDiscardedEvents() - discarded;
+        discarded += ndiscarded;
 
         int countProcessed = 0;
-        bool firstChecked = false;
-        ev::vQueue::iterator qi;
-        while(currSkip < q->size())  {
-
-            if(!firstChecked) {
-                qi = q->begin();
-                firstChecked = true;
-            } else {
-                qi = qi + ((int)currSkip - lastSkip);
-                lastSkip = currSkip;
-            }
-
-            lastSkip = currSkip;
-            currCount += increment;
-            currSkip = (unsigned int)currCount;
+        for(ev::vQueue::iterator qi = q->begin(); qi != q->end(); qi++) {
 
             //get current event and add it to the surface
             auto ae = ev::is_event<ev::AE>(*qi);
@@ -182,7 +162,7 @@ void vHarrisThread::run()
             scorebottleout.clear();
             scorebottleout.addDouble(inputPort.queryRate());
             scorebottleout.addDouble(countProcessed/(time-prevtime));
-            scorebottleout.addDouble((double)countProcessed/q->size());
+            scorebottleout.addDouble((double)countProcessed/(countProcessed + ndiscarded));
             scorebottleout.addDouble(delay_n);
             scorebottleout.addDouble(inputPort.queryDelayT());
             debugPort.write();
@@ -226,8 +226,7 @@ void delayControl::run()
             qROI.setSize(3000);
 
         //calculate the temporal window of the q
-        double tw = qROI.q.front()->stamp - qROI.q.back()->stamp;
-        if(tw < 0) tw += vtsHelper::max_stamp;
+        double tw = vtsHelper::elapsed(qROI.q.front()->stamp, qROI.q.back()->stamp);
 
         Tresample = yarp::os::Time::now();
         vpf.performResample();
@@ -39,12 +39,10 @@ private:
 
     //ports
     yarp::os::BufferedPort<ev::vBottle> outPort;
+    std::vector<ev::FlowEvent> flowevents;
 
     //data structures
-    ev::vSurface2 *surfaceOnL;
-    ev::vSurface2 *surfaceOfL;
-    ev::vSurface2 *surfaceOnR;
-    ev::vSurface2 *surfaceOfR;
+    ev::surfaceBank<ev::flatSurface> *surfaces; //! per channel and polarity
 
     yarp::sig::Matrix At;
     yarp::sig::Matrix AtA;
@@ -52,16 +50,17 @@ private:
     yarp::sig::Vector abc;
 
     //coputation functions
-    bool compute(ev::vSurface2 *surf, double &vx, double &vy);
+    bool compute(ev::flatSurface *surf, double &vx, double &vy);
     int computeGrads(yarp::sig::Matrix &A, yarp::sig::Vector &Y,
                       double cx, double cy, double cz,
                       double &dtdy, double &dtdx);
-    int computeGrads(const ev::vQueue &subsurf, ev::event<ev::AddressEvent> cen,
+    int computeGrads(const ev::surfaceSpan &subsurf, const ev::surfaceEvent &cen,
                       double &dtdy, double &dtdx);
 
 public:
 
-    vFlowManager(int height, int width, int filterSize, int minEvtsOnPlane);
+    vFlowManager(int height, int width, int filterSize, int minEvtsOnPlane,
+                 int channels = 2);
 
     bool    open(std::string moduleName, bool strictness = false);
     void    close();
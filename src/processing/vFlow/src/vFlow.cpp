@@ -18,6 +18,7 @@
 
 #include "vFlow.h"
 #include <yarp/os/all.h>
+#include <limits>
 
 using yarp::math::outerProduct;
 
@@ -50,8 +51,8 @@ int main(int argc, char * argv[])
 void vFlowManager::onRead(ev::vBottle &inBottle)
 {
 
-    /*prepare output vBottle with AEs extended with optical flow events*/
-    ev::vBottle * outBottle = 0;
+    /*flow events are collected and added to the output vBottle together*/
+    flowevents.clear();
 
     /*get the event queue in the vBottle bot*/
     vQueue q = inBottle.get<AE>();
@@ -60,37 +61,25 @@ void vFlowManager::onRead(ev::vBottle &inBottle)
     {
         auto aep = is_event<AE>(*qi);
 
-        //add the event to the appropriate surface
-        vSurface2 * cSurf;
-        if(aep->getChannel()) {
-            if(aep->polarity)
-                cSurf = surfaceOfR;
-            else
-                cSurf = surfaceOnR;
-        } else {
-            if(aep->polarity)
-                cSurf = surfaceOfL;
-            else
-                cSurf = surfaceOnL;
-        }
+        //add the event to the surface of its channel and polarity
+        flatSurface *cSurf = surfaces->addEvent(*aep);
+        if(!cSurf) continue;
 
         //compute the flow
-        cSurf->fastAddEvent(aep);
         double vx, vy;
         if(compute(cSurf, vx, vy)) {
             //successfully computed a flow event
-            auto vf = make_event<FlowEvent>(aep);
-            vf->vx = vx;
-            vf->vy = vy;
-            if(!outBottle) {
-                outBottle = &outPort.prepare();
-                outBottle->clear();
-            }
-            outBottle->addEvent(vf);
+            FlowEvent vf(*aep);
+            vf.vx = vx;
+            vf.vy = vy;
+            flowevents.push_back(vf);
         }
     }
 
-    if(outBottle) {
+    if(flowevents.size()) {
+        ev::vBottle &outBottle = outPort.prepare();
+        outBottle.clear();
+        outBottle.addEvents(flowevents);
         yarp::os::Stamp st;
         this->getEnvelope(st); outPort.setEnvelope(st);
         if(strictness) outPort.writeStrict();
@@ -99,7 +88,7 @@ void vFlowManager::onRead(ev::vBottle &inBottle)
 }
 
 vFlowManager::vFlowManager(int height, int width, int filterSize,
-                                     int minEvtsOnPlane)
+                                     int minEvtsOnPlane, int channels)
 {
     //ensure sobel size is at least 3 and an odd number
     if(filterSize < 5) filterSize = 3;
@@ -116,11 +105,9 @@ vFlowManager::vFlowManager(int height, int width, int filterSize,
     A2 = yarp::sig::Matrix(3, 3);
 
 
-    //create our surface in synchronous mode
-    surfaceOnL = new ev::temporalSurface(width, height);
-    surfaceOfL = new ev::temporalSurface(width, height);
-    surfaceOnR = new ev::temporalSurface(width, height);
-    surfaceOfR = new ev::temporalSurface(width, height);
+    //create our surfaces in synchronous mode
+    surfaces = new ev::surfaceBank<ev::flatSurface>(channels, true, width,
+                                                    height);
 }
 
 bool vFlowManager::open(std::string moduleName, bool strictness)
@@ -150,10 +137,7 @@ void vFlowManager::close()
     outPort.close();
     yarp::os::BufferedPort<ev::vBottle>::close();
 
-    delete surfaceOnL;
-    delete surfaceOfL;
-    delete surfaceOnR;
-    delete surfaceOfR;
+    delete surfaces;
 
 }
 
@@ -163,33 +147,29 @@ void vFlowManager::interrupt()
     yarp::os::BufferedPort<ev::vBottle>::interrupt();
 }
 
-bool vFlowManager::compute(ev::vSurface2 *surf, double &vx, double &vy)
+bool vFlowManager::compute(ev::flatSurface *surf, double &vx, double &vy)
 {
 
     //get the most recent event
-    auto vr = is_event<AE>(surf->getMostRecent());
+    const surfaceEvent *recent = surf->getMostRecent();
+    if(!recent) return false;
+    const surfaceEvent vr = *recent;
 
 
     //find the side of this event that has the collection of temporally nearby
     //events. Heuristically more likely to be the correct plane.
-    double bestscore = ev::vtsHelper::max_stamp+1;
+    double bestscore = std::numeric_limits<double>::max();
     int besti = 0, bestj = 0;
 
-    for(int i = vr->x-fRad; i <= vr->x+fRad; i+=fRad) {
-        for(int j = vr->y-fRad; j <= vr->y+fRad; j+=fRad) {
+    for(int i = vr.x-fRad; i <= vr.x+fRad; i+=fRad) {
+        for(int j = vr.y-fRad; j <= vr.y+fRad; j+=fRad) {
             //get the surface around the recent event
             double sobeltsdiff = 0;
-            const vQueue subsurf = surf->getSurf(i, j, fRad);
+            const surfaceSpan subsurf = surf->getSurf(i, j, fRad);
             if(subsurf.size() < planeSize) continue;
 
-            for(unsigned int k = 0; k < subsurf.size(); k++) {
-                sobeltsdiff += vr->stamp - subsurf[k]->stamp;
-                if(subsurf[k]->stamp > vr->stamp) {
-                    //subsurf[k]->setStamp(subsurf[k]->stamp -
-                    //                     eventdriven::vtsHelper::maxStamp());
-                    sobeltsdiff += ev::vtsHelper::max_stamp;
-                }
-            }
+            for(unsigned int k = 0; k < subsurf.size(); k++)
+                sobeltsdiff += ev::vtsHelper::elapsed(vr.stamp, subsurf[k].stamp);
             sobeltsdiff /= subsurf.size();
             if(sobeltsdiff < bestscore) {
                 bestscore = sobeltsdiff;
@@ -198,12 +178,12 @@ bool vFlowManager::compute(ev::vSurface2 *surf, double &vx, double &vy)
         }
     }
     //return if we don't find a good candidate plane
-    if(bestscore > ev::vtsHelper::max_stamp) return false;
+    if(bestscore == std::numeric_limits<double>::max()) return false;
 
 
     //get the events
-    const vQueue &subsurf = surf->getSurf(besti, bestj, fRad);
-    //const vQueue &subsurf = surf->getSurf(vr->x, vr->y, fRad);
+    const surfaceSpan subsurf = surf->getSurf(besti, bestj, fRad);
+    //const surfaceSpan subsurf = surf->getSurf(vr.x, vr.y, fRad);
 
     //and compute the gradients of the plane
     if(computeGrads(subsurf, vr, vy, vx) < minEvtsOnPlane)
@@ -212,27 +192,24 @@ bool vFlowManager::compute(ev::vSurface2 *surf, double &vx, double &vy)
     return true;
 }
 
-int vFlowManager::computeGrads(const ev::vQueue &subsurf,
-                                     event<ev::AddressEvent> cen,
+int vFlowManager::computeGrads(const ev::surfaceSpan &subsurf,
+                                     const ev::surfaceEvent &cen,
                                      double &dtdy, double &dtdx)
 {
 
     yarp::sig::Matrix A(subsurf.size(), 3);
     yarp::sig::Vector Y(subsurf.size());
     for(unsigned int vi = 0; vi < subsurf.size(); vi++) {
-        event<ev::AddressEvent> v = as_event<ev::AddressEvent>(subsurf[vi]);
-        A(vi, 0) = v->x;
-        A(vi, 1) = v->y;
+        const ev::surfaceEvent &v = subsurf[vi];
+        A(vi, 0) = v.x;
+        A(vi, 1) = v.y;
         A(vi, 2) = 1;
-        if(v->stamp > cen->stamp) {
-            Y(vi) = (v->stamp - ev::vtsHelper::max_stamp) * ev::vtsHelper::tstosecs();
-        } else {
-            Y(vi) = v->stamp * ev::vtsHelper::tstosecs();
-        }
+        //the time of each event relative to the centre event
+        Y(vi) = -ev::vtsHelper::elapsed(cen.stamp, v.stamp) *
+                ev::vtsHelper::tstosecs();
     }
 
-    return computeGrads(A, Y, cen->x, cen->y, cen->stamp *
-                        ev::vtsHelper::tstosecs(), dtdy, dtdx);
+    return computeGrads(A, Y, cen.x, cen.y, 0, dtdy, dtdx);
 }
 
 int vFlowManager::computeGrads(yarp::sig::Matrix &A, yarp::sig::Vector &Y,
@@ -306,8 +283,10 @@ bool vFlowModule::configure(yarp::os::ResourceFinder &rf)
     int width = rf.check("width", yarp::os::Value(128)).asInt();
     int sobelSize = rf.check("filterSize", yarp::os::Value(3)).asInt();
     int minEvtsOnPlane = rf.check("minEvtsThresh", yarp::os::Value(5)).asInt();
+    int channels = rf.check("channels", yarp::os::Value(2)).asInt();
 
-    flowmanager = new vFlowManager(height, width, sobelSize, minEvtsOnPlane);
+    flowmanager = new vFlowManager(height, width, sobelSize, minEvtsOnPlane,
+                                   channels);
     return flowmanager->open(moduleName, strict);
 
 }
@@ -99,8 +99,34 @@ public:
     /// \brief draw takes an image and overlays the new visualisation textures
     /// \param canvas is the image which may or may not yet exist
     /// \param eSet is the set of events which could possibly be drawn
+    /// \param vTime is the time the image is drawn at
     ///
-    virtual void draw(cv::Mat &canvas, const ev::vQueue &eSet, int vTime) = 0;
+    virtual void draw(cv::Mat &canvas, const ev::vQueue &eSet, ev::stamp_t vTime) = 0;
+
+    ///
+    /// \brief draw overlays the events in a vPacket. Drawers that do not
+    /// implement a vPacket method draw a converted vQueue instead.
+    /// \param canvas is the image which may or may not yet exist
+    /// \param eSet is the packet of events which could possibly be drawn
+    ///
+    virtual void draw(cv::Mat &canvas, const ev::vPacket<> &eSet, ev::stamp_t vTime)
+    {
+        ev::vQueue q;
+        eSet.toQueue(q);
+        draw(canvas, q, vTime);
+    }
+
+    /// \brief draw at the time of the most recent event of eSet
+    void draw(cv::Mat &canvas, const ev::vQueue &eSet)
+    {
+        draw(canvas, eSet, eSet.empty() ? 0 : eSet.back()->stamp);
+    }
+
+    /// \brief draw at the time of the most recent event of eSet
+    void draw(cv::Mat &canvas, const ev::vPacket<> &eSet)
+    {
+        draw(canvas, eSet, eSet.empty() ? 0 : eSet.stamp.back());
+    }
 
     ///
     /// \brief getTag returns the unique code for this drawing method. The
@@ -116,10 +142,38 @@ public:
 
 class addressDraw : public vDraw {
 
+private:
+
+    void drawPixel(cv::Mat &image, int x, int y, int polarity);
+
+public:
+
+    static const std::string drawtype;
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime);
+    virtual void draw(cv::Mat &image, const ev::vPacket<> &eSet, ev::stamp_t vTime);
+    virtual std::string getDrawType();
+    virtual std::string getEventType();
+
+};
+
+/// \brief draws a time surface, decaying with a time constant of half the
+/// display window, ON events in red and OFF events in blue
+class decayDraw : public vDraw {
+
+private:
+
+    ev::decaySurface surface;
+    yarp::sig::ImageOf<yarp::sig::PixelMono> on;
+    yarp::sig::ImageOf<yarp::sig::PixelMono> off;
+
+    void drawSurface(cv::Mat &image);
+
 public:
 
     static const std::string drawtype;
-    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
+    virtual void initialise();
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime);
+    virtual void draw(cv::Mat &image, const ev::vPacket<> &eSet, ev::stamp_t vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
 
@@ -130,7 +184,7 @@ class skinDraw : public vDraw {
 public:
 
     static const std::string drawtype;
-    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
 
@@ -141,7 +195,7 @@ class flowDraw : public vDraw {
 public:
 
     static const std::string drawtype;
-    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
 
@@ -152,7 +206,7 @@ class lifeDraw : public vDraw {
 public:
 
     static const std::string drawtype;
-    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
 
@@ -168,7 +222,7 @@ protected:
 public:
 
     static const std::string drawtype;
-    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
 
@@ -184,7 +238,7 @@ protected:
 public:
 
     static const std::string drawtype;
-    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
 
@@ -195,7 +249,7 @@ class blobDraw : public vDraw {
 public:
 
     static const std::string drawtype;
-    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
 
@@ -206,7 +260,7 @@ class interestDraw : public vDraw {
 public:
 
     static const std::string drawtype;
-    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
 
@@ -251,7 +305,7 @@ public:
     void initialise();
 
     static const std::string drawtype;
-    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
 
@@ -262,7 +316,7 @@ class isoInterestDraw : public isoDraw {
 public:
 
     static const std::string drawtype;
-    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
 
@@ -273,7 +327,7 @@ class isoCircDraw : public isoDraw {
 public:
 
     static const std::string drawtype;
-    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
 
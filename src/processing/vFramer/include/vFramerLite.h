@@ -50,21 +50,29 @@ private:
 
     map<string, vGenReadPort> read_ports;
     map<string, vQueue> event_qs;
+
+    //inputs shared with other channels
+    map<string, vHub> *hubs;
+    string hub_prefix;
+    map<string, vHubReader *> hub_readers;
     vector<vDraw *> drawers;
     BufferedPort< ImageOf<PixelBgr> > image_port;
 
     bool updateQs();
+    unsigned int queryUnprocessed(const string &event_type);
+    const vQueue * readQ(const string &event_type, Stamp &yarp_stamp);
 
     //events are removed in batches corresponding to packets to reduce
     //the amount of timestamp comparisons required.
     map<string, unsigned int> total_time;
     map<string, deque<unsigned int> > bookmark_time;
     map<string, deque<unsigned int> > bookmark_n_events;
-    map<string, int> prev_vstamp;
+    map<string, ev::stamp_t> prev_vstamp;
 
 public:
 
     channelInstance(string channel_name);
+    void shareInputs(map<string, vHub> *hubs, string prefix);
     bool addDrawer(string drawer_name, unsigned int width,
                    unsigned int height, unsigned int window_size, bool flip);
 
@@ -87,6 +95,7 @@ class vFramerModule : public yarp::os::RFModule {
 private:
 
     vector<channelInstance *> publishers;
+    map<string, vHub> hubs;
 
 public:
 
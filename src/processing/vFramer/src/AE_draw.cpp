@@ -35,52 +35,63 @@ std::string addressDraw::getEventType()
     return AddressEvent::tag;
 }
 
-void addressDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
+void addressDraw::drawPixel(cv::Mat &image, int x, int y, int polarity)
+{
+    if(flip) {
+        y = Ylimit - 1 - y;
+        x = Xlimit - 1 - x;
+    }
+
+    cv::Vec3b &cpc = image.at<cv::Vec3b>(y, x);
+
+    if(!polarity)
+    {
+        //blue
+        if(cpc[0] == 1) cpc[0] = 0;   //if positive and negative
+        else cpc[0] = 160;            //if only positive
+        //green
+        if(cpc[1] == 60) cpc[1] = 255;
+        else cpc[1] = 0;
+        //red
+        if(cpc[2] == 0) cpc[2] = 255;
+        else cpc[2] = 160;
+    }
+    else
+    {
+        //blue
+        if(cpc[0] == 160) cpc[0] = 0;   //negative and positive
+        else cpc[0] = 1;                //negative only
+        //green
+        if(cpc[1] == 0) cpc[1] = 255;
+        else cpc[1] = 60;
+        //red
+        if(cpc.val[2] == 160) cpc[2] = 255;
+        else cpc[2] = 0;
+    }
+}
+
+void addressDraw::draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime)
 {
     if(eSet.empty()) return;
-    if(vTime < 0) vTime = eSet.back()->stamp;
     ev::vQueue::const_reverse_iterator qi;
     for(qi = eSet.rbegin(); qi != eSet.rend(); qi++) {
 
-        int dt = vTime - (*qi)->stamp;
-        if(dt < 0) dt += ev::vtsHelper::max_stamp;
+        int dt = ev::vtsHelper::elapsed(vTime, (*qi)->stamp);
         if((unsigned int)dt > display_window) break;
 
-
         auto aep = is_event<AddressEvent>(*qi);
-        int y = aep->y;
-        int x = aep->x;
-        if(flip) {
-            y = Ylimit - 1 - y;
-            x = Xlimit - 1 - x;
-        }
+        drawPixel(image, aep->x, aep->y, aep->polarity);
+    }
+}
 
+void addressDraw::draw(cv::Mat &image, const ev::vPacket<> &eSet, ev::stamp_t vTime)
+{
+    if(eSet.empty()) return;
+    for(int i = (int)eSet.size() - 1; i >= 0; i--) {
 
-        cv::Vec3b &cpc = image.at<cv::Vec3b>(y, x);
+        int dt = ev::vtsHelper::elapsed(vTime, eSet.stamp[i]);
+        if((unsigned int)dt > display_window) break;
 
-        if(!aep->polarity)
-        {
-            //blue
-            if(cpc[0] == 1) cpc[0] = 0;   //if positive and negative
-            else cpc[0] = 160;            //if only positive
-            //green
-            if(cpc[1] == 60) cpc[1] = 255;
-            else cpc[1] = 0;
-            //red
-            if(cpc[2] == 0) cpc[2] = 255;
-            else cpc[2] = 160;
-        }
-        else
-        {
-            //blue
-            if(cpc[0] == 160) cpc[0] = 0;   //negative and positive
-            else cpc[0] = 1;                //negative only
-            //green
-            if(cpc[1] == 0) cpc[1] = 255;
-            else cpc[1] = 60;
-            //red
-            if(cpc.val[2] == 160) cpc[2] = 255;
-            else cpc[2] = 0;
-        }
+        drawPixel(image, eSet.x[i], eSet.y[i], eSet.polarity[i]);
     }
 }
@@ -35,18 +35,16 @@ std::string blobDraw::getEventType()
     return AE::tag;
 }
 
-void blobDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
+void blobDraw::draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime)
 {
 
     if(eSet.empty()) return;
-    if(vTime < 0) vTime = eSet.back()->stamp;
 
     ev::vQueue::const_reverse_iterator qi;
     for(qi = eSet.rbegin(); qi != eSet.rend(); qi++) {
 
 
-        int dt = vTime - (*qi)->stamp;
-        if(dt < 0) dt += ev::vtsHelper::max_stamp;
+        int dt = ev::vtsHelper::elapsed(vTime, (*qi)->stamp);
         if((unsigned int)dt > display_window) break;
 
         auto aep = as_event<AE>(*qi);
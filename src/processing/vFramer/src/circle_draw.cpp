@@ -35,7 +35,7 @@ std::string circleDraw::getEventType()
     return GaussianAE::tag;
 }
 
-void circleDraw::draw(cv::Mat &image, const vQueue &eSet, int vTime)
+void circleDraw::draw(cv::Mat &image, const vQueue &eSet, ev::stamp_t vTime)
 {
     cv::Scalar blue = CV_RGB(0, 0, 255);
     cv::Scalar red = CV_RGB(255, 0, 0);
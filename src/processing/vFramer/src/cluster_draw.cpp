@@ -35,7 +35,7 @@ std::string clusterDraw::getEventType()
     return GaussianAE::tag;
 }
 
-void clusterDraw::draw(cv::Mat &image, const vQueue &eSet, int vTime)
+void clusterDraw::draw(cv::Mat &image, const vQueue &eSet, ev::stamp_t vTime)
 {
     cv::Scalar blue = CV_RGB(0, 0, 255);
 
@@ -0,0 +1,100 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *           valentina.vasco@iit.it
+ *           chiara.bartolozzi@iit.it
+ *           massimiliano.iacono@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vDraw.h"
+
+using namespace ev;
+
+const std::string decayDraw::drawtype = "DECAY";
+
+std::string decayDraw::getDrawType()
+{
+    return decayDraw::drawtype;
+}
+
+std::string decayDraw::getEventType()
+{
+    return AddressEvent::tag;
+}
+
+void decayDraw::initialise()
+{
+    surface = decaySurface(Xlimit, Ylimit, display_window / 2);
+}
+
+void decayDraw::drawSurface(cv::Mat &image)
+{
+    surface.getSurface(on, 1);
+    surface.getSurface(off, 0);
+
+    for(int y = 0; y < Ylimit; y++) {
+        for(int x = 0; x < Xlimit; x++) {
+
+            int a = on(x, y);
+            int b = off(x, y);
+            if(!a && !b) continue;
+
+            //fades from red (ON) or blue (OFF) to white
+            int x_draw = flip ? Xlimit - 1 - x : x;
+            int y_draw = flip ? Ylimit - 1 - y : y;
+            image.at<cv::Vec3b>(y_draw, x_draw) =
+                    cv::Vec3b(255 - a, 255 - std::max(a, b), 255 - b);
+        }
+    }
+}
+
+void decayDraw::draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime)
+{
+    if(eSet.empty()) return;
+
+    //the surface is rebuilt on each frame from the events within the
+    //display window, found walking back from the most recent
+    size_t first = eSet.size();
+    while(first > 0) {
+        int dt = ev::vtsHelper::elapsed(vTime, eSet[first - 1]->stamp);
+        if((unsigned int)dt > display_window) break;
+        first--;
+    }
+
+    surface.clear();
+    for(size_t i = first; i < eSet.size(); i++) {
+        auto aep = is_event<AddressEvent>(eSet[i]);
+        surface.addEvent(aep->stamp, aep->x, aep->y, aep->polarity);
+    }
+    drawSurface(image);
+}
+
+void decayDraw::draw(cv::Mat &image, const ev::vPacket<> &eSet, ev::stamp_t vTime)
+{
+    if(eSet.empty()) return;
+
+    size_t first = eSet.size();
+    while(first > 0) {
+        int dt = ev::vtsHelper::elapsed(vTime, eSet.stamp[first - 1]);
+        if((unsigned int)dt > display_window) break;
+        first--;
+    }
+
+    surface.clear();
+    for(size_t i = first; i < eSet.size(); i++)
+        surface.addEvent(eSet.stamp[i], eSet.x[i], eSet.y[i], eSet.polarity[i]);
+    drawSurface(image);
+}
@@ -35,11 +35,10 @@ std::string flowDraw::getEventType()
     return FlowEvent::tag;
 }
 
-void flowDraw::draw(cv::Mat &image, const vQueue &eSet, int vTime)
+void flowDraw::draw(cv::Mat &image, const vQueue &eSet, ev::stamp_t vTime)
 {
 
     if(eSet.empty()) return;
-    if(vTime < 0) vTime = eSet.back()->stamp;
 
     double vx_mean = 0, vy_mean = 0;
 
@@ -50,8 +49,7 @@ void flowDraw::draw(cv::Mat &image, const vQueue &eSet, int vTime)
     vQueue::const_reverse_iterator qi;
     for(qi = eSet.rbegin(); qi != eSet.rend(); qi++) {
 
-        int dt = vTime - (*qi)->stamp;
-        if(dt < 0) dt += ev::vtsHelper::max_stamp;
+        int dt = ev::vtsHelper::elapsed(vTime, (*qi)->stamp);
         if((unsigned int)dt > display_window/4) break;
 
         auto ofp = is_event<ev::FlowEvent>(*qi);
@@ -35,11 +35,10 @@ std::string interestDraw::getEventType()
     return LabelledAE::tag;
 }
 
-void interestDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
+void interestDraw::draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime)
 {
 
     if(eSet.empty()) return;
-    if(vTime < 0) vTime = eSet.back()->stamp;
 
     int r = 2;
     CvScalar c1 = CV_RGB(255, 0, 0);
@@ -47,8 +46,7 @@ void interestDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
 
     ev::vQueue::const_reverse_iterator qi;
     for(qi = eSet.rbegin(); qi != eSet.rend(); qi++) {
-        int dt = vTime - (*qi)->stamp;
-        if(dt < 0) dt += ev::vtsHelper::max_stamp;
+        int dt = ev::vtsHelper::elapsed(vTime, (*qi)->stamp);
         if((unsigned int)dt > display_window) break;
 
         auto v = is_event<ev::LabelledAE>(*qi);
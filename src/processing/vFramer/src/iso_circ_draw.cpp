@@ -30,7 +30,7 @@ std::string isoCircDraw::getEventType()
 {
     return ev::GaussianAE::tag;
 }
-void isoCircDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
+void isoCircDraw::draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime)
 {
     cv::Scalar blue = CV_RGB(0, 0, 255);
     cv::Scalar red = CV_RGB(255, 0, 0);
@@ -165,14 +165,13 @@ void isoDraw::initialise()
 
 }
 
-void isoDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
+void isoDraw::draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime)
 {
 
     cv::Mat isoimage = baseimage.clone();
     isoimage.setTo(255);
 
     if(eSet.empty()) return;
-    if(vTime < 0) vTime = eSet.back()->stamp;
 
     int skip = 1 + eSet.size() / 100000;
 
@@ -181,8 +180,7 @@ void isoDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
         AE *aep = read_as<AE>(eSet[i]);
 
         //transform values
-        int dt = vTime - aep->stamp;
-        if(dt < 0) dt += ev::vtsHelper::max_stamp;
+        int dt = ev::vtsHelper::elapsed(vTime, aep->stamp);
         if((unsigned int)dt > max_window) continue;
         dt = dt * ts_to_axis + 0.5;
         int px = aep->x;
@@ -35,14 +35,13 @@ std::string isoInterestDraw::getEventType()
     return LabelledAE::tag;
 }
 
-void isoInterestDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
+void isoInterestDraw::draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime)
 {
 
     cv::Mat isoimage = baseimage.clone();
     isoimage.setTo(255);
 
     if(eSet.empty()) return;
-    if(vTime < 0) vTime = eSet.back()->stamp;
 
     int skip = 1 + eSet.size() / 50000;
 
@@ -57,8 +56,7 @@ void isoInterestDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
         LabelledAE *cep = read_as<LabelledAE>(eSet[i]);
 
         //transform values
-        int dt = vTime - cep->stamp;
-        if(dt < 0) dt += ev::vtsHelper::max_stamp;
+        int dt = ev::vtsHelper::elapsed(vTime, cep->stamp);
         if((unsigned int)dt > max_window) continue;
         dt = dt * ts_to_axis + 0.5;
         int px = cep->x;
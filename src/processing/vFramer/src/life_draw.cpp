@@ -35,20 +35,18 @@ std::string lifeDraw::getEventType()
     return FlowEvent::tag;
 }
 
-void lifeDraw::draw(cv::Mat &image, const vQueue &eSet, int vTime)
+void lifeDraw::draw(cv::Mat &image, const vQueue &eSet, ev::stamp_t vTime)
 {
 
     if(eSet.empty()) return;
-    if(vTime < 0) vTime = eSet.back()->stamp;
 
     vQueue::const_iterator qi;
     for(qi = eSet.begin(); qi != eSet.end(); qi++) {
 
         auto v = is_event<FlowEvent>(*qi);
 
-        int dt = vTime - v->stamp;
-        if(dt < 0) dt += vtsHelper::max_stamp;
-        if(dt > v->getDeath()) continue;
+        int dt = vtsHelper::elapsed(vTime, v->stamp);
+        if(dt > v->getLifetime()) continue;
 
         cv::Vec3b &cpc = image.at<cv::Vec3b>(v->y, v->x);
 
@@ -34,7 +34,7 @@ std::string skinDraw::getEventType()
     return AddressEvent::tag;
 }
 
-void skinDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
+void skinDraw::draw(cv::Mat &image, const ev::vQueue &eSet, ev::stamp_t vTime)
 {
     cv::Scalar pos = CV_RGB(160, 0, 160);
     cv::Scalar neg = CV_RGB(0, 60, 1);
@@ -52,8 +52,7 @@ void skinDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
     for(qi = eSet.rbegin(); qi != eSet.rend(); qi++) {
 
 
-        int dt = eSet.back()->stamp - (*qi)->stamp; // start with newest event
-        if(dt < 0) dt += ev::vtsHelper::max_stamp;
+        int dt = ev::vtsHelper::elapsed(eSet.back()->stamp, (*qi)->stamp); // start with newest event
         if((unsigned int)dt > display_window) break;
 
 
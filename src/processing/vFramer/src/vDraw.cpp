@@ -50,6 +50,8 @@ vDraw * createDrawer(std::string tag)
         return new isoInterestDraw();
     if(tag == isoCircDraw::drawtype)
         return new isoCircDraw();
+    if(tag == decayDraw::drawtype)
+        return new decayDraw();
     return 0;
 
 }
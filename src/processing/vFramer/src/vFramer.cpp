@@ -225,7 +225,7 @@ bool vFramerModule::updateModule()
 
     //snapshot the current time
     vReader.updateStamps();
-    int current_vts = vReader.getvstamp();
+    ev::stamp_t current_vts = vReader.getvstamp();
     yarp::os::Stamp cEnv = vReader.getystamp();
 
 
@@ -264,8 +264,7 @@ bool vFramerModule::updateModule()
             for(unsigned int j = 0; j < drawers[i].size(); j++) {
                 //if(q_snaps[i][j].empty()) continue;
                 drawers[i][j]->draw(canvas, vReader.queryWindow(drawers[i][j]->getEventType(),
-                                                                channels[i]),
-                                    -1);
+                                                                channels[i]));
             }
         }
         acct2 += Time::now() - dt2;
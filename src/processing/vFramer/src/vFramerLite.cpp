@@ -46,6 +46,13 @@ channelInstance::channelInstance(string channel_name) : RateThread(0.1)
 {
     this->channel_name = channel_name;
     this->limit_time = 1.0 * vtsHelper::vtsscaler;
+    this->hubs = 0;
+}
+
+void channelInstance::shareInputs(map<string, vHub> *hubs, string prefix)
+{
+    this->hubs = hubs;
+    this->hub_prefix = prefix;
 }
 
 string channelInstance::getName()
@@ -72,12 +79,23 @@ bool channelInstance::addDrawer(string drawer_name, unsigned int width,
     string event_type = new_drawer->getEventType();
 
     //check to see if we need to open a new input port
-    if(read_ports.count(event_type))
+    if(read_ports.count(event_type) || hub_readers.count(event_type))
         return true;
 
-    //open the port
     total_time[event_type] = 0;
     prev_vstamp[event_type] = 0;
+
+    //subscribe to the input of this type shared by all channels
+    if(hubs) {
+        bool opened = hubs->count(event_type);
+        vHub &hub = (*hubs)[event_type];
+        hub_readers[event_type] = hub.subscribe();
+        if(!opened)
+            return hub.open(hub_prefix + "/" + event_type + ":i");
+        return true;
+    }
+
+    //open the port
     return read_ports[event_type].open(channel_name + "/" + event_type + ":i");
 
 }
@@ -87,27 +105,41 @@ bool channelInstance::threadInit()
     return image_port.open(channel_name + "/image:o");
 }
 
+unsigned int channelInstance::queryUnprocessed(const string &event_type)
+{
+    if(hubs)
+        return hub_readers[event_type]->queryunprocessed();
+    return read_ports[event_type].queryunprocessed();
+}
+
+const vQueue * channelInstance::readQ(const string &event_type,
+                                      Stamp &yarp_stamp)
+{
+    if(hubs)
+        return hub_readers[event_type]->read(yarp_stamp);
+    return read_ports[event_type].read(yarp_stamp);
+}
+
 bool channelInstance::updateQs()
 {
     bool updated = false;
     Stamp yarp_stamp;
     //fill up the q's as much as possible
     map<string, int> qs_available;
-    std::map<string, vGenReadPort>::iterator port_i;
-    for(port_i = read_ports.begin(); port_i != read_ports.end(); port_i++) {
-        qs_available[port_i->first] = port_i->second.queryunprocessed();
-        if(qs_available[port_i->first]) updated = true;
+    std::map<string, unsigned int>::iterator type_i;
+    for(type_i = total_time.begin(); type_i != total_time.end(); type_i++) {
+        qs_available[type_i->first] = queryUnprocessed(type_i->first);
+        if(qs_available[type_i->first]) updated = true;
     }
 
-    for(port_i = read_ports.begin(); port_i != read_ports.end(); port_i++) {
-        const string &event_type = port_i->first;
+    for(type_i = total_time.begin(); type_i != total_time.end(); type_i++) {
+        const string &event_type = type_i->first;
         for(int i = 0; i < qs_available[event_type]; i++) {
-            const vQueue *q = port_i->second.read(yarp_stamp);
+            const vQueue *q = readQ(event_type, yarp_stamp);
 
-            int q_dt = (int)q->back()->stamp - prev_vstamp[event_type];
-            if(q_dt < 0) q_dt += vtsHelper::max_stamp;
+            int q_dt = vtsHelper::elapsed(q->back()->stamp, prev_vstamp[event_type]);
 
-            prev_vstamp[event_type] = (int)q->back()->stamp;
+            prev_vstamp[event_type] = q->back()->stamp;
             total_time[event_type] += q_dt;
             bookmark_time[event_type].push_back(q_dt);
             bookmark_n_events[event_type].push_back(q->size());
@@ -144,7 +176,7 @@ void channelInstance::run()
 
     vector<vDraw *>::iterator drawer_i;
     for(drawer_i = drawers.begin(); drawer_i != drawers.end(); drawer_i++) {
-        (*drawer_i)->draw(canvas, event_qs[(*drawer_i)->getEventType()], -1);
+        (*drawer_i)->draw(canvas, event_qs[(*drawer_i)->getEventType()]);
     }
 
 
@@ -206,6 +238,10 @@ bool vFramerModule::configure(yarp::os::ResourceFinder &rf)
     //        rf.check("timeout") && rf.check("timeout", Value(true)).asBool();
     bool flip =
             rf.check("flip") && rf.check("flip", Value(true)).asBool();
+    //read each event type once for all displays
+    bool shareInputs =
+            rf.check("shareInputs") &&
+            rf.check("shareInputs", Value(true)).asBool();
     //bool forceRender =
     //        rf.check("forcerender") &&
     //        rf.check("forcerender", Value(true)).asBool();
@@ -245,6 +281,8 @@ bool vFramerModule::configure(yarp::os::ResourceFinder &rf)
 
         channelInstance * new_ci = new channelInstance(channel_name);
         new_ci->setRate(period);
+        if(shareInputs)
+            new_ci->shareInputs(&hubs, moduleName);
 
         Bottle * drawtypelist = displayList->get(i*2 + 1).asList();
         for(unsigned int j = 0; j < drawtypelist->size(); j++)
@@ -288,6 +326,10 @@ bool vFramerModule::close()
     for(pub_i = publishers.begin(); pub_i != publishers.end(); pub_i++)
         (*pub_i)->stop();
 
+    map<string, vHub>::iterator hub_i;
+    for(hub_i = hubs.begin(); hub_i != hubs.end(); hub_i++)
+        hub_i->second.close();
+
     return true;
 }
 
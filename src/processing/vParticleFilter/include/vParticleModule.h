@@ -40,6 +40,7 @@ class vParticleModule : public yarp::os::RFModule
     particleProcessor *leftThread;
     hSurfThread eventhandler;
     collectorPort outport;
+    ev::vStatsPublisher stats;
 
 public:
 
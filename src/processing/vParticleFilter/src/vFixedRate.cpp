@@ -229,11 +229,10 @@ void vParticleReader::onRead(ev::vBottle &inputBottle)
         }
 
         stw = surfaceLeft.getSurf_Tlim(maxtw);
-        unsigned int ctime = (*qi)->stamp;
+        ev::stamp_t ctime = (*qi)->stamp;
         for(unsigned int i = 0; i < stw.size(); i++) {
             //calc dt
-            double dt = ctime - stw[i]->stamp;
-            if(dt < 0) dt += ev::vtsHelper::max_stamp;
+            double dt = ev::vtsHelper::elapsed(ctime, stw[i]->stamp);
             auto v = is_event<AE>(stw[i]);
             for(int i = 0; i < nparticles; i++) {
                 if(dt < indexedlist[i].gettw())
@@ -312,8 +311,7 @@ void vParticleReader::onRead(ev::vBottle &inputBottle)
         yarp::os::Bottle &sob = scopeOut.prepare();
         sob.clear();
 
-        double dt = q.back()->stamp - q.front()->stamp;
-        if(dt < 0) dt += ev::vtsHelper::max_stamp;
+        double dt = ev::vtsHelper::elapsed(q.back()->stamp, q.front()->stamp);
         sob.addDouble(dt);
         sob.addDouble(q.size());
         scopeOut.setEnvelope(st);
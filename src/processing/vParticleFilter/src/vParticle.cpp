@@ -55,8 +55,7 @@ void drawEvents(yarp::sig::ImageOf< yarp::sig::PixelBgr> &image, ev::vQueue &q,
 
     for(unsigned int i = 0; i < q.size(); i++) {
         if(tw) {
-            double dt = currenttime - q[i]->stamp;
-            if(dt < 0) dt += ev::vtsHelper::max_stamp;
+            double dt = ev::vtsHelper::elapsed(currenttime, q[i]->stamp);
             if(dt > tw) break;
         }
 
@@ -64,6 +64,8 @@ bool vParticleModule::configure(yarp::os::ResourceFinder &rf)
             rf.check("adaptive", yarp::os::Value(true)).asBool();
     bool useroi = rf.check("useroi") &&
             rf.check("useroi", yarp::os::Value(true)).asBool();
+    bool concurrent = rf.check("concurrent") &&
+            rf.check("concurrent", yarp::os::Value(true)).asBool();
 
     //filter paramters
     int rightParticles = rf.check("rParticles", yarp::os::Value(100)).asInt();
@@ -105,7 +107,9 @@ bool vParticleModule::configure(yarp::os::ResourceFinder &rf)
     } else {
 
         /* USE REAL-TIME THREAD */
-        eventhandler.configure(height, width, 0.15);
+        eventhandler.configure(height, width, 0.15, concurrent);
+        if(stats.open(getName()))
+            eventhandler.registerStats(stats, getName());
 
         if(leftParticles) {
             leftThread = new particleProcessor(getName(), height, width, &eventhandler, &outport);
@@ -169,6 +173,7 @@ bool vParticleModule::interruptModule()
 bool vParticleModule::close()
 {
     if(particleCallback) particleCallback->close();
+    stats.close();
     std::cout << "Close Successful" << std::endl;
     return true;
 }
@@ -148,12 +148,16 @@ void particleProcessor::run()
             //yarpstamp = eventhandler2.queryWindow(stw2, camera, 100000);
     }
     yarp::os::Stamp yarpstamp = eventhandler->queryYstamp();
-    int currentstamp = eventhandler->queryVstamp(camera);
+    ev::stamp_t currentstamp = eventhandler->queryVstamp(camera);
+
+    //the traces of the windows, as stw and stw2
+    ev::vTrace trace, trace2;
 
     while(!isStopping()) {
 
         Twincopy = yarp::os::Time::now();
         stw = stw2;
+        trace.swap(trace2);
         Twincopy = yarp::os::Time::now() - Twincopy;
 
 
@@ -199,9 +203,7 @@ void particleProcessor::run()
         Tlikelihood = yarp::os::Time::now();
         std::vector<int> deltats; deltats.resize(stw.size());
         for(unsigned int i = 0; i < stw.size(); i++) {
-            double dt = currentstamp - stw[i]->stamp;
-            if(dt < 0)
-                dt += ev::vtsHelper::max_stamp;
+            double dt = ev::vtsHelper::elapsed(currentstamp, stw[i]->stamp);
             deltats[i] = dt;
         }
 
@@ -275,6 +277,9 @@ void particleProcessor::run()
 
         yarpstamp = eventhandler->queryYstamp();
         currentstamp = eventhandler->queryVstamp(camera);
+        trace2 = eventhandler->queryTrace();
+        if(!trace2.empty())
+            trace2.add(name + (camera ? "/right" : "/left") + "/window");
         Tgetwindow = yarp::os::Time::now() - Tgetwindow;
 
 
@@ -324,6 +329,10 @@ void particleProcessor::run()
         ceg->sigxy = obsInlier;
         ceg->polarity = detection;
 
+        if(!trace.empty()) {
+            trace.add(name + (camera ? "/right" : "/left") + "/estimate");
+            eventsender->pushtrace(trace);
+        }
         eventsender->pushevent(ceg, yarpstamp);
 
 
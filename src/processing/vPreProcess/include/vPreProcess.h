@@ -24,7 +24,7 @@
 #ifndef __VPREPROCESS__
 #define __VPREPROCESS__
 
-#define DECODE_METHOD 2
+#define DECODE_METHOD 3
 
 #include <yarp/os/all.h>
 #include <iCub/eventdriven/all.h>
@@ -46,10 +46,14 @@ private:
     vGenReadPort inPort;
     vGenWritePort outPort;
     vGenWritePort outPort2;
-#else
+#elif DECODE_METHOD == 2
     vReadPort<AE> inPort;
     vWritePort<AE> outPort;
     vWritePort<AE> outPort2;
+#else
+    vViewReadPort inPort;
+    vWritePort<AE> outPort;
+    vWritePort<AE> outPort2;
 #endif
 
     //parameters
@@ -75,10 +79,18 @@ private:
     //output
     bool split;
 
-    //timing stats
-    std::deque<double> delays;
-    std::deque<double> rates;
-    std::deque<double> intervals;
+    //transport
+    std::string source;
+    bool shm;
+    int async;
+    std::string async_policy;
+
+    //timing stats: the delay of a packet since it was sent and the interval
+    //between packets (ns), and the event rate of a packet (events/s)
+    vHistogram delay_hist;
+    vHistogram interval_hist;
+    vHistogram rate_hist;
+    vStatsPublisher stats;
 
 public:
 
@@ -89,12 +101,11 @@ public:
                    bool flipx, bool flipy, bool pepper, bool undistort,
                    bool split);
     void initPepper(int spatialSize, int temporalSize);
+    void initTransport(std::string source, bool shm, int async,
+                       std::string asyncPolicy);
     void initUndistortion(const yarp::os::Bottle &left,
                           const yarp::os::Bottle &right, bool truncate);
     int queryUnprocessed();
-    std::deque<double> getDelays();
-    std::deque<double> getRates();
-    std::deque<double> getIntervals();
     void run();
     void onStop();
     bool threadInit();
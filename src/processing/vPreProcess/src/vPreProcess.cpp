@@ -74,12 +74,24 @@ bool vPreProcessModule::configure(yarp::os::ResourceFinder &rf)
     if(split)
         yInfo() << "Splitting into left/right streams";
 
+    if(rf.check("codec")) {
+        ev::codecLayout layout = ev::layoutFromName(rf.find("codec").asString());
+        if(layout == ev::LAYOUT_DEFAULT) {
+            yError() << "Unknown codec:" << rf.find("codec").asString();
+            return false;
+        }
+        ev::setDefaultLayout(layout);
+    }
+    yInfo() << "Using codec" << ev::layoutName(ev::LAYOUT_DEFAULT);
+
 #if DECODE_METHOD == 0
     yInfo() << "Decoding with vBottle";
 #elif DECODE_METHOD == 1
     yInfo() << "Decoding with shared_ptrs";
-#else
+#elif DECODE_METHOD == 2
     yInfo() << "Decoding with fixed AE";
+#else
+    yInfo() << "Decoding with packet views";
 #endif
 
 
@@ -88,6 +100,12 @@ bool vPreProcessModule::configure(yarp::os::ResourceFinder &rf)
                            rf.check("width", yarp::os::Value(304)).asInt(),
                            precheck, flipx, flipy, pepper, undistort, split);
 
+    eventManager.initTransport(rf.check("source", yarp::os::Value("")).asString(),
+                               rf.check("shm") &&
+                               rf.check("shm", yarp::os::Value(true)).asBool(),
+                               rf.check("async", yarp::os::Value(0)).asInt(),
+                               rf.check("asyncPolicy", yarp::os::Value("block")).asString());
+
     if(pepper) {
         eventManager.initPepper(rf.check("spatialSize", yarp::os::Value(1)).asDouble(),
                                 rf.check("temporalSize", yarp::os::Value(100000)).asDouble());
@@ -132,46 +150,6 @@ bool vPreProcessModule::updateModule()
     }
 
     return true;
-
-    //delays
-    std::deque<double> dcopy = eventManager.getDelays();
-
-    if(!dcopy.size())
-        return true;
-
-    double mind = 1e6;
-    double maxd = -1e6;
-    double meand = 0;
-    for(size_t i = 0; i < dcopy.size(); i++) {
-        mind = std::min(mind, dcopy[i]);
-        maxd = std::max(maxd, dcopy[i]);
-        meand += dcopy[i];
-    }
-    meand /= dcopy.size();
-    meand *= 1000;
-    mind *= 1000;
-    maxd *= 1000;
-
-    double meanr = 0;
-    std::deque<double> rcopy = eventManager.getRates();
-    for(size_t i = 0; i < rcopy.size(); i++) {
-        meanr += rcopy[i];
-    }
-    meanr /= rcopy.size();
-    meanr *= vtsHelper::vtsscaler;
-
-    double meani = 0;
-    std::deque<double> icopy = eventManager.getIntervals();
-    for(size_t i = 0; i < icopy.size(); i++) {
-        meani += icopy[i];
-    }
-    meani /= icopy.size();
-    meani *= 1000;
-
-    //yInfo() << mind << meand << maxd << " : min | mean | max";
-    std::cout << std::fixed << mind << " " << meand << " " << maxd << " " << meanr << " " << meani << std::endl;
-
-    return true;
 }
 
 double vPreProcessModule::getPeriod()
@@ -210,6 +188,15 @@ void vPreProcess::initBasic(std::string name, int height, int width,
 
 }
 
+void vPreProcess::initTransport(std::string source, bool shm,
+                                int async, std::string asyncPolicy)
+{
+    this->source = source;
+    this->shm = shm;
+    this->async = async;
+    this->async_policy = asyncPolicy;
+}
+
 void vPreProcess::initPepper(int spatialSize, int temporalSize)
 {
     thefilter.initialise(res.width, res.height, temporalSize, spatialSize);
@@ -273,27 +260,6 @@ int vPreProcess::queryUnprocessed()
     return inPort.queryunprocessed();
 }
 
-std::deque<double> vPreProcess::getDelays()
-{
-    std::deque<double> dcopy = delays;
-    delays.clear();
-    return dcopy;
-}
-
-std::deque<double> vPreProcess::getRates()
-{
-    std::deque<double> rcopy = rates;
-    rates.clear();
-    return rcopy;
-}
-
-std::deque<double> vPreProcess::getIntervals()
-{
-    std::deque<double> icopy = intervals;
-    intervals.clear();
-    return icopy;
-}
-
 void vPreProcess::run()
 {
     yarp::os::Stamp ystamp;
@@ -303,7 +269,7 @@ void vPreProcess::run()
     resmod.width -= 1;
     int prev_bottle_n = 0;
 
-#if DECODE_METHOD != 2
+#if DECODE_METHOD < 2
     outPort.setWriteType(AE::tag);
     outPort2.setWriteType(AE::tag);
 #endif
@@ -312,21 +278,30 @@ void vPreProcess::run()
 
         double pyt = ystamp.getTime();
 
-#if DECODE_METHOD != 2
+#if DECODE_METHOD < 2
         vQueue qleft, qright;
         const vQueue *q = inPort.read(ystamp);
-#else
+#elif DECODE_METHOD == 2
         std::deque<AE> qleft, qright;
         const std::vector<AE> *q = inPort.read(ystamp);
+#else
+        std::deque<AE> qleft, qright;
+        const vPacketView *q = inPort.read(ystamp);
 #endif
         if(!q) break;
-        delays.push_back((Time::now() - ystamp.getTime()));
-        if(pyt) intervals.push_back(ystamp.getTime() - pyt);
-
-#if DECODE_METHOD != 2
-        rates.push_back((double)q->size() / (q->back()->stamp - q->front()->stamp));
-#else
-        rates.push_back((double)q->size() / (q->back().stamp - q->front().stamp));
+        double delay = Time::now() - ystamp.getTime();
+        if(delay > 0) delay_hist.record(delay * 1e9);
+        if(pyt && ystamp.getTime() > pyt)
+            interval_hist.record((ystamp.getTime() - pyt) * 1e9);
+
+        int dt = packetDuration(*q);
+        if(dt > 0)
+            rate_hist.record(q->size() * vtsHelper::vtsscaler / dt);
+#if DECODE_METHOD == 3
+        if(!q->isType<AE>()) {
+            yWarning() << "vPreProcess requires AddressEvents, read" << q->type();
+            continue;
+        }
 #endif
 
 
@@ -343,13 +318,17 @@ void vPreProcess::run()
         prev_bottle_n = ystamp.getCount();
 
 
-#if DECODE_METHOD != 2
+#if DECODE_METHOD < 2
         for(ev::vQueue::const_iterator qi = q->begin(); qi != q->end(); qi++) {
             auto v = is_event<AE>(*qi);
-#else
+#elif DECODE_METHOD == 2
         for(std::vector<AE>::const_iterator qi = q->begin(); qi != q->end(); qi++) {
             AE vcopy = *qi;
             AE *v = &vcopy;
+#else
+        for(auto qi = q->begin<AE>(); qi != q->end<AE>(); qi++) {
+            AE vcopy = *qi;
+            AE *v = &vcopy;
 #endif
 
             //precheck
@@ -385,7 +364,7 @@ void vPreProcess::run()
             }
 
 
-#if DECODE_METHOD != 2
+#if DECODE_METHOD < 2
             if(split && v->channel)
                 qright.push_back(v);
             else
@@ -398,10 +377,14 @@ void vPreProcess::run()
 #endif
         }
 
+        //forward the trace of a traced packet to the packets it produced
+        const vTrace &trace = inPort.queryTrace();
         if(qleft.size()) {
+            if(!trace.empty()) outPort.setTrace(trace);
             outPort.write(qleft, ystamp);
         }
         if(qright.size()) {
+            if(!trace.empty()) outPort2.setTrace(trace);
             outPort2.write(qright, ystamp);
         }
     }
@@ -410,6 +393,7 @@ void vPreProcess::run()
 
 void vPreProcess::onStop()
 {
+    stats.close();
     inPort.close();
     outPort.close();
     outPort2.close();
@@ -424,12 +408,46 @@ bool vPreProcess::threadInit()
             return false;
         if(!outPort2.open(name + "/right:o"))
             return false;
+        if(shm && !(outPort.enableSharedMemory() && outPort2.enableSharedMemory()))
+            return false;
     } else {
         if(!outPort.open(name + "/vBottle:o"))
             return false;
+        if(shm && !outPort.enableSharedMemory())
+            return false;
+    }
+    if(shm)
+        yInfo() << "Publishing events in shared memory";
+
+    //latency, size and rate distributions on /name/stats:o
+    if(stats.open(name)) {
+        stats.add(name + "/delay_us", &delay_hist, 1e-3);
+        stats.add(name + "/interval_us", &interval_hist, 1e-3);
+        stats.add(name + "/rate", &rate_hist);
+        outPort.registerStats(stats);
+        if(split) outPort2.registerStats(stats);
+    }
+    if(async > 0) {
+        outPort.setAsync(async, asyncPolicyFromName(async_policy));
+        if(split) outPort2.setAsync(async, asyncPolicyFromName(async_policy));
+        yInfo() << "Sending events from" << async << "buffers, when full:"
+                << async_policy;
     }
+
+#if DECODE_METHOD == 0
+    if(!inPort.open(name + "/vBottle:i"))
+        return false;
+    if(source.size())
+        yarp::os::Network::connect(source, name + "/vBottle:i");
+#else
+    if(source.size())
+        inPort.connectFrom(source);
     if(!inPort.open(name + "/vBottle:i"))
         return false;
+    if(inPort.isSharedMemory())
+        yInfo() << "Reading" << source << "from shared memory";
+    inPort.registerStats(stats);
+#endif
     return true;
 }
 
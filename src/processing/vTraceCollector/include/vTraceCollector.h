@@ -0,0 +1,84 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// \defgroup Modules Modules
+// \defgroup vTraceCollector vTraceCollector
+// \ingroup Modules
+// \brief reports the latency of each stage of a pipeline from packet traces
+
+#ifndef __VTRACECOLLECTOR__
+#define __VTRACECOLLECTOR__
+
+#include <yarp/os/all.h>
+#include <iCub/eventdriven/all.h>
+#include <map>
+#include <mutex>
+#include <atomic>
+
+/*////////////////////////////////////////////////////////////////////////////*/
+//TRACEREADER
+/*////////////////////////////////////////////////////////////////////////////*/
+/// \brief reads completed traces (a Bottle holding the string of a vTrace)
+/// and records the time between each pair of consecutive points, the time
+/// from the first to the last point, and the time of the longest segment of
+/// each trace (the critical stage)
+class traceReader : public yarp::os::BufferedPort<yarp::os::Bottle>
+{
+private:
+
+    ev::vStatsPublisher *stats;
+    std::map<std::string, ev::vHistogram> histograms;
+    std::mutex m;
+    std::atomic<unsigned int> invalid;
+
+    ev::vHistogram* histogram(const std::string &name);
+
+public:
+
+    traceReader();
+
+    bool open(const std::string &name, ev::vStatsPublisher *stats);
+    void onRead(yarp::os::Bottle &input);
+
+    unsigned int queryInvalid() { return invalid; }
+
+};
+
+/*////////////////////////////////////////////////////////////////////////////*/
+//VTRACECOLLECTORMODULE
+/*////////////////////////////////////////////////////////////////////////////*/
+class vTraceCollectorModule : public yarp::os::RFModule
+{
+private:
+
+    traceReader reader;
+    ev::vStatsPublisher stats;
+    yarp::os::BufferedPort<yarp::os::Bottle> reportPort;
+    double period;
+
+public:
+
+    virtual bool configure(yarp::os::ResourceFinder &rf);
+    virtual bool interruptModule();
+    virtual bool close();
+    virtual double getPeriod();
+    virtual bool updateModule();
+
+};
+
+#endif
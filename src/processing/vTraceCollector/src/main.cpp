@@ -0,0 +1,38 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vTraceCollector.h"
+#include "yarp/os/all.h"
+
+int main(int argc, char * argv[])
+{
+    /* initialize yarp network */
+    yarp::os::Network yarp;
+
+    /* prepare and configure the resource finder */
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose( true );
+    rf.setDefaultContext( "eventdriven" );
+    rf.setDefaultConfigFile( "vTraceCollector.ini" );
+    rf.configure( argc, argv );
+
+    /* create the module */
+    vTraceCollectorModule vTraceCollectorInstance;
+    /* run the module: runModule() calls configure first and, if successful, it then runs */
+    return vTraceCollectorInstance.runModule(rf);
+}
@@ -0,0 +1,152 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vTraceCollector.h"
+#include <iomanip>
+#include <sstream>
+
+using namespace ev;
+
+/*////////////////////////////////////////////////////////////////////////////*/
+//TRACEREADER
+/*////////////////////////////////////////////////////////////////////////////*/
+
+traceReader::traceReader()
+{
+    stats = 0;
+    invalid = 0;
+    useCallback();
+}
+
+bool traceReader::open(const std::string &name, vStatsPublisher *stats)
+{
+    this->stats = stats;
+    return yarp::os::BufferedPort<yarp::os::Bottle>::open(name);
+}
+
+vHistogram* traceReader::histogram(const std::string &name)
+{
+    std::map<std::string, vHistogram>::iterator i = histograms.find(name);
+    if(i != histograms.end())
+        return &i->second;
+
+    //histograms are published in the order they are first seen
+    vHistogram *h = &histograms[name];
+    stats->add(name, h, 1e-3);
+    return h;
+}
+
+void traceReader::onRead(yarp::os::Bottle &input)
+{
+    vTrace trace;
+    if(!trace.fromString(input.get(0).asString()) || trace.points.size() < 2) {
+        invalid++;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m);
+
+    //each segment between consecutive points. Clocks of different hosts
+    //that are not synchronised can give negative times, counted as 0.
+    std::string critical;
+    double longest = -1;
+    for(size_t i = 1; i < trace.points.size(); i++) {
+        std::string segment = trace.points[i-1].name + "->" +
+                trace.points[i].name;
+        double dt = trace.points[i].time - trace.points[i-1].time;
+        if(dt < 0) dt = 0;
+        histogram(segment)->record(dt * 1e9);
+        if(dt > longest) {
+            longest = dt;
+            critical = segment;
+        }
+    }
+
+    //the full path, and the stage that contributed most to it
+    double total = trace.points.back().time - trace.points.front().time;
+    if(total < 0) total = 0;
+    histogram("end-to-end")->record(total * 1e9);
+    histogram("critical:" + critical)->record(longest * 1e9);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+//VTRACECOLLECTORMODULE
+/*////////////////////////////////////////////////////////////////////////////*/
+
+bool vTraceCollectorModule::configure(yarp::os::ResourceFinder &rf)
+{
+    setName((rf.check("name", yarp::os::Value("/vTraceCollector")).asString()).c_str());
+    period = rf.check("period", yarp::os::Value(1.0)).asDouble();
+
+    if(!reader.open(getName() + "/trace:i", &stats))
+        return false;
+
+    if(!reportPort.open(getName() + "/latency:o"))
+        return false;
+
+    return true;
+}
+
+bool vTraceCollectorModule::interruptModule()
+{
+    reader.interrupt();
+    reportPort.interrupt();
+    return yarp::os::RFModule::interruptModule();
+}
+
+bool vTraceCollectorModule::close()
+{
+    reader.close();
+    reportPort.close();
+    return yarp::os::RFModule::close();
+}
+
+double vTraceCollectorModule::getPeriod()
+{
+    return period;
+}
+
+bool vTraceCollectorModule::updateModule()
+{
+    //the percentiles of each histogram since the last report
+    yarp::os::Bottle report = stats.collect();
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1);
+    oss << "latency (us)" << std::setw(10) << "count" << std::setw(10) << "50%"
+        << std::setw(10) << "90%" << std::setw(10) << "99%" << std::setw(10)
+        << "max";
+    for(size_t i = 0; i < report.size(); i++) {
+        yarp::os::Bottle *h = report.get(i).asList();
+        if(!h || !h->get(1).asInt()) continue;
+        oss << std::endl << h->get(0).asString() << std::endl << std::setw(22)
+            << h->get(1).asInt() << std::setw(10) << h->get(2).asDouble()
+            << std::setw(10) << h->get(3).asDouble() << std::setw(10)
+            << h->get(4).asDouble() << std::setw(10) << h->get(5).asDouble();
+    }
+    if(reader.queryInvalid())
+        oss << std::endl << reader.queryInvalid() << " invalid traces";
+    yInfo() << oss.str();
+
+    if(reportPort.getOutputCount()) {
+        reportPort.prepare() = report;
+        reportPort.write();
+    }
+
+    return !isStopping();
+}